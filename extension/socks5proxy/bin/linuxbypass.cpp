@@ -37,7 +37,7 @@ LinuxBypass::LinuxBypass(Socks5* proxy) : QObject(proxy) {
 
   // If we get this far - we can perform split tunneling.
   connect(proxy, &Socks5::outgoingConnection, this,
-          &LinuxBypass::outgoingConnection);
+          &LinuxBypass::outgoingConnection, Qt::DirectConnection);
 }
 
 void LinuxBypass::outgoingConnection(QAbstractSocket* s,
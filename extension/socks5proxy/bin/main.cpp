@@ -10,12 +10,15 @@
 #include <QStandardPaths>
 #include <QString>
 #include <QTcpServer>
+#include <QThread>
 #include <QTimer>
 
 #include "socks5.h"
 #include "sockslogger.h"
 
 #if defined(PROXY_OS_LINUX)
+#  include <signal.h>
+
 #  include "linuxbypass.h"
 #elif defined(PROXY_OS_WIN)
 #  include "windowsbypass.h"
@@ -31,6 +34,7 @@ struct CliOptions {
   QString password = {};
   bool verbose = false;
   bool logfile = false;
+  int workers = 0;
 #if defined(PROXY_OS_WIN)
   bool service = false;
 #endif
@@ -70,6 +74,11 @@ static CliOptions parseArgs(const QCoreApplication& app) {
   QCommandLineOption verboseOption({"v", "verbose"}, "Verbose");
   parser.addOption(verboseOption);
 
+  QCommandLineOption workersOption(
+      {"w", "workers"},
+      "Number of worker threads (0 to disable, -1 for one per CPU)", "count");
+  parser.addOption(workersOption);
+
 #if defined(PROXY_OS_WIN)
   QCommandLineOption serviceOption({"s", "service"}, "Windows service mode");
   parser.addOption(serviceOption);
@@ -104,6 +113,14 @@ static CliOptions parseArgs(const QCoreApplication& app) {
   if (parser.isSet(verboseOption)) {
     out.verbose = true;
   }
+  if (parser.isSet(workersOption)) {
+    bool ok = false;
+    const int w = parser.value(workersOption).toInt(&ok);
+    if (!ok || w < -1) {
+      qFatal("Worker count is Not Valid");
+    }
+    out.workers = (w < 0) ? QThread::idealThreadCount() : w;
+  }
 #if defined(PROXY_OS_WIN)
   if (parser.isSet(serviceOption)) {
     out.service = true;
@@ -120,6 +137,12 @@ int main(int argc, char** argv) {
   QCoreApplication::setApplicationVersion("0.1");
   auto const config = parseArgs(app);
 
+#if defined(PROXY_OS_LINUX)
+  // Connections are relayed with splice(), which raises SIGPIPE when the
+  // peer has closed. Handle that as EPIPE instead of terminating.
+  signal(SIGPIPE, SIG_IGN);
+#endif
+
   if (!config.username.isEmpty() || !config.password.isEmpty()) {
     // Todo: actually do auth.
     qFatal("AAH NOT IMPLENTED SORRYY");
@@ -181,6 +204,7 @@ int main(int argc, char** argv) {
   }
   QObject::connect(socks5, &Socks5::incomingConnection, logger,
                    &SocksLogger::incomingConnection);
+  socks5->setWorkerCount(config.workers);
 
 #if defined(PROXY_OS_LINUX)
   new LinuxBypass(socks5);
@@ -53,8 +53,12 @@ SocksLogger::~SocksLogger() {
 void SocksLogger::incomingConnection(Socks5Connection* conn) {
   connect(conn, &Socks5Connection::dataSentReceived, this,
           &SocksLogger::dataSentReceived);
-  connect(conn, &Socks5Connection::stateChanged, this,
-          &SocksLogger::connectionStateChanged);
+  // Connections may be serviced by a worker thread. The state is only stable
+  // for as long as the signal is being emitted, so this must be a direct
+  // connection.
+  connect(
+      conn, &Socks5Connection::stateChanged, this,
+      [this, conn]() { connectionStateChanged(conn); }, Qt::DirectConnection);
   connect(conn, &QObject::destroyed, this, [this]() { m_numConnections--; });
 
   m_events.append(
@@ -109,6 +113,7 @@ void SocksLogger::printStatus() {
 
   output.truncate(80);
   while (output.length() < 80) output.append(' ');
+  QMutexLocker lock(&m_statusMutex);
   QTextStream out(stdout);
   out << output << '\r';
 
@@ -132,8 +137,7 @@ QDebug& SocksLogger::printEventStack(QDebug& msg, Socks5Connection* conn) {
   return msg;
 }
 
-void SocksLogger::connectionStateChanged() {
-  Socks5Connection* conn = qobject_cast<Socks5Connection*>(QObject::sender());
+void SocksLogger::connectionStateChanged(Socks5Connection* conn) {
   if (conn->state() == Socks5Connection::Proxy) {
     auto msg = qDebug() << "Connecting" << conn->clientName() << "to";
     printEventStack(msg, conn);
@@ -230,6 +234,7 @@ void SocksLogger::logHandler(QtMsgType type, const QMessageLogContext& ctx,
   if (s_instance->m_verbose || (type != QtMsgType::QtDebugMsg)) {
     // A message logger that plays nicely with the status output.
     // Clears the current line - prints the log message - reprints the status.
+    QMutexLocker lock(&s_instance->m_statusMutex);
     out << QString(80, ' ') << '\r';
     out << msg << "\r\n";
     out << s_instance->m_lastStatus << '\r';
@@ -71,7 +71,7 @@ class SocksLogger final : public QObject {
   static void logHandler(QtMsgType type, const QMessageLogContext& ctx,
                          const QString& msg);
   void dataSentReceived(qint64 sent, qint64 received);
-  void connectionStateChanged();
+  void connectionStateChanged(Socks5Connection* conn);
   void tick();
 
  private:
@@ -90,6 +90,7 @@ class SocksLogger final : public QObject {
   qsizetype m_numConnections = 0;
 
   QTimer m_timer;
+  QMutex m_statusMutex;
   QString m_lastStatus;
 
   BoxcarAverage m_rx_bytes;
@@ -13,6 +13,7 @@
 #include <QAbstractSocket>
 #include <QFileInfo>
 #include <QHostAddress>
+#include <QMutexLocker>
 #include <QScopeGuard>
 #include <QSettings>
 #include <QUuid>
@@ -67,7 +68,7 @@ static void routeChangeCallback(PVOID context, PMIB_IPFORWARD_ROW2 row,
 
 WindowsBypass::WindowsBypass(Socks5* proxy) : QObject(proxy) {
   connect(proxy, &Socks5::outgoingConnection, this,
-          &WindowsBypass::outgoingConnection);
+          &WindowsBypass::outgoingConnection, Qt::DirectConnection);
 
   NotifyIpInterfaceChange(AF_UNSPEC, netChangeCallback, this, false,
                           &m_netChangeHandle);
@@ -89,6 +90,8 @@ void WindowsBypass::outgoingConnection(QAbstractSocket* s,
     // This destination should not require exclusion.
     return;
   }
+  // This may be called from any of the proxy worker threads.
+  QMutexLocker lock(&m_mutex);
   const MIB_IPFORWARD_ROW2* route = lookupRoute(dest);
   if (route == nullptr) {
     // No routing exclusions to apply.
@@ -98,6 +101,7 @@ void WindowsBypass::outgoingConnection(QAbstractSocket* s,
   // Find the accompanying source addresses.
   SOCKADDR_INET source = {0};
   const InterfaceData data = m_interfaceData.value(route->InterfaceLuid.Value);
+  lock.unlock();
   if (dest.protocol() == QAbstractSocket::IPv4Protocol) {
     if (data.ipv4addr.isNull()) {
       return;
@@ -227,12 +231,14 @@ void WindowsBypass::refreshAddresses() {
   }
 
   // Swap the updated table into use.
+  QMutexLocker lock(&m_mutex);
   m_interfaceData.swap(data);
 }
 
 void WindowsBypass::interfaceChanged(quint64 luid) {
   qDebug() << "Interface changed for:" << QString::number(luid, 16);
 
+  QMutexLocker lock(&m_mutex);
   auto i = m_interfaceData.find(luid);
   if (i == m_interfaceData.end()) {
     // Nothing to update.
@@ -328,7 +334,10 @@ void WindowsBypass::updateTable(QVector<MIB_IPFORWARD_ROW2>& table,
                                 int family) {
   // Update the output table on exit.
   QVector<MIB_IPFORWARD_ROW2> update;
-  auto swapGuard = qScopeGuard([&] { table.swap(update); });
+  auto swapGuard = qScopeGuard([&] {
+    QMutexLocker lock(&m_mutex);
+    table.swap(update);
+  });
 
   // Fetch the routing table.
   MIB_IPFORWARD_TABLE2* mib;
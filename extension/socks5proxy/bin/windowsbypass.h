@@ -7,6 +7,7 @@
 
 #include <QHash>
 #include <QHostAddress>
+#include <QMutex>
 #include <QObject>
 #include <QVector>
 
@@ -45,6 +46,8 @@ class WindowsBypass final : public QObject {
     QHostAddress ipv6addr;
   };
 
+  // Guards the tables below, which are read from the proxy worker threads.
+  QMutex m_mutex;
   QHash<quint64, InterfaceData> m_interfaceData;
   QVector<struct _MIB_IPFORWARD_ROW2> m_routeTableIpv4;
   QVector<struct _MIB_IPFORWARD_ROW2> m_routeTableIpv6;
@@ -8,6 +8,7 @@
 #include <QLocalSocket>
 #include <QTcpServer>
 #include <QTcpSocket>
+#include <QThread>
 
 #include "socks5connection.h"
 
@@ -23,7 +24,34 @@ Socks5::Socks5(QTcpServer* server) : QObject(server) {
           [this, server]() { newConnection(server); });
 }
 
-Socks5::~Socks5() { m_shuttingDown = true; }
+Socks5::~Socks5() {
+  m_shuttingDown = true;
+
+  // Stop the workers, any connections they are still serving get destroyed
+  // along with their root object as the threads finish.
+  for (const Worker& worker : m_workers) {
+    worker.thread->quit();
+  }
+  for (const Worker& worker : m_workers) {
+    worker.thread->wait();
+  }
+}
+
+void Socks5::setWorkerCount(int count) {
+  Q_ASSERT(m_workers.isEmpty());
+
+  for (int i = 0; i < count; i++) {
+    QThread* thread = new QThread(this);
+    thread->setObjectName(QString("Socks5 Worker %1").arg(i));
+
+    QObject* root = new QObject();
+    root->moveToThread(thread);
+    connect(thread, &QThread::finished, root, &QObject::deleteLater);
+
+    thread->start();
+    m_workers.append(Worker{thread, root});
+  }
+}
 
 template <typename T>
 void Socks5::newConnection(T* server) {
@@ -39,15 +67,40 @@ void Socks5::newConnection(T* server) {
       newConnection(server);
     });
 
-    connect(con, &Socks5Connection::setupOutSocket, this,
-            [this](QAbstractSocket* s, const QHostAddress& dest) {
-              emit outgoingConnection(s, dest);
-            });
+    // The outbound socket must be configured before the connection carries
+    // on, so this has to run in whichever thread serves the connection.
+    connect(
+        con, &Socks5Connection::setupOutSocket, this,
+        [this](QAbstractSocket* s, const QHostAddress& dest) {
+          emit outgoingConnection(s, dest);
+        },
+        Qt::DirectConnection);
 
     ++m_clientCount;
     emit incomingConnection(con);
     emit connectionsChanged();
+
+    dispatch(socket);
+  }
+}
+
+// Hand the socket, and the connection attached to it, over to the next worker
+// thread. The connection is created on this thread first so that listeners of
+// incomingConnection() can safely connect to it.
+void Socks5::dispatch(QObject* socket) {
+  if (m_workers.isEmpty()) {
+    return;
   }
+
+  const Worker& worker = m_workers.at(m_nextWorker);
+  m_nextWorker = (m_nextWorker + 1) % m_workers.count();
+
+  QObject* root = worker.root;
+  socket->setParent(nullptr);
+  socket->moveToThread(worker.thread);
+  QMetaObject::invokeMethod(
+      root, [root, socket]() { socket->setParent(root); },
+      Qt::QueuedConnection);
 }
 
 void Socks5::clientDismissed() {
@@ -5,6 +5,7 @@
 #ifndef SOCKS5_H
 #define SOCKS5_H
 
+#include <QList>
 #include <QObject>
 
 #include "socks5connection.h"
@@ -13,6 +14,7 @@ class QAbstractSocket;
 class QHostAddress;
 class QLocalServer;
 class QTcpServer;
+class QThread;
 
 class Socks5 final : public QObject {
   Q_OBJECT
@@ -25,6 +27,22 @@ class Socks5 final : public QObject {
 
   uint16_t connections() const { return m_clientCount; }
 
+  /**
+   * @brief Serve connections on a pool of worker threads
+   *
+   * Each worker runs its own event loop, and new connections are handed out
+   * to them in a round-robin fashion. With no workers, connections are
+   * served on the thread that owns the server.
+   *
+   * Signals of a Socks5Connection are emitted from the thread that serves
+   * it. The outgoingConnection() signal must be connected with
+   * Qt::DirectConnection, as the socket has to be set up before returning.
+   *
+   * @param count - the number of worker threads
+   */
+  void setWorkerCount(int count);
+  int workerCount() const { return static_cast<int>(m_workers.count()); }
+
  signals:
   void connectionsChanged();
   void incomingConnection(Socks5Connection* connection);
@@ -34,9 +52,18 @@ class Socks5 final : public QObject {
   void clientDismissed();
   template <typename T>
   void newConnection(T* server);
+  void dispatch(QObject* socket);
 
   uint16_t m_clientCount = 0;
   bool m_shuttingDown = false;
+
+  struct Worker {
+    QThread* thread;
+    // Owns the sockets served by this worker, lives in the worker thread.
+    QObject* root;
+  };
+  QList<Worker> m_workers;
+  qsizetype m_nextWorker = 0;
 };
 
 #endif  // SOCKS5_H
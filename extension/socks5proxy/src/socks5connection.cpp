@@ -6,6 +6,10 @@
 
 #include "socks5.h"
 
+#ifdef Q_OS_LINUX
+#  include "socks5splice.h"
+#endif
+
 #ifdef Q_OS_WIN
 #  include <winsock2.h>
 #  include <ws2ipdef.h>
@@ -319,6 +323,7 @@ void Socks5Connection::readyRead() {
 
     case Proxy:
       proxy(m_inSocket, m_outSocket, m_sendHighWaterMark);
+      maybeStartSplice();
       break;
 
     default:
@@ -345,12 +350,14 @@ void Socks5Connection::bytesWritten(qint64 bytes) {
   // Drive statistics and proxy data.
   emit dataSentReceived(0, bytes);
   proxy(m_inSocket, m_outSocket, m_recvHighWaterMark);
+  maybeStartSplice();
 }
 
 void Socks5Connection::proxy(QIODevice* from, QIODevice* to,
                              quint64& watermark) {
   Q_ASSERT(from && to);
 
+  char buffer[MAX_CONNECTION_BUFFER];
   for (;;) {
     qint64 available = from->bytesAvailable();
     if (available <= 0) {
@@ -362,13 +369,13 @@ void Socks5Connection::proxy(QIODevice* from, QIODevice* to,
       break;
     }
 
-    QByteArray data = from->read(qMin(available, capacity));
-    if (data.length() == 0) {
+    qint64 length = from->read(buffer, qMin(available, capacity));
+    if (length <= 0) {
       break;
     }
-    qint64 sent = to->write(data);
-    if (sent != data.length()) {
-      qDebug() << "Truncated write. Sent" << sent << "of" << data.length();
+    qint64 sent = to->write(buffer, length);
+    if (sent != length) {
+      qDebug() << "Truncated write. Sent" << sent << "of" << length;
       break;
     }
   }
@@ -380,6 +387,51 @@ void Socks5Connection::proxy(QIODevice* from, QIODevice* to,
   }
 }
 
+// Once the negotiation is over and Qt has nothing left buffered in either
+// direction, hand TCP-to-TCP connections over to a splice() relay. This lets
+// the kernel move the payload between the sockets without copying it through
+// userspace.
+void Socks5Connection::maybeStartSplice() {
+#ifdef Q_OS_LINUX
+  if ((m_state != Proxy) || (m_splice != nullptr) || (m_outSocket == nullptr)) {
+    return;
+  }
+  QTcpSocket* inSocket = qobject_cast<QTcpSocket*>(m_inSocket);
+  if (inSocket == nullptr) {
+    return;
+  }
+  if ((inSocket->bytesAvailable() > 0) || (inSocket->bytesToWrite() > 0) ||
+      (m_outSocket->bytesAvailable() > 0) ||
+      (m_outSocket->bytesToWrite() > 0)) {
+    return;
+  }
+
+  m_splice = Socks5Splice::create(inSocket, m_outSocket, this);
+  if (m_splice == nullptr) {
+    return;
+  }
+
+  // The relay owns duplicates of the socket descriptors, so detach the Qt
+  // sockets without letting their teardown close the connection.
+  disconnect(inSocket, nullptr, this, nullptr);
+  disconnect(m_outSocket, nullptr, this, nullptr);
+  inSocket->abort();
+  m_outSocket->abort();
+
+  connect(m_splice, &Socks5Splice::dataSentReceived, this,
+          &Socks5Connection::dataSentReceived);
+  connect(m_splice, &Socks5Splice::finished, this,
+          [this](const QString& errorString) {
+            if (errorString.isEmpty()) {
+              setState(Closed);
+            } else {
+              setError(ErrorGeneral, errorString);
+            }
+          });
+  m_splice->start();
+#endif
+}
+
 void Socks5Connection::dnsResolutionFinished(quint16 port) {
   QDnsLookup* lookup = qobject_cast<QDnsLookup*>(QObject::sender());
 
@@ -476,10 +528,13 @@ void Socks5Connection::configureOutSocket(quint16 port) {
   connect(m_outSocket, &QIODevice::bytesWritten, this, [this](qint64 bytes) {
     emit dataSentReceived(bytes, 0);
     proxy(m_inSocket, m_outSocket, m_sendHighWaterMark);
+    maybeStartSplice();
   });
 
-  connect(m_outSocket, &QTcpSocket::readyRead, this,
-          [this]() { proxy(m_outSocket, m_inSocket, m_recvHighWaterMark); });
+  connect(m_outSocket, &QTcpSocket::readyRead, this, [this]() {
+    proxy(m_outSocket, m_inSocket, m_recvHighWaterMark);
+    maybeStartSplice();
+  });
 
   connect(m_outSocket, &QTcpSocket::disconnected, this,
           [this]() { setState(Closed); });
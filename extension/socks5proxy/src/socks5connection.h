@@ -11,6 +11,8 @@
 #include <QObject>
 #include <QTcpSocket>
 
+class Socks5Splice;
+
 class Socks5Connection final : public QObject {
   Q_OBJECT
 
@@ -25,6 +27,9 @@ class Socks5Connection final : public QObject {
   /**
    * @brief Copies incoming bytes to another QIODevice
    *
+   * The bytes are staged through a buffer on the stack, so that forwarding
+   * data does not allocate.
+   *
    * @param from- the source device
    * @param to- the output device
    * @param watermark- reference to the buffer high watermark
@@ -96,6 +101,7 @@ class Socks5Connection final : public QObject {
   void dnsResolutionFinished(quint16 port);
   void readyRead();
   void bytesWritten(qint64 bytes);
+  void maybeStartSplice();
 
   // Implemented by platform-specific code in socks5local_<platform>.cpp
   static QString localClientName(QLocalSocket* s);
@@ -119,6 +125,9 @@ class Socks5Connection final : public QObject {
   quint64 m_sendHighWaterMark = 0;
   quint64 m_recvHighWaterMark = 0;
   quint64 m_recvIgnoreBytes = 0;
+
+  // Zero-copy relay, once the connection has been handed over to it.
+  Socks5Splice* m_splice = nullptr;
 };
 
 #endif  // Socks5Connection_H
@@ -0,0 +1,84 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef SOCKS5SPLICE_H
+#define SOCKS5SPLICE_H
+
+#include <QObject>
+
+class QSocketNotifier;
+class QTcpSocket;
+
+/**
+ * @brief Zero-copy relay between two TCP sockets
+ *
+ * Moves data between the sockets with splice() through a pair of pipes, so
+ * the payload never leaves the kernel. Only available on Linux.
+ *
+ * splice() can't be told not to raise SIGPIPE, so the process must ignore
+ * that signal before any relay is started.
+ */
+class Socks5Splice final : public QObject {
+  Q_OBJECT
+
+ public:
+  /**
+   * @brief Take over the file descriptors of two connected sockets
+   *
+   * The descriptors are duplicated, the caller is expected to abort() the
+   * Qt sockets afterwards without closing the underlying connection. Any
+   * data buffered by Qt must have been flushed beforehand.
+   *
+   * @param client - the inbound socket from the SOCKS client
+   * @param remote - the outbound socket to the destination
+   * @param parent - the QObject parent
+   * @return Socks5Splice* - the relay, or nullptr if it can't be set up.
+   */
+  static Socks5Splice* create(QTcpSocket* client, QTcpSocket* remote,
+                              QObject* parent);
+  ~Socks5Splice();
+
+  /**
+   * @brief Start relaying data in both directions
+   */
+  void start();
+
+ signals:
+  void dataSentReceived(qint64 sent, qint64 received);
+
+  /**
+   * @brief Emitted once both directions are shut down
+   *
+   * @param errorString - empty if the connection closed gracefully.
+   */
+  void finished(const QString& errorString);
+
+ private:
+  explicit Socks5Splice(QObject* parent);
+
+  struct Direction {
+    int rxfd = -1;
+    int txfd = -1;
+    int pipe[2] = {-1, -1};
+    qint64 queued = 0;
+    bool eof = false;
+    bool shutdown = false;
+    bool upstream = false;
+    QSocketNotifier* rxNotifier = nullptr;
+    QSocketNotifier* txNotifier = nullptr;
+  };
+
+  void pump(Direction& dir);
+  void fail(int error);
+  void stop(const QString& errorString);
+
+  int m_clientfd = -1;
+  int m_remotefd = -1;
+  bool m_finished = false;
+
+  Direction m_upstream;
+  Direction m_downstream;
+};
+
+#endif  // SOCKS5SPLICE_H
@@ -0,0 +1,168 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <QDebug>
+#include <QSocketNotifier>
+#include <QTcpSocket>
+
+#include "socks5splice.h"
+
+// Capacity of each pipe, this is also the default pipe size on Linux.
+constexpr const qint64 SPLICE_PIPE_SIZE = 64 * 1024;
+
+// Upper bound on the number of splice() round trips per notification, so
+// that a single busy connection can't starve the event loop.
+constexpr const int SPLICE_MAX_ITERATIONS = 16;
+
+constexpr const unsigned int SPLICE_FLAGS = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+
+static void closePipe(int pipefd[2]) {
+  for (int i = 0; i < 2; i++) {
+    if (pipefd[i] >= 0) {
+      close(pipefd[i]);
+      pipefd[i] = -1;
+    }
+  }
+}
+
+Socks5Splice::Socks5Splice(QObject* parent) : QObject(parent) {}
+
+Socks5Splice::~Socks5Splice() {
+  closePipe(m_upstream.pipe);
+  closePipe(m_downstream.pipe);
+  if (m_clientfd >= 0) {
+    close(m_clientfd);
+  }
+  if (m_remotefd >= 0) {
+    close(m_remotefd);
+  }
+}
+
+// static
+Socks5Splice* Socks5Splice::create(QTcpSocket* client, QTcpSocket* remote,
+                                   QObject* parent) {
+  Q_ASSERT(client && remote);
+  if ((client->socketDescriptor() < 0) || (remote->socketDescriptor() < 0)) {
+    return nullptr;
+  }
+
+  auto* relay = new Socks5Splice(parent);
+  relay->m_clientfd = fcntl(client->socketDescriptor(), F_DUPFD_CLOEXEC, 0);
+  relay->m_remotefd = fcntl(remote->socketDescriptor(), F_DUPFD_CLOEXEC, 0);
+  if ((relay->m_clientfd < 0) || (relay->m_remotefd < 0) ||
+      (pipe2(relay->m_upstream.pipe, O_NONBLOCK | O_CLOEXEC) != 0) ||
+      (pipe2(relay->m_downstream.pipe, O_NONBLOCK | O_CLOEXEC) != 0)) {
+    qWarning() << "Unable to setup splice relay:" << strerror(errno);
+    delete relay;
+    return nullptr;
+  }
+
+  relay->m_upstream.rxfd = relay->m_clientfd;
+  relay->m_upstream.txfd = relay->m_remotefd;
+  relay->m_upstream.upstream = true;
+  relay->m_downstream.rxfd = relay->m_remotefd;
+  relay->m_downstream.txfd = relay->m_clientfd;
+
+  for (Direction* dir : {&relay->m_upstream, &relay->m_downstream}) {
+    dir->rxNotifier =
+        new QSocketNotifier(dir->rxfd, QSocketNotifier::Read, relay);
+    dir->txNotifier =
+        new QSocketNotifier(dir->txfd, QSocketNotifier::Write, relay);
+    dir->rxNotifier->setEnabled(false);
+    dir->txNotifier->setEnabled(false);
+    connect(dir->rxNotifier, &QSocketNotifier::activated, relay,
+            [relay, dir]() { relay->pump(*dir); });
+    connect(dir->txNotifier, &QSocketNotifier::activated, relay,
+            [relay, dir]() { relay->pump(*dir); });
+  }
+
+  return relay;
+}
+
+void Socks5Splice::start() {
+  pump(m_upstream);
+  pump(m_downstream);
+}
+
+void Socks5Splice::pump(Direction& dir) {
+  if (m_finished) {
+    return;
+  }
+
+  for (int i = 0; i < SPLICE_MAX_ITERATIONS; i++) {
+    // Fill the pipe from the receiving socket.
+    if (!dir.eof && (dir.queued < SPLICE_PIPE_SIZE)) {
+      ssize_t rc = splice(dir.rxfd, nullptr, dir.pipe[1], nullptr,
+                          SPLICE_PIPE_SIZE - dir.queued, SPLICE_FLAGS);
+      if (rc > 0) {
+        dir.queued += rc;
+      } else if (rc == 0) {
+        dir.eof = true;
+      } else if (errno != EAGAIN) {
+        fail(errno);
+        return;
+      }
+    }
+    if (dir.queued == 0) {
+      break;
+    }
+
+    // Drain the pipe into the transmitting socket.
+    ssize_t rc = splice(dir.pipe[0], nullptr, dir.txfd, nullptr, dir.queued,
+                        SPLICE_FLAGS);
+    if (rc < 0) {
+      if (errno == EPIPE) {
+        // The peer has gone away, there is nobody left to relay to.
+        stop(QString());
+        return;
+      }
+      if (errno != EAGAIN) {
+        fail(errno);
+        return;
+      }
+      break;
+    }
+    dir.queued -= rc;
+    if (dir.upstream) {
+      emit dataSentReceived(rc, 0);
+    } else {
+      emit dataSentReceived(0, rc);
+    }
+  }
+
+  // Half-close the transmitting socket once the receiver has reached EOF
+  // and everything has been flushed out of the pipe.
+  if (dir.eof && (dir.queued == 0) && !dir.shutdown) {
+    ::shutdown(dir.txfd, SHUT_WR);
+    dir.shutdown = true;
+  }
+
+  dir.rxNotifier->setEnabled(!dir.eof && (dir.queued < SPLICE_PIPE_SIZE));
+  dir.txNotifier->setEnabled(dir.queued > 0);
+
+  if (m_upstream.shutdown && m_downstream.shutdown) {
+    m_finished = true;
+    emit finished(QString());
+  }
+}
+
+void Socks5Splice::fail(int error) {
+  stop(QString::fromLocal8Bit(strerror(error)));
+}
+
+void Socks5Splice::stop(const QString& errorString) {
+  for (Direction* dir : {&m_upstream, &m_downstream}) {
+    dir->rxNotifier->setEnabled(false);
+    dir->txNotifier->setEnabled(false);
+  }
+
+  m_finished = true;
+  emit finished(errorString);
+}
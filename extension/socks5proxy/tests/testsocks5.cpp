@@ -4,7 +4,12 @@
 
 #include "testsocks5.h"
 
+#ifdef Q_OS_LINUX
+#  include <signal.h>
+#endif
+
 #include <QBuffer>
+#include <QElapsedTimer>
 #include <QEventLoop>
 #include <QFileInfo>
 #include <QFuture>
@@ -82,6 +87,20 @@ QFuture<QByteArray> connectTo(uint serverPort, quint16 proxyPort) {
 };
 #pragma endregion
 
+void TestSocks5::initTestCase() {
+#ifdef Q_OS_LINUX
+  // Like the proxy daemon, don't let the splice() relay raise SIGPIPE.
+  signal(SIGPIPE, SIG_IGN);
+#endif
+}
+
+void TestSocks5::proxyTCP_data() {
+  QTest::addColumn<int>("workers");
+
+  QTest::newRow("main thread") << 0;
+  QTest::newRow("worker threads") << 2;
+}
+
 /**
  * Create a TCP Server -  Sending "Hello Moto"
  * to the first incoming connection.
@@ -92,6 +111,7 @@ QFuture<QByteArray> connectTo(uint serverPort, quint16 proxyPort) {
  *
  */
 void TestSocks5::proxyTCP() {
+  QFETCH(int, workers);
   auto const proxyPort = rollPort();
   auto const serverPort = rollPort();
   auto const serverHadConnection = makeServer(serverPort);
@@ -99,6 +119,8 @@ void TestSocks5::proxyTCP() {
   // Create a TCP Server and connect the proxy to it.
   QTcpServer proxyServer;
   Socks5 proxy(&proxyServer);
+  proxy.setWorkerCount(workers);
+  QCOMPARE(proxy.workerCount(), workers);
   proxyServer.listen(QHostAddress::LocalHost, proxyPort);
 
   QFuture<std::tuple<qint64, qint64>> proxyHadData;
@@ -127,4 +149,60 @@ void TestSocks5::proxyTCP() {
   QCOMPARE(connectionToServer.result(), QByteArray{testData});
 }
 
+/**
+ * Stream a large payload from a TCP server through the proxy, and report the
+ * throughput of the relay. This takes a while, so it only runs when
+ * MZ_BENCHMARK is set in the environment.
+ */
+void TestSocks5::proxyThroughput() {
+  if (qEnvironmentVariableIsEmpty("MZ_BENCHMARK")) {
+    QSKIP("Set MZ_BENCHMARK to measure the proxy throughput");
+  }
+
+  constexpr const qint64 PAYLOAD_SIZE = 256 * 1024 * 1024;
+  const QByteArray chunk(64 * 1024, 'x');
+
+  QTcpServer proxyServer;
+  Socks5 proxy(&proxyServer);
+  QVERIFY(proxyServer.listen(QHostAddress::LocalHost));
+
+  // The server writes the payload as fast as the socket drains.
+  QTcpServer server;
+  QVERIFY(server.listen(QHostAddress::LocalHost));
+  QObject::connect(&server, &QTcpServer::newConnection, [&]() {
+    QTcpSocket* connection = server.nextPendingConnection();
+    auto remaining = std::make_shared<qint64>(PAYLOAD_SIZE);
+    auto fill = [connection, remaining, &chunk]() {
+      while ((*remaining > 0) && (connection->bytesToWrite() < chunk.size())) {
+        qint64 length = qMin<qint64>(*remaining, chunk.size());
+        connection->write(chunk.constData(), length);
+        *remaining -= length;
+      }
+      if (*remaining == 0) {
+        connection->disconnectFromHost();
+      }
+    };
+    QObject::connect(connection, &QTcpSocket::bytesWritten, connection, fill);
+    fill();
+  });
+
+  QTcpSocket client;
+  client.setProxy(QNetworkProxy{QNetworkProxy::ProxyType::Socks5Proxy,
+                                "localhost", proxyServer.serverPort()});
+  qint64 received = 0;
+  QObject::connect(&client, &QTcpSocket::readyRead,
+                   [&]() { received += client.readAll().size(); });
+
+  QElapsedTimer timer;
+  QBENCHMARK_ONCE {
+    timer.start();
+    client.connectToHost(QHostAddress::LocalHost, server.serverPort());
+    QTRY_COMPARE_WITH_TIMEOUT(received, PAYLOAD_SIZE, 60000);
+  }
+
+  qint64 elapsed = qMax<qint64>(timer.elapsed(), 1);
+  qInfo() << "Proxy throughput:"
+          << (PAYLOAD_SIZE * 8 / 1000 / elapsed) << "Mbit/s";
+}
+
 QTEST_MAIN(TestSocks5)
@@ -11,5 +11,8 @@ class TestSocks5 final : public QObject {
   Q_OBJECT
 
  private slots:
+  void initTestCase();
+  void proxyTCP_data();
   void proxyTCP();
+  void proxyThroughput();
 };
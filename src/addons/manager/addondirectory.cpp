@@ -5,13 +5,24 @@
 #include "addondirectory.h"
 
 #include <QByteArray>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QSaveFile>
 #include <QStandardPaths>
 #include <QString>
+#include <QThreadPool>
+
+#ifdef Q_OS_UNIX
+#  include <sys/stat.h>
+#endif
 
 #include "leakdetector.h"
 #include "logger.h"
+#include "settingsholder.h"
 
 namespace {
 Logger logger("AddonDirectory");
@@ -26,6 +37,70 @@ QString rootAppFolder() {
   return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
 #endif
 }
+
+// What identifies the content of a file without reading it.
+QJsonObject fileStamp(const QString& filePath) {
+  QFileInfo info(filePath);
+  if (!info.exists()) {
+    return QJsonObject();
+  }
+
+  QJsonObject stamp;
+  stamp["size"] = info.size();
+  stamp["mtime"] = info.lastModified().toMSecsSinceEpoch();
+
+#ifdef Q_OS_UNIX
+  struct stat st;
+  if (stat(QFile::encodeName(filePath).constData(), &st) == 0) {
+    stamp["inode"] = QString::number(st.st_ino);
+  }
+#endif
+
+  return stamp;
+}
+
+QByteArray hashFile(const QString& filePath) {
+  QFile file(filePath);
+  if (!file.open(QIODevice::ReadOnly)) {
+    logger.warning() << "Unable to open file:" << file.fileName() << "\n"
+                     << file.errorString();
+    return QByteArray();
+  }
+
+  QCryptographicHash hash(QCryptographicHash::Sha256);
+
+  // Empty files can't be mapped.
+  const qint64 size = file.size();
+  uchar* data = size > 0 ? file.map(0, size) : nullptr;
+  if (data) {
+    hash.addData(QByteArray::fromRawData(reinterpret_cast<const char*>(data),
+                                         static_cast<qsizetype>(size)));
+    file.unmap(data);
+  } else if (!hash.addData(&file)) {
+    return QByteArray();
+  }
+
+  return hash.result();
+}
+
+QJsonObject readHashCache() {
+  SettingsHolder* settingsHolder = SettingsHolder::instance();
+  if (!settingsHolder) {
+    return QJsonObject();
+  }
+
+  return QJsonDocument::fromJson(settingsHolder->addonHashCache()).object();
+}
+
+void writeHashCache(const QJsonObject& cache) {
+  SettingsHolder* settingsHolder = SettingsHolder::instance();
+  if (!settingsHolder) {
+    return;
+  }
+
+  settingsHolder->setAddonHashCache(
+      QJsonDocument(cache).toJson(QJsonDocument::Compact));
+}
 }  // namespace
 
 AddonDirectory::AddonDirectory() {
@@ -142,4 +217,124 @@ void AddonDirectory::reset() {
     // This comment is here to make the linter happy.
     dir.remove(dirFile);
   }
+
+  SettingsHolder* settingsHolder = SettingsHolder::instance();
+  if (settingsHolder) {
+    settingsHolder->removeAddonHashCache();
+  }
+}
+
+// static
+QSet<QString> AddonDirectory::verifyFiles(
+    const QHash<QString, QByteArray>& hashes) {
+  QSet<QString> verified;
+
+  QDir dir;
+  if (hashes.isEmpty() || !getDirectory(&dir)) {
+    return verified;
+  }
+
+  QJsonObject cache = readHashCache();
+  bool cacheChanged = false;
+
+  struct Job {
+    QString m_fileName;
+    QString m_filePath;
+    QJsonObject m_stamp;
+    QByteArray m_sha256;
+  };
+  QList<Job> jobs;
+
+  for (auto i = hashes.constBegin(); i != hashes.constEnd(); ++i) {
+    QString filePath = dir.filePath(i.key());
+    QJsonObject stamp = fileStamp(filePath);
+    if (stamp.isEmpty()) {
+      logger.info() << "File" << filePath << "does not exist yet";
+      continue;
+    }
+
+    // Same file, already verified against the same hash.
+    QJsonObject entry = cache.value(i.key()).toObject();
+    if (entry.value("sha256").toString() ==
+        QString::fromLatin1(i.value().toHex())) {
+      entry.remove("sha256");
+      if (entry == stamp) {
+        verified.insert(i.key());
+        continue;
+      }
+    }
+
+    jobs.append({i.key(), filePath, stamp, QByteArray()});
+  }
+
+  if (!jobs.isEmpty()) {
+#ifdef MZ_WASM
+    for (Job& job : jobs) {
+      job.m_sha256 = hashFile(job.m_filePath);
+    }
+#else
+    // Each job only writes to its own entry, and the list isn't resized
+    // until the pool is done.
+    QThreadPool pool;
+    for (Job& job : jobs) {
+      Job* jobPtr = &job;
+      pool.start(
+          [jobPtr]() { jobPtr->m_sha256 = hashFile(jobPtr->m_filePath); });
+    }
+    pool.waitForDone();
+#endif
+  }
+
+  for (const Job& job : jobs) {
+    if (job.m_sha256.isEmpty() ||
+        job.m_sha256 != hashes.value(job.m_fileName)) {
+      logger.warning() << "Hash does not match for file" << job.m_fileName;
+      if (cache.contains(job.m_fileName)) {
+        cache.remove(job.m_fileName);
+        cacheChanged = true;
+      }
+      continue;
+    }
+
+    verified.insert(job.m_fileName);
+
+    QJsonObject entry = job.m_stamp;
+    entry["sha256"] = QString::fromLatin1(job.m_sha256.toHex());
+    cache[job.m_fileName] = entry;
+    cacheChanged = true;
+  }
+
+  if (cacheChanged) {
+    writeHashCache(cache);
+  }
+
+  return verified;
+}
+
+// static
+void AddonDirectory::storeVerifiedHash(const QString& fileName,
+                                       const QByteArray& sha256) {
+  QDir dir;
+  if (!getDirectory(&dir)) {
+    return;
+  }
+
+  QJsonObject entry = fileStamp(dir.filePath(fileName));
+  if (entry.isEmpty()) {
+    return;
+  }
+  entry["sha256"] = QString::fromLatin1(sha256.toHex());
+
+  QJsonObject cache = readHashCache();
+  cache[fileName] = entry;
+  writeHashCache(cache);
+}
+
+// static
+void AddonDirectory::removeVerifiedHash(const QString& fileName) {
+  QJsonObject cache = readHashCache();
+  if (cache.contains(fileName)) {
+    cache.remove(fileName);
+    writeHashCache(cache);
+  }
 }
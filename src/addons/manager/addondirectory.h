@@ -5,7 +5,9 @@
 #ifndef ADDONDIRECTORY_H
 #define ADDONDIRECTORY_H
 
+#include <QHash>
 #include <QObject>
+#include <QSet>
 
 class QString;
 class QByteArray;
@@ -24,6 +26,21 @@ class AddonDirectory final {
   static bool writeToFile(const QString& fileName, const QByteArray& contents);
   static bool deleteFile(const QString& fileName);
 
+  /**
+   * Checks the SHA256 of each file against the expected one, and returns the
+   * names of the files which match. Files are hashed in parallel, and only if
+   * their size, mtime or inode changed since they were last verified. The
+   * hashes already verified are kept in the settings.
+   */
+  static QSet<QString> verifyFiles(const QHash<QString, QByteArray>& hashes);
+
+  // Records the SHA256 of a file which has just been written and checked.
+  static void storeVerifiedHash(const QString& fileName,
+                                const QByteArray& sha256);
+
+  // Forgets the SHA256 of a file which has been removed.
+  static void removeVerifiedHash(const QString& fileName);
+
   static void reset();
 };
 
@@ -120,12 +120,24 @@ void AddonManager::updateAddonsList(bool status, QList<AddonData> addons) {
     removeAddon(addonId);
   }
 
+  // Verify the new addons all at once, so that their files can be hashed in
+  // parallel.
+  QHash<QString, QByteArray> hashes;
+  for (const AddonData& addonData : addons) {
+    if (!m_addons.contains(addonData.m_addonId)) {
+      hashes.insert(addonFileName(addonData.m_addonId), addonData.m_sha256);
+    }
+  }
+  QSet<QString> verifiedFiles = m_addonDirectory.verifyFiles(hashes);
+
   bool taskAdded = false;
 
   // Fetch new addons
   for (const AddonData& addonData : addons) {
     if (!m_addons.contains(addonData.m_addonId) &&
-        validateAndLoad(addonData.m_addonId, addonData.m_sha256)) {
+        validateAndLoad(
+            addonData.m_addonId, addonData.m_sha256,
+            verifiedFiles.contains(addonFileName(addonData.m_addonId)))) {
       continue;
     }
 
@@ -139,8 +151,8 @@ void AddonManager::updateAddonsList(bool status, QList<AddonData> addons) {
   }
 
   if (taskAdded) {
-    TaskScheduler::scheduleTask(
-        new TaskFunction([this]() { loadCompleted(); }, Task::Reschedulable));
+    TaskScheduler::scheduleTask(new TaskFunction(
+        [this]() { loadCompleted(); }, Task::Reschedulable, "addons"));
   } else {
     loadCompleted();
   }
@@ -206,8 +218,7 @@ void AddonManager::unload(const QString& addonId) {
 
     QDir dir;
     if (m_addonDirectory.getDirectory(&dir)) {
-      QString addonFileName(QString("%1.rcc").arg(addonId));
-      QString addonFilePath(dir.filePath(addonFileName));
+      QString addonFilePath(dir.filePath(addonFileName(addonId)));
       QResource::unregisterResource(addonFilePath, mountPath(addonId));
     }
 
@@ -229,12 +240,14 @@ void AddonManager::retranslate() {
 
 // static
 void AddonManager::removeAddon(const QString& addonId) {
-  QString addonFileName(QString("%1.rcc").arg(addonId));
-  instance()->m_addonDirectory.deleteFile(addonFileName);
+  const QString fileName = addonFileName(addonId);
+  instance()->m_addonDirectory.deleteFile(fileName);
+  AddonDirectory::removeVerifiedHash(fileName);
 }
 
 bool AddonManager::validateAndLoad(const QString& addonId,
-                                   const QByteArray& sha256, bool checkSha256) {
+                                   const QByteArray& sha256,
+                                   bool sha256Verified) {
   logger.debug() << "Load addon" << addonId;
 
   if (m_addons.contains(addonId)) {
@@ -244,27 +257,15 @@ bool AddonManager::validateAndLoad(const QString& addonId,
 
   m_addons.insert(addonId, {QByteArray(), addonId, nullptr});
 
-  QString addonFileName(QString("%1.rcc").arg(addonId));
-
   QDir dir;
   if (!m_addonDirectory.getDirectory(&dir)) {
     return false;
   }
-  QString addonFilePath(dir.filePath(addonFileName));
-
-  // Hash validation
-  if (checkSha256) {
-    QByteArray addonFileContents;
-
-    if (!m_addonDirectory.readFile(addonFileName, &addonFileContents)) {
-      return false;
-    }
+  QString addonFilePath(dir.filePath(addonFileName(addonId)));
 
-    if (QCryptographicHash::hash(addonFileContents,
-                                 QCryptographicHash::Sha256) != sha256) {
-      logger.warning() << "Addon hash does not match" << addonId;
-      return false;
-    }
+  if (!sha256Verified) {
+    logger.warning() << "Addon hash not verified" << addonId;
+    return false;
   }
 
   m_addons[addonId].m_sha256 = sha256;
@@ -301,12 +302,14 @@ void AddonManager::storeAndLoadAddon(const QByteArray& addonData,
     return;
   }
 
-  QString addonFileName(QString("%1.rcc").arg(addonId));
-  if (!m_addonDirectory.writeToFile(addonFileName, addonData)) {
+  if (!m_addonDirectory.writeToFile(addonFileName(addonId), addonData)) {
     return;
   }
 
-  if (!validateAndLoad(addonId, sha256, false)) {
+  // The data has just been hashed, the next launch doesn't need to.
+  m_addonDirectory.storeVerifiedHash(addonFileName(addonId), sha256);
+
+  if (!validateAndLoad(addonId, sha256, true)) {
     logger.warning() << "Unable to load the addon";
   }
 }
@@ -430,6 +433,11 @@ void AddonManager::reinstateMessages() const {
   messageSettingGroup->remove();
 }
 
+// static
+QString AddonManager::addonFileName(const QString& addonId) {
+  return QString("%1.rcc").arg(addonId);
+}
+
 // static
 QString AddonManager::mountPath(const QString& addonId) {
   return QString("/addons/%1").arg(addonId);
@@ -78,10 +78,11 @@ class AddonManager final : public QAbstractListModel {
   void refreshAddons();
 
   bool validateAndLoad(const QString& addonId, const QByteArray& sha256,
-                       bool checkSha256 = true);
+                       bool sha256Verified);
 
   static void removeAddon(const QString& addonId);
 
+  static QString addonFileName(const QString& addonId);
   static QString mountPath(const QString& addonId);
 
   bool loadManifest(const QString& addonManifestFileName);
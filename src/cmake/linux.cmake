@@ -16,6 +16,10 @@ target_sources(mozillavpn PRIVATE
     ${CMAKE_SOURCE_DIR}/src/platforms/linux/linuxappimageprovider.h
     ${CMAKE_SOURCE_DIR}/src/platforms/linux/linuxapplistprovider.cpp
     ${CMAKE_SOURCE_DIR}/src/platforms/linux/linuxapplistprovider.h
+    ${CMAKE_SOURCE_DIR}/src/platforms/linux/linuxdesktopentrycatalog.cpp
+    ${CMAKE_SOURCE_DIR}/src/platforms/linux/linuxdesktopentrycatalog.h
+    ${CMAKE_SOURCE_DIR}/src/platforms/linux/linuxdesktopentrycatalogworker.cpp
+    ${CMAKE_SOURCE_DIR}/src/platforms/linux/linuxdesktopentrycatalogworker.h
     ${CMAKE_SOURCE_DIR}/src/platforms/linux/linuxnetworkwatcher.cpp
     ${CMAKE_SOURCE_DIR}/src/platforms/linux/linuxnetworkwatcher.h
     ${CMAKE_SOURCE_DIR}/src/platforms/linux/linuxnetworkwatcherworker.cpp
@@ -122,6 +122,8 @@ target_sources(shared-sources INTERFACE
     ${CMAKE_SOURCE_DIR}/src/inspector/inspectorwebsocketserver.h
     ${CMAKE_SOURCE_DIR}/src/ipaddress.cpp
     ${CMAKE_SOURCE_DIR}/src/ipaddress.h
+    ${CMAKE_SOURCE_DIR}/src/iprangeset.cpp
+    ${CMAKE_SOURCE_DIR}/src/iprangeset.h
     ${CMAKE_SOURCE_DIR}/src/itempicker.cpp
     ${CMAKE_SOURCE_DIR}/src/itempicker.h
     ${CMAKE_SOURCE_DIR}/src/leakdetector.cpp
@@ -144,6 +146,10 @@ target_sources(shared-sources INTERFACE
     ${CMAKE_SOURCE_DIR}/src/networkmanager.h
     ${CMAKE_SOURCE_DIR}/src/networkrequest.cpp
     ${CMAKE_SOURCE_DIR}/src/networkrequest.h
+    ${CMAKE_SOURCE_DIR}/src/networkresponsecache.cpp
+    ${CMAKE_SOURCE_DIR}/src/networkresponsecache.h
+    ${CMAKE_SOURCE_DIR}/src/profiler.cpp
+    ${CMAKE_SOURCE_DIR}/src/profiler.h
     ${CMAKE_SOURCE_DIR}/src/qmlengineholder.cpp
     ${CMAKE_SOURCE_DIR}/src/qmlengineholder.h
     ${CMAKE_SOURCE_DIR}/src/qmlpath.cpp
@@ -83,7 +83,10 @@ target_sources(mozillavpn-sources INTERFACE
     ${CMAKE_CURRENT_SOURCE_DIR}/daemon/daemonlocalserverconnection.h
     ${CMAKE_CURRENT_SOURCE_DIR}/daemon/daemonaccesscontrol.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/daemon/daemonaccesscontrol.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/daemon/daemonframing.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/daemon/daemonframing.h
     ${CMAKE_CURRENT_SOURCE_DIR}/daemon/dnsutils.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/daemon/handshakebackoff.h
     ${CMAKE_CURRENT_SOURCE_DIR}/daemon/iputils.h
     ${CMAKE_CURRENT_SOURCE_DIR}/daemon/wireguardutils.h
     ${CMAKE_CURRENT_SOURCE_DIR}/daemon/mock/dnsutilsmock.cpp
@@ -105,6 +108,8 @@ target_sources(mozillavpn-sources INTERFACE
     ${CMAKE_CURRENT_SOURCE_DIR}/interfaceconfig.h
     ${CMAKE_CURRENT_SOURCE_DIR}/ipaddresslookup.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/ipaddresslookup.h
+    ${CMAKE_CURRENT_SOURCE_DIR}/jsonstreamreader.cpp
+    ${CMAKE_CURRENT_SOURCE_DIR}/jsonstreamreader.h
     ${CMAKE_CURRENT_SOURCE_DIR}/keyregenerator.cpp
     ${CMAKE_CURRENT_SOURCE_DIR}/keyregenerator.h
     ${CMAKE_CURRENT_SOURCE_DIR}/localsocketcontroller.cpp
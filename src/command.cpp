@@ -48,9 +48,22 @@
 #include <QApplication>
 #include <QIcon>
 #include <QTextStream>
+#include <algorithm>
 
 namespace {
 Logger logger("Command");
+
+void applyLogLevel(SettingsHolder* settingsHolder) {
+  auto apply = [settingsHolder]() {
+    int level = std::clamp(settingsHolder->logLevel(), static_cast<int>(Trace),
+                           static_cast<int>(Error));
+    Logger::setMinLevel(static_cast<LogLevel>(level));
+  };
+
+  apply();
+  QObject::connect(settingsHolder, &SettingsHolder::logLevelChanged,
+                   settingsHolder, apply);
+}
 }  // namespace
 
 QVector<std::function<Command*(QObject*)>> Command::s_commandCreators;
@@ -115,6 +128,8 @@ int Command::runCommandLineApp(std::function<int()>&& a_callback) {
     LogHandler::setStderr(true);
   }
 
+  applyLogLevel(&settingsHolder);
+
   MZGlean::registerLogHandler(LogHandler::rustMessageHandler);
   qInstallMessageHandler(LogHandler::messageQTHandler);
 
@@ -143,6 +158,8 @@ int Command::runGuiApp(std::function<int()>&& a_callback) {
     LogHandler::setStderr(true);
   }
 
+  applyLogLevel(&settingsHolder);
+
   MZGlean::registerLogHandler(LogHandler::rustMessageHandler);
   qInstallMessageHandler(LogHandler::messageQTHandler);
 
@@ -178,6 +195,8 @@ int Command::runQmlApp(std::function<int()>&& a_callback) {
     LogHandler::setStderr(true);
   }
 
+  applyLogLevel(&settingsHolder);
+
   MZGlean::registerLogHandler(LogHandler::rustMessageHandler);
   qInstallMessageHandler(LogHandler::messageQTHandler);
 
@@ -29,6 +29,7 @@
 #include "models/servercountrymodel.h"
 #include "mozillavpn.h"
 #include "notificationhandler.h"
+#include "profiler.h"
 #include "qmlengineholder.h"
 #include "settingsholder.h"
 #include "telemetry.h"
@@ -130,6 +131,8 @@ int CommandUI::run(QStringList& tokens) {
     LogHandler::setStderr(true);
   }
 
+  LogHandler::setAsynchronous();
+
   return runQmlApp([&]() {
     Telemetry::startTimeToFirstScreenTimer();
 
@@ -312,7 +315,10 @@ int CommandUI::run(QStringList& tokens) {
 
     // Here is the main QML file.
     const QUrl url(QStringLiteral("qrc:/qt/qml/Mozilla/VPN/main.qml"));
-    engine->load(url);
+    {
+      MZ_PROFILE_SCOPE("qml", "main.qml");
+      engine->load(url);
+    }
     if (!engineHolder.hasWindow()) {
       logger.error() << "Failed to load " << url.toString();
       return -1;
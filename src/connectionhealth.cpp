@@ -227,7 +227,7 @@ void ConnectionHealth::connectionStateChanged() {
 
 void ConnectionHealth::pingSentAndReceived(qint64 msec) {
 #ifdef MZ_DEBUG
-  logger.debug() << "Ping answer received in msec:" << msec;
+  MZ_LOG(logger, Debug) << "Ping answer received in msec:" << msec;
 #else
   Q_UNUSED(msec);
 #endif
@@ -245,7 +245,7 @@ void ConnectionHealth::dnsPingReceived(quint16 sequence) {
     return;
   }
   quint64 latency = QDateTime::currentMSecsSinceEpoch() - m_dnsPingTimestamp;
-  logger.debug() << "Received DNS ping:" << latency << "msec";
+  MZ_LOG(logger, Debug) << "Received DNS ping:" << latency << "msec";
   updateDnsPingLatency(latency);
 }
 
@@ -5,6 +5,8 @@
 #include "controller.h"
 
 #include <QFileInfo>
+#include <QJsonObject>
+#include <QMetaEnum>
 #include <QNetworkInformation>
 
 #include "app.h"
@@ -24,6 +26,7 @@
 #include "mozillavpn.h"
 #include "networkrequest.h"
 #include "networkwatcher.h"
+#include "profiler.h"
 #include "rfc/rfc1112.h"
 #include "rfc/rfc1918.h"
 #include "rfc/rfc4193.h"
@@ -374,7 +377,7 @@ void Controller::activateInternal(
     DNSPortPolicy dnsPort,
     ServerSelectionPolicy serverSelectionPolicy = RandomizeServerSelection,
     ActivationPrincipal initiator = ClientUser) {
-  logger.debug() << "Activation internal";
+  MZ_LOG(logger, Debug) << "Activation internal";
   Q_ASSERT(m_impl);
   m_initiator = initiator;
 
@@ -422,7 +425,7 @@ void Controller::activateInternal(
 #if defined(MZ_ANDROID) || defined(MZ_IOS)
   exitConfig.m_installationId = settingsHolder->installationId();
 #endif
-  logger.debug() << "DNS Set" << exitConfig.m_dnsServer;
+  MZ_LOG(logger, Debug) << "DNS Set" << exitConfig.m_dnsServer;
 
   // Splittunnel-feature could have been disabled due to a driver conflict.
   if (Feature::get(Feature::Feature_splitTunnel)->isSupported()) {
@@ -540,14 +543,14 @@ Controller::IPAddressList Controller::getExcludedIPAddressRanges() {
   QList<IPAddress> excludeIPv6s;
 
   // filtering out the RFC1918 local area network
-  logger.debug() << "Filtering out the local area networks (rfc 1918)";
+  MZ_LOG(logger, Debug) << "Filtering out the local area networks (rfc 1918)";
   excludeIPv4s.append(RFC1918::ipv4());
 
-  logger.debug() << "Filtering out the local area networks";
+  MZ_LOG(logger, Debug) << "Filtering out the local area networks";
   excludeIPv6s.append(RFC4193::ipv6());
   excludeIPv6s.append(RFC4291::ipv6LinkLocalAddressBlock());
 
-  logger.debug() << "Filtering out multicast addresses";
+  MZ_LOG(logger, Debug) << "Filtering out multicast addresses";
   excludeIPv4s.append(RFC1112::ipv4MulticastAddressBlock());
   excludeIPv6s.append(RFC4291::ipv6MulticastAddressBlock());
 
@@ -560,21 +563,23 @@ Controller::IPAddressList Controller::getExcludedIPAddressRanges() {
 // static
 QList<IPAddress> Controller::getAllowedIPAddressRanges(
     const Server& exitServer) {
-  logger.debug() << "Computing the allowed IP addresses";
+  MZ_LOG(logger, Debug) << "Computing the allowed IP addresses";
 
   QList<IPAddress> list;
 
-  logger.debug() << "Catch all IPv4";
+  MZ_LOG(logger, Debug) << "Catch all IPv4";
   list.append(IPAddress("0.0.0.0/0"));
 
-  logger.debug() << "Catch all IPv6";
+  MZ_LOG(logger, Debug) << "Catch all IPv6";
   list.append(IPAddress("::0/0"));
 
   // Allow access to the internal gateway addresses.
-  logger.debug() << "Allow the IPv4 gateway:" << exitServer.ipv4Gateway();
+  MZ_LOG(logger, Debug) << "Allow the IPv4 gateway:"
+                        << exitServer.ipv4Gateway();
   list.append(IPAddress(QHostAddress(exitServer.ipv4Gateway()), 32));
   if (!exitServer.ipv6Gateway().isEmpty()) {
-    logger.debug() << "Allow the IPv6 gateway:" << exitServer.ipv6Gateway();
+    MZ_LOG(logger, Debug) << "Allow the IPv6 gateway:"
+                          << exitServer.ipv6Gateway();
     list.append(IPAddress(QHostAddress(exitServer.ipv6Gateway()), 128));
   }
 
@@ -613,7 +618,8 @@ void Controller::activateNext() {
   }
   const InterfaceConfig& config = m_activationQueue.first();
 
-  logger.debug() << "Activating peer" << logger.keys(config.m_serverPublicKey);
+  MZ_LOG(logger, Debug) << "Activating peer"
+                        << logger.keys(config.m_serverPublicKey);
 
 // Mobile platforms will begin handshake timer once we know the VPN
 // configuration has been set with the system (to avoid persistently
@@ -638,7 +644,21 @@ void Controller::setState(State state) {
   if (m_state == state) {
     return;
   }
-  logger.debug() << "Setting state:" << state;
+  MZ_LOG(logger, Debug) << "Setting state:" << state;
+
+  if (Profiler::isEnabled()) {
+    const QMetaEnum metaEnum = QMetaEnum::fromType<State>();
+    const qint64 now = Profiler::timestamp();
+
+    QJsonObject args;
+    args["next"] = metaEnum.valueToKey(state);
+    Profiler::instance()->addEvent("controller",
+                                   metaEnum.valueToKey(m_state),
+                                   m_stateTimestamp, now - m_stateTimestamp,
+                                   args);
+    m_stateTimestamp = now;
+  }
+
   m_state = state;
   emit stateChanged();
 }
@@ -693,7 +713,7 @@ void Controller::clearRetryCounter() {
 }
 
 void Controller::connected(const QString& pubkey) {
-  logger.debug() << "handshake completed with:" << logger.keys(pubkey);
+  MZ_LOG(logger, Debug) << "handshake completed with:" << logger.keys(pubkey);
   if (m_activationQueue.isEmpty()) {
     if (m_serverData.exitServerPublicKey() != pubkey) {
       logger.warning() << "Unexpected handshake: no pending connections.";
@@ -734,7 +754,7 @@ void Controller::connected(const QString& pubkey) {
   }
 
   // We have succesfully completed all pending connections.
-  logger.debug() << "Connected from state:" << m_state;
+  MZ_LOG(logger, Debug) << "Connected from state:" << m_state;
   if (m_initiator == ExtensionUser) {
     setState(StateOnPartial);
   } else {
@@ -765,7 +785,7 @@ void Controller::resetConnectedTime() {
 }
 
 void Controller::disconnected() {
-  logger.debug() << "Disconnected from state:" << m_state;
+  MZ_LOG(logger, Debug) << "Disconnected from state:" << m_state;
 
   m_pingCanary.stop();
   m_handshakeTimer.stop();
@@ -859,7 +879,7 @@ void Controller::getStatus(
     std::function<void(const QString& serverIpv4Gateway,
                        const QString& deviceIpv4Address, uint64_t txByte,
                        uint64_t rxBytes)>&& a_callback) {
-  logger.debug() << "check status";
+  MZ_LOG(logger, Debug) << "check status";
 
   std::function<void(const QString& serverIpv4Gateway,
                      const QString& deviceIpv4Address, uint64_t txBytes,
@@ -878,7 +898,7 @@ void Controller::getStatus(
 void Controller::statusUpdated(const QString& serverIpv4Gateway,
                                const QString& deviceIpv4Address,
                                uint64_t txBytes, uint64_t rxBytes) {
-  logger.debug() << "Status updated";
+  MZ_LOG(logger, Debug) << "Status updated";
   QList<std::function<void(const QString& serverIpv4Gateway,
                            const QString& deviceIpv4Address, uint64_t txBytes,
                            uint64_t rxBytes)> >
@@ -949,7 +969,7 @@ QString Controller::currentServerString() const {
 bool Controller::activate(const ServerData& serverData,
                           ActivationPrincipal initiator,
                           ServerSelectionPolicy serverSelectionPolicy) {
-  logger.debug() << "Activation" << m_state;
+  MZ_LOG(logger, Debug) << "Activation" << m_state;
   if (m_state != Controller::StateOff &&
       m_state != Controller::StateOnPartial &&
       m_state != Controller::StateSwitching &&
@@ -1059,7 +1079,7 @@ bool Controller::activate(const ServerData& serverData,
 }
 
 bool Controller::deactivate(ActivationPrincipal user) {
-  logger.debug() << "Deactivation" << m_state;
+  MZ_LOG(logger, Debug) << "Deactivation" << m_state;
   if (m_initiator > user) {
     // i.e the Firefox Extension cannot deativate the
     // vpn if we are in full device protection.
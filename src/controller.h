@@ -217,6 +217,8 @@ class Controller : public QObject, public LogSerializer {
   QDateTime m_connectedTimeInUTC;
 
   State m_state = StateInitializing;
+  // When m_state was entered, for the profiler.
+  qint64 m_stateTimestamp = 0;
   ActivationPrincipal m_initiator = Null;
   bool m_enableDisconnectInConfirming = false;
   QList<InterfaceConfig> m_activationQueue;
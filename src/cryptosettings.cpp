@@ -5,10 +5,16 @@
 #include "cryptosettings.h"
 
 #include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileDevice>
+#include <QFileInfo>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
 #include <QRandomGenerator>
+#include <QSaveFile>
 
 #include "hacl-star/Hacl_Chacha20Poly1305_32.h"
 #include "logger.h"
@@ -31,9 +37,38 @@ constexpr int NONCE_SIZE = 12;
 constexpr int MAC_SIZE = 16;
 constexpr int ENCRYPTED_V2_HEADER_SIZE = 4;
 
+// Values bigger than this are stored in side files.
+constexpr qsizetype SIDE_FILE_THRESHOLD = 16 * 1024;
+constexpr const char* SIDE_FILE_REFERENCE = "$sideFile";
+constexpr const char* SIDE_FILE_SUFFIX = ".blob";
+
 namespace {
 Logger logger("CryptoSettings");
 CryptoSettings* s_instance = nullptr;
+
+QString settingsFilePath(QIODevice& device) {
+  QFileDevice* file = qobject_cast<QFileDevice*>(&device);
+  return file ? file->fileName() : QString();
+}
+
+bool isLargeValue(const QVariant& value) {
+  switch (value.typeId()) {
+    case QMetaType::QString:
+      return value.toString().size() > SIDE_FILE_THRESHOLD;
+    case QMetaType::QByteArray:
+      return value.toByteArray().size() > SIDE_FILE_THRESHOLD;
+    default:
+      return false;
+  }
+}
+
+QByteArray sideFileHeader(CryptoSettings::Version version,
+                          const QString& key) {
+  // The setting key is authenticated, so that side files can't be swapped.
+  QByteArray header(1, version);
+  header.append(key.toUtf8());
+  return header;
+}
 }  // namespace
 
 // static
@@ -212,10 +247,30 @@ bool CryptoSettings::readEncryptedChachaPolyFile(Version fileVersion,
     return false;
   }
 
+  QString settingsPath = settingsFilePath(device);
+  QSet<QString> sideFiles;
+
   QJsonObject obj = json.object();
   for (QJsonObject::const_iterator i = obj.constBegin(); i != obj.constEnd();
        ++i) {
-    map.insert(i.key(), i.value().toVariant());
+    QJsonObject reference = i.value().toObject();
+    if (!reference.contains(SIDE_FILE_REFERENCE)) {
+      map.insert(i.key(), i.value().toVariant());
+      continue;
+    }
+
+    // A broken side file loses its setting, not the whole file.
+    QVariant value;
+    if (!settingsPath.isEmpty() &&
+        readSideFile(settingsPath, i.key(), reference, fileVersion, key,
+                     value)) {
+      map.insert(i.key(), value);
+      sideFiles.insert(reference.value(SIDE_FILE_REFERENCE).toString());
+    }
+  }
+
+  if (!settingsPath.isEmpty()) {
+    m_liveSideFiles.insert(settingsPath, sideFiles);
   }
 
   Q_ASSERT(NONCE_SIZE > sizeof(m_lastNonce));
@@ -278,16 +333,6 @@ bool CryptoSettings::writeEncryptedChachaPolyFile(
     QIODevice& device, const QSettings::SettingsMap& map) {
   logger.debug() << "Write encrypted file";
 
-  QJsonObject obj;
-  for (QSettings::SettingsMap::ConstIterator i = map.begin(); i != map.end();
-       ++i) {
-    obj.insert(i.key(), QJsonValue::fromVariant(i.value()));
-  }
-
-  QJsonDocument json;
-  json.setObject(obj);
-  QByteArray content = json.toJson(QJsonDocument::Compact);
-
   logger.debug() << "Incrementing nonce:" << m_lastNonce;
   if (++m_lastNonce == UINT64_MAX) {
     logger.debug() << "Reset the nonce and the key.";
@@ -337,6 +382,34 @@ bool CryptoSettings::writeEncryptedChachaPolyFile(
     return false;
   }
 
+  QString settingsPath = settingsFilePath(device);
+  QSet<QString> sideFiles;
+
+  QJsonObject obj;
+  for (QSettings::SettingsMap::ConstIterator i = map.begin(); i != map.end();
+       ++i) {
+    if (!settingsPath.isEmpty() && isLargeValue(i.value())) {
+      QJsonValue reference =
+          writeSideFile(settingsPath, i.key(), i.value(), fileVersion, key);
+      if (!reference.isUndefined()) {
+        obj.insert(i.key(), reference);
+        sideFiles.insert(
+            reference.toObject().value(SIDE_FILE_REFERENCE).toString());
+        continue;
+      }
+    }
+
+    obj.insert(i.key(), QJsonValue::fromVariant(i.value()));
+  }
+
+  if (!settingsPath.isEmpty()) {
+    removeStaleSideFiles(settingsPath, sideFiles);
+  }
+
+  QJsonDocument json;
+  json.setObject(obj);
+  QByteArray content = json.toJson(QJsonDocument::Compact);
+
   QByteArray ciphertext(content.length(), 0x00);
   QByteArray mac(MAC_SIZE, 0x00);
 
@@ -369,6 +442,173 @@ bool CryptoSettings::writeEncryptedChachaPolyFile(
   return true;
 }
 
+QJsonValue CryptoSettings::writeSideFile(const QString& settingsPath,
+                                         const QString& key,
+                                         const QVariant& value,
+                                         Version version,
+                                         const QByteArray& encryptionKey) {
+  QByteArray keyHash =
+      QCryptographicHash::hash(encryptionKey, QCryptographicHash::Sha256);
+  QFileInfo settingsInfo(settingsPath);
+
+  auto makeReference = [](const SideFile& sideFile) {
+    QJsonObject reference;
+    reference[SIDE_FILE_REFERENCE] = sideFile.m_fileName;
+    reference["sha256"] = QString::fromLatin1(sideFile.m_sha256.toHex());
+    return QJsonValue(reference);
+  };
+
+  // Unchanged values are not serialized nor encrypted again.
+  QHash<QString, SideFile>& sideFiles = m_sideFiles[settingsPath];
+  auto cached = sideFiles.constFind(key);
+  if (cached != sideFiles.constEnd() && cached->m_keyHash == keyHash &&
+      cached->m_value == value &&
+      settingsInfo.dir().exists(cached->m_fileName)) {
+    return makeReference(*cached);
+  }
+
+  QByteArray content = QJsonDocument(QJsonArray{QJsonValue::fromVariant(value)})
+                           .toJson(QJsonDocument::Compact);
+
+  SideFile sideFile;
+  sideFile.m_value = value;
+  sideFile.m_keyHash = keyHash;
+  sideFile.m_sha256 =
+      QCryptographicHash::hash(content, QCryptographicHash::Sha256);
+
+  // The name depends on the setting key too: two settings holding the same
+  // value can't share a side file, as the key is part of its authenticated
+  // header.
+  QCryptographicHash nameHash(QCryptographicHash::Sha256);
+  nameHash.addData(key.toUtf8());
+  nameHash.addData(QByteArray(1, '\0'));
+  nameHash.addData(content);
+  sideFile.m_fileName = QString("%1.%2%3").arg(
+      settingsInfo.fileName(),
+      QString::fromLatin1(nameHash.result().toHex().left(16)),
+      SIDE_FILE_SUFFIX);
+
+  // Side files don't share the nonce counter of the settings file: a random
+  // nonce can't be reused even if the settings file fails to commit.
+  QByteArray nonce = generateRandomBytes(NONCE_SIZE);
+  QByteArray header = sideFileHeader(version, key);
+  QByteArray ciphertext(content.length(), 0x00);
+  QByteArray mac(MAC_SIZE, 0x00);
+
+  Hacl_Chacha20Poly1305_32_aead_encrypt(
+      (uint8_t*)encryptionKey.data(), (uint8_t*)nonce.data(),
+      static_cast<uint32_t>(header.length()), (uint8_t*)header.data(),
+      static_cast<uint32_t>(content.length()), (uint8_t*)content.data(),
+      (uint8_t*)ciphertext.data(), (uint8_t*)mac.data());
+
+  QSaveFile file(settingsInfo.dir().filePath(sideFile.m_fileName));
+  if (!file.open(QIODevice::WriteOnly) || file.write(nonce) != NONCE_SIZE ||
+      file.write(mac) != MAC_SIZE ||
+      file.write(ciphertext) != ciphertext.length() || !file.commit()) {
+    logger.error() << "Failed to write the side file for" << key;
+    return QJsonValue(QJsonValue::Undefined);
+  }
+
+  sideFiles.insert(key, sideFile);
+  return makeReference(sideFile);
+}
+
+bool CryptoSettings::readSideFile(const QString& settingsPath,
+                                  const QString& key,
+                                  const QJsonObject& reference,
+                                  Version version,
+                                  const QByteArray& encryptionKey,
+                                  QVariant& value) {
+  QString fileName = reference.value(SIDE_FILE_REFERENCE).toString();
+  QByteArray sha256 =
+      QByteArray::fromHex(reference.value("sha256").toString().toLatin1());
+
+  // Only plain file names, next to the settings file.
+  if (fileName.isEmpty() || fileName.contains('/') ||
+      fileName.contains('\\')) {
+    logger.error() << "Invalid side file reference for" << key;
+    return false;
+  }
+
+  QFileInfo settingsInfo(settingsPath);
+  QFile file(settingsInfo.dir().filePath(fileName));
+  if (!file.open(QIODevice::ReadOnly)) {
+    logger.error() << "Failed to open the side file for" << key;
+    return false;
+  }
+
+  QByteArray nonce = file.read(NONCE_SIZE);
+  QByteArray mac = file.read(MAC_SIZE);
+  QByteArray ciphertext = file.readAll();
+  if (nonce.length() != NONCE_SIZE || mac.length() != MAC_SIZE) {
+    logger.error() << "Truncated side file for" << key;
+    return false;
+  }
+
+  QByteArray header = sideFileHeader(version, key);
+  QByteArray content(ciphertext.length(), 0x00);
+  uint32_t result = Hacl_Chacha20Poly1305_32_aead_decrypt(
+      (uint8_t*)encryptionKey.data(), (uint8_t*)nonce.data(),
+      static_cast<uint32_t>(header.length()), (uint8_t*)header.data(),
+      static_cast<uint32_t>(ciphertext.length()), (uint8_t*)content.data(),
+      (uint8_t*)ciphertext.data(), (uint8_t*)mac.data());
+  if (result != 0) {
+    logger.error() << "Failed to decrypt the side file for" << key;
+    return false;
+  }
+
+  // The settings file pins the content, so an older side file of the same
+  // setting is rejected too.
+  if (QCryptographicHash::hash(content, QCryptographicHash::Sha256) !=
+      sha256) {
+    logger.error() << "Side file hash mismatch for" << key;
+    return false;
+  }
+
+  QJsonArray array = QJsonDocument::fromJson(content).array();
+  if (array.size() != 1) {
+    logger.error() << "Invalid side file content for" << key;
+    return false;
+  }
+  value = array.at(0).toVariant();
+
+  SideFile sideFile;
+  sideFile.m_value = value;
+  sideFile.m_fileName = fileName;
+  sideFile.m_sha256 = sha256;
+  sideFile.m_keyHash =
+      QCryptographicHash::hash(encryptionKey, QCryptographicHash::Sha256);
+  m_sideFiles[settingsPath].insert(key, sideFile);
+  return true;
+}
+
+void CryptoSettings::removeStaleSideFiles(const QString& settingsPath,
+                                          const QSet<QString>& fileNames) {
+  QFileInfo settingsInfo(settingsPath);
+  QDir dir = settingsInfo.dir();
+
+  // Keep what the settings file on disk references until this write has
+  // replaced it.
+  QSet<QString> keep = fileNames;
+  keep.unite(m_liveSideFiles.value(settingsPath));
+
+  const QStringList candidates = dir.entryList(
+      QStringList{QString("%1.*%2").arg(settingsInfo.fileName(),
+                                        SIDE_FILE_SUFFIX)},
+      QDir::Files);
+  for (const QString& candidate : candidates) {
+    if (!keep.contains(candidate)) {
+      dir.remove(candidate);
+    }
+  }
+
+  m_liveSideFiles.insert(settingsPath, fileNames);
+  m_sideFiles[settingsPath].removeIf(
+      [&](QHash<QString, SideFile>::iterator it) {
+        return !fileNames.contains(it.value().m_fileName);
+      });
+}
+
 // static
 QByteArray CryptoSettings::generateRandomBytes(qsizetype length) {
   QRandomGenerator* rg = QRandomGenerator::system();
@@ -6,6 +6,9 @@
 #define CRYPTOSETTINGS_H
 
 #include <QByteArray>
+#include <QHash>
+#include <QJsonValue>
+#include <QSet>
 #include <QSettings>
 
 constexpr int CRYPTO_SETTINGS_KEY_SIZE = 32;
@@ -50,6 +53,33 @@ class CryptoSettings {
   bool writeEncryptedChachaPolyFile(QIODevice& device,
                                     const QSettings::SettingsMap& map);
 
+  // Large values are kept in encrypted side files next to the settings file,
+  // and only rewritten when they change. The settings file stores a
+  // reference with the SHA256 of the value.
+  QJsonValue writeSideFile(const QString& settingsPath, const QString& key,
+                           const QVariant& value, Version version,
+                           const QByteArray& encryptionKey);
+  bool readSideFile(const QString& settingsPath, const QString& key,
+                    const QJsonObject& reference, Version version,
+                    const QByteArray& encryptionKey, QVariant& value);
+  void removeStaleSideFiles(const QString& settingsPath,
+                            const QSet<QString>& fileNames);
+
+  struct SideFile {
+    QVariant m_value;
+    QString m_fileName;
+    QByteArray m_sha256;
+    // Hash of the key the side file is encrypted with.
+    QByteArray m_keyHash;
+  };
+
+  // Side files by settings file path, then by setting key.
+  QHash<QString, QHash<QString, SideFile>> m_sideFiles;
+
+  // Side files referenced by the last settings file read or written. They
+  // are kept until the next write, in case the current one doesn't commit.
+  QHash<QString, QSet<QString>> m_liveSideFiles;
+
  protected:
   uint64_t m_lastNonce = 0;
 };
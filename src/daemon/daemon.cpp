@@ -18,7 +18,6 @@
 #include "loghandler.h"
 
 constexpr const char* JSON_ALLOWEDIPADDRESSRANGES = "allowedIPAddressRanges";
-constexpr int HANDSHAKE_POLL_MSEC = 250;
 
 namespace {
 
@@ -92,7 +91,7 @@ bool Daemon::activate(const InterfaceConfig& config) {
       logger.debug() << "Connection status:" << status;
       if (status) {
         m_connections[config.m_hopType] = ConnectionState(config);
-        m_handshakeTimer.start(HANDSHAKE_POLL_MSEC);
+        startHandshakeCheck();
         emit_failure_guard.dismiss();
         return true;
       }
@@ -163,7 +162,7 @@ bool Daemon::activate(const InterfaceConfig& config) {
   logger.debug() << "Connection status:" << status;
   if (status) {
     m_connections[config.m_hopType] = ConnectionState(config);
-    m_handshakeTimer.start(HANDSHAKE_POLL_MSEC);
+    startHandshakeCheck();
     emit_failure_guard.dismiss();
     return true;
   }
@@ -445,7 +444,7 @@ bool Daemon::switchServer(const InterfaceConfig& config) {
 QJsonObject Daemon::getStatus() {
   Q_ASSERT(wgutils() != nullptr);
   QJsonObject json;
-  logger.debug() << "Status request";
+  MZ_LOG(logger, Debug) << "Status request";
 
   if (!wgutils()->interfaceExists() || m_connections.isEmpty()) {
     json.insert("connected", QJsonValue(false));
@@ -473,28 +472,44 @@ QJsonObject Daemon::getStatus() {
   return json;
 }
 
+void Daemon::startHandshakeCheck() {
+  m_handshakeTimer.start(m_handshakeBackoff.reset());
+}
+
 void Daemon::checkHandshake() {
   Q_ASSERT(wgutils() != nullptr);
 
-  logger.debug() << "Checking for handshake...";
+  MZ_LOG(logger, Debug) << "Checking for handshake...";
+
+  QStringList pending;
+  for (const ConnectionState& connection : m_connections) {
+    if (connection.m_date.isValid()) {
+      continue;
+    }
+    const QString& pubkey = connection.m_config.m_serverPublicKey;
+    MZ_LOG(logger, Debug) << "awaiting" << logger.keys(pubkey);
+    pending.append(pubkey);
+  }
+  if (pending.isEmpty()) {
+    return;
+  }
+
+  // Check if the handshakes have completed, with a single query for all the
+  // pending connections.
+  const QList<WireguardUtils::PeerStatus> peers =
+      wgutils()->peerStatus(pending);
 
   int pendingHandshakes = 0;
-  QList<WireguardUtils::PeerStatus> peers = wgutils()->getPeerStatus();
   for (ConnectionState& connection : m_connections) {
-    const InterfaceConfig& config = connection.m_config;
     if (connection.m_date.isValid()) {
       continue;
     }
-    logger.debug() << "awaiting" << logger.keys(config.m_serverPublicKey);
-
-    // Check if the handshake has completed.
     for (const WireguardUtils::PeerStatus& status : peers) {
-      if (config.m_serverPublicKey != status.m_pubkey) {
-        continue;
-      }
-      if (status.m_handshake != 0) {
+      if (status.m_pubkey == connection.m_config.m_serverPublicKey &&
+          status.m_handshake != 0) {
         connection.m_date.setMSecsSinceEpoch(status.m_handshake);
         emit connected(status.m_pubkey);
+        break;
       }
     }
 
@@ -505,6 +520,6 @@ void Daemon::checkHandshake() {
 
   // Check again if there were connections that haven't completed a handshake.
   if (pendingHandshakes > 0) {
-    m_handshakeTimer.start(HANDSHAKE_POLL_MSEC);
+    m_handshakeTimer.start(m_handshakeBackoff.next());
   }
 }
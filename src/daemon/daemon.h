@@ -11,6 +11,7 @@
 #include "daemon/daemonerrors.h"
 #include "daemonerrors.h"
 #include "dnsutils.h"
+#include "handshakebackoff.h"
 #include "interfaceconfig.h"
 #include "iputils.h"
 #include "wireguardutils.h"
@@ -72,6 +73,7 @@ class Daemon : public QObject {
   static bool parseStringList(const QJsonObject& obj, const QString& name,
                               QStringList& list);
 
+  void startHandshakeCheck();
   void checkHandshake();
 
   class ConnectionState {
@@ -83,6 +85,7 @@ class Daemon : public QObject {
   };
   QMap<InterfaceConfig::HopType, ConnectionState> m_connections;
   QTimer m_handshakeTimer;
+  HandshakeBackoff m_handshakeBackoff;
 };
 
 #endif  // DAEMON_H
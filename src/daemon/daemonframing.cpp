@@ -0,0 +1,144 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "daemonframing.h"
+
+#include <QCborMap>
+#include <QCborValue>
+#include <QJsonDocument>
+#include <QtEndian>
+
+#include "leakdetector.h"
+#include "logger.h"
+
+// Version byte followed by the payload length.
+constexpr qsizetype FRAME_HEADER_SIZE = 1 + sizeof(quint32);
+
+// Anything bigger than this is a corrupted stream.
+constexpr quint32 FRAME_MAX_SIZE = 64 * 1024 * 1024;
+
+namespace {
+Logger logger("DaemonFraming");
+}  // namespace
+
+DaemonFraming::DaemonFraming() { MZ_COUNT_CTOR(DaemonFraming); }
+
+DaemonFraming::~DaemonFraming() { MZ_COUNT_DTOR(DaemonFraming); }
+
+// static
+QByteArray DaemonFraming::encode(const QJsonObject& message, bool binary) {
+  if (!binary) {
+    QByteArray line = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    return line;
+  }
+
+  QByteArray payload = QCborMap::fromJsonObject(message).toCborValue().toCbor();
+
+  char header[FRAME_HEADER_SIZE];
+  header[0] = static_cast<char>(VERSION);
+  qToBigEndian<quint32>(static_cast<quint32>(payload.size()), header + 1);
+
+  QByteArray frame;
+  frame.reserve(FRAME_HEADER_SIZE + payload.size());
+  frame.append(header, FRAME_HEADER_SIZE);
+  frame.append(payload);
+  return frame;
+}
+
+void DaemonFraming::append(const QByteArray& data) {
+  if (!m_corrupted) {
+    m_buffer.append(data);
+  }
+}
+
+bool DaemonFraming::next(QJsonObject& message, bool& binary) {
+  while (m_offset < m_buffer.size()) {
+    binary = static_cast<quint8>(m_buffer.at(m_offset)) == VERSION;
+
+    Result result = binary ? nextFrame(message) : nextLine(message);
+    if (result == Valid) {
+      return true;
+    }
+    if (result == Incomplete || result == Corrupted) {
+      break;
+    }
+  }
+
+  // Consumed messages are dropped once per read, not once per message.
+  compact();
+  return false;
+}
+
+DaemonFraming::Result DaemonFraming::nextFrame(QJsonObject& message) {
+  if ((m_buffer.size() - m_offset) < FRAME_HEADER_SIZE) {
+    return Incomplete;
+  }
+
+  const char* header = m_buffer.constData() + m_offset;
+  quint32 length = qFromBigEndian<quint32>(header + 1);
+  if (length > FRAME_MAX_SIZE) {
+    logger.error() << "Frame too large:" << length;
+    m_buffer.clear();
+    m_offset = 0;
+    m_scanned = 0;
+    m_corrupted = true;
+    return Corrupted;
+  }
+
+  if ((m_buffer.size() - m_offset - FRAME_HEADER_SIZE) < qsizetype(length)) {
+    return Incomplete;
+  }
+
+  QCborParserError error;
+  QCborValue value = QCborValue::fromCbor(
+      QByteArray::fromRawData(header + FRAME_HEADER_SIZE, length), &error);
+  m_offset += FRAME_HEADER_SIZE + length;
+
+  if (error.error != QCborError::NoError || !value.isMap()) {
+    logger.error() << "Invalid frame";
+    return Invalid;
+  }
+
+  message = value.toMap().toJsonObject();
+  return Valid;
+}
+
+DaemonFraming::Result DaemonFraming::nextLine(QJsonObject& message) {
+  // Resume the search where the previous read stopped, so that a long line
+  // arriving in many chunks is scanned only once.
+  qsizetype pos = m_buffer.indexOf('\n', qMax(m_offset, m_scanned));
+  if (pos < 0) {
+    m_scanned = m_buffer.size();
+    return Incomplete;
+  }
+
+  QByteArray line =
+      QByteArray::fromRawData(m_buffer.constData() + m_offset, pos - m_offset)
+          .trimmed();
+  m_offset = pos + 1;
+
+  if (line.isEmpty()) {
+    return Invalid;
+  }
+
+  QJsonDocument json = QJsonDocument::fromJson(line);
+  if (!json.isObject()) {
+    logger.error() << "Invalid JSON - object expected";
+    return Invalid;
+  }
+
+  message = json.object();
+  return Valid;
+}
+
+void DaemonFraming::compact() {
+  if (m_offset == 0) {
+    return;
+  }
+
+  m_buffer.remove(0, m_offset);
+  m_scanned = qMax<qsizetype>(0, m_scanned - m_offset);
+  m_offset = 0;
+}
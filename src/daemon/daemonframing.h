@@ -0,0 +1,68 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef DAEMONFRAMING_H
+#define DAEMONFRAMING_H
+
+#include <QByteArray>
+#include <QJsonObject>
+
+/**
+ * @brief Message framing of the local socket between client and daemon
+ *
+ * Messages are either JSON documents terminated by a newline, or binary
+ * frames: one version byte, a 32-bit big-endian payload length and a CBOR
+ * map. A JSON line never starts with the version byte, so the two can be
+ * mixed on the same stream and the reader doesn't need to know which one
+ * the peer is using.
+ *
+ * Each side keeps sending JSON until the other one has advertised the
+ * binary framing, through the "framing" field of the "status" messages.
+ */
+class DaemonFraming final {
+ public:
+  // Version byte of the binary frames, and the value of the "framing" field.
+  static constexpr quint8 VERSION = 1;
+
+  static QByteArray encode(const QJsonObject& message, bool binary);
+
+  DaemonFraming();
+  ~DaemonFraming();
+
+  void append(const QByteArray& data);
+
+  // Extracts the next complete message. Returns false when more data is
+  // needed, or when the stream is corrupted. binary is set to the framing the
+  // message was received with.
+  bool next(QJsonObject& message, bool& binary);
+
+  // True once the stream can't be resynchronized, e.g. after a frame larger
+  // than the limit. Nothing else is read, and the connection should be
+  // closed.
+  bool corrupted() const { return m_corrupted; }
+
+ private:
+  enum Result {
+    Incomplete,
+    Invalid,
+    Corrupted,
+    Valid,
+  };
+
+  Result nextFrame(QJsonObject& message);
+  Result nextLine(QJsonObject& message);
+  void compact();
+
+  QByteArray m_buffer;
+
+  // Start of the first unread message in m_buffer.
+  qsizetype m_offset = 0;
+
+  // Position up to which the current line has been searched for a newline.
+  qsizetype m_scanned = 0;
+
+  bool m_corrupted = false;
+};
+
+#endif  // DAEMONFRAMING_H
@@ -4,7 +4,6 @@
 
 #include "daemonlocalserverconnection.h"
 
-#include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
 #include <QLocalSocket>
@@ -53,40 +52,27 @@ void DaemonLocalServerConnection::readData() {
   logger.debug() << "Read Data";
 
   Q_ASSERT(m_socket);
+  m_framing.append(m_socket->readAll());
 
-  while (true) {
-    int pos = m_buffer.indexOf("\n");
-    if (pos == -1) {
-      QByteArray input = m_socket->readAll();
-      if (input.isEmpty()) {
-        break;
-      }
-      m_buffer.append(input);
-      continue;
-    }
-
-    QByteArray line = m_buffer.left(pos);
-    m_buffer.remove(0, pos + 1);
-
-    QByteArray command(line);
-    command = command.trimmed();
-
-    if (command.isEmpty()) {
-      continue;
-    }
+  QJsonObject obj;
+  bool binary = false;
+  while (m_framing.next(obj, binary)) {
+    parseCommand(obj, binary);
+  }
 
-    parseCommand(command);
+  if (m_framing.corrupted()) {
+    logger.error() << "Corrupted stream - closing the connection";
+    m_socket->abort();
   }
 }
 
-void DaemonLocalServerConnection::parseCommand(const QByteArray& data) {
-  QJsonDocument json = QJsonDocument::fromJson(data);
-  if (!json.isObject()) {
-    logger.error() << "Invalid input";
-    return;
+void DaemonLocalServerConnection::parseCommand(const QJsonObject& obj,
+                                               bool binary) {
+  // A client sending frames can obviously read them too.
+  if (binary) {
+    m_binary = true;
   }
 
-  QJsonObject obj = json.object();
   QJsonValue typeValue = obj.value("type");
   if (!typeValue.isString()) {
     logger.warning() << "No type command. Ignoring request.";
@@ -136,16 +122,29 @@ void DaemonLocalServerConnection::parseCommand(const QByteArray& data) {
   }
 
   if (type == "status") {
+    if (obj.value("framing").toInt() >= DaemonFraming::VERSION) {
+      m_binary = true;
+    }
+
     QJsonObject obj = m_daemon->getStatus();
     obj.insert("type", "status");
+    if (m_binary) {
+      obj.insert("framing", DaemonFraming::VERSION);
+    }
     write(obj);
     return;
   }
 
   if (type == "logs") {
+    // The line based protocol folds newlines into '|', frames don't need to.
+    QString logs = m_daemon->logs();
+    if (!m_binary) {
+      logs.replace("\n", "|");
+    }
+
     QJsonObject obj;
     obj.insert("type", "logs");
-    obj.insert("logs", m_daemon->logs().replace("\n", "|"));
+    obj.insert("logs", logs);
     write(obj);
     return;
   }
@@ -179,6 +178,5 @@ void DaemonLocalServerConnection::backendFailure(DaemonError err) {
 }
 
 void DaemonLocalServerConnection::write(const QJsonObject& obj) {
-  m_socket->write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
-  m_socket->write("\n");
+  m_socket->write(DaemonFraming::encode(obj, m_binary));
 }
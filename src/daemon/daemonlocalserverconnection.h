@@ -8,6 +8,7 @@
 #include <QObject>
 
 #include "daemonerrors.h"
+#include "daemonframing.h"
 
 class Daemon;
 class QLocalSocket;
@@ -22,7 +23,7 @@ class DaemonLocalServerConnection final : public QObject {
  private:
   void readData();
 
-  void parseCommand(const QByteArray& json);
+  void parseCommand(const QJsonObject& obj, bool binary);
 
   void connected(const QString& pubkey);
   void disconnected();
@@ -33,7 +34,10 @@ class DaemonLocalServerConnection final : public QObject {
  private:
   Daemon* m_daemon = nullptr;
   QLocalSocket* m_socket = nullptr;
-  QByteArray m_buffer;
+  DaemonFraming m_framing;
+
+  // True once the client has advertised the binary framing.
+  bool m_binary = false;
 };
 
 #endif  // DAEMONLOCALSERVERCONNECTION_H
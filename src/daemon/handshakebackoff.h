@@ -0,0 +1,37 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef HANDSHAKEBACKOFF_H
+#define HANDSHAKEBACKOFF_H
+
+#include <QtGlobal>
+
+// The schedule of the handshake checks. The handshake is checked soon after
+// the activation, then less and less often as time passes: a handshake
+// usually takes about one round trip to the server, and we want to report it
+// without waiting for a fixed poll tick.
+class HandshakeBackoff final {
+ public:
+  static constexpr int MIN_MSEC = 50;
+  static constexpr int MAX_MSEC = 250;
+
+  // Restarts the schedule, and returns the first interval.
+  int reset() {
+    m_msec = MIN_MSEC;
+    return m_msec;
+  }
+
+  // Returns the interval before the next check, after a missed one.
+  int next() {
+    m_msec = qMin(m_msec * 3 / 2, MAX_MSEC);
+    return m_msec;
+  }
+
+  int interval() const { return m_msec; }
+
+ private:
+  int m_msec = MIN_MSEC;
+};
+
+#endif  // HANDSHAKEBACKOFF_H
@@ -41,6 +41,19 @@ class WireguardUtils : public QObject {
   virtual bool deletePeer(const InterfaceConfig& config) = 0;
   virtual QList<PeerStatus> getPeerStatus() = 0;
 
+  // Returns the status of the given peers, from a single query of the
+  // device. Peers that don't exist are left out. Platforms can override this
+  // with something cheaper than fetching all the peers.
+  virtual QList<PeerStatus> peerStatus(const QStringList& pubkeys) {
+    QList<PeerStatus> peerList;
+    for (const PeerStatus& status : getPeerStatus()) {
+      if (pubkeys.contains(status.m_pubkey)) {
+        peerList.append(status);
+      }
+    }
+    return peerList;
+  }
+
   virtual bool updateRoutePrefix(const IPAddress& prefix) = 0;
   virtual bool deleteRoutePrefix(const IPAddress& prefix) = 0;
   virtual bool excludeLocalNetworks(const QList<IPAddress>& addresses) = 0;
@@ -181,6 +181,13 @@ FEATURE(shareLogs,              // Feature ID
         QStringList(),          // feature dependencies
         FeatureCallback_shareLogs)
 
+FEATURE(sharedApiConnections,      // Feature ID
+        "Shared API connections",  // Feature name
+        FeatureCallback_true,      // Can be flipped on
+        FeatureCallback_true,      // Can be flipped off
+        QStringList(),             // feature dependencies
+        FeatureCallback_false)
+
 FEATURE(splitTunnel,            // Feature ID
         "Split-tunnel",         // Feature name
         FeatureCallback_true,   // Can be flipped on
@@ -32,6 +32,9 @@ class TaskGetFeatureList final : public Task {
   ~TaskGetFeatureList();
 
   void run() override;
+
+  QString conflictGroup() const override { return "featurelist"; }
+  Priority priority() const override { return Low; }
 };
 
 #endif  // TASKGETFEATURELIST_H
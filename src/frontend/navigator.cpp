@@ -15,6 +15,7 @@
 #include "logger.h"
 #include "loglevel.h"
 #include "mozillavpn.h"
+#include "profiler.h"
 #include "qmlengineholder.h"
 
 namespace {
@@ -107,12 +108,33 @@ QList<ScreenData*> computeScreens(int* requestedScreen) {
 
 void maybeGenerateComponent(Navigator* navigator, ScreenData* screen) {
   if (!screen->m_qmlComponent) {
+    const qint64 start = Profiler::isEnabled() ? Profiler::timestamp() : -1;
+
     QQmlComponent* qmlComponent = new QQmlComponent(
         QmlEngineHolder::instance()->engine(), screen->m_qmlComponentUrl,
         QQmlComponent::Asynchronous, navigator);
 
     Q_ASSERT(!qmlComponent->isError());
     screen->m_qmlComponent = qmlComponent;
+
+    if (start < 0) {
+      return;
+    }
+
+    // The component is compiled asynchronously, unless it was cached: the
+    // load ends when it leaves the Loading status.
+    auto addProfilerEvent = [qmlComponent, start]() {
+      Profiler::instance()->addEvent("qml", qmlComponent->url().toString(),
+                                     start, Profiler::timestamp() - start);
+    };
+
+    if (!qmlComponent->isLoading()) {
+      addProfilerEvent();
+      return;
+    }
+
+    QObject::connect(qmlComponent, &QQmlComponent::statusChanged, qmlComponent,
+                     addProfilerEvent, Qt::SingleShotConnection);
   }
 }
 
@@ -40,6 +40,7 @@
 #include "loghandler.h"
 #include "mzglean.h"
 #include "networkmanager.h"
+#include "profiler.h"
 #include "qmlengineholder.h"
 #include "settings/settingsmanager.h"
 #include "settingsholder.h"
@@ -733,6 +734,34 @@ static QList<InspectorCommand> s_commands{
                        return QJsonObject();
                      }},
 
+    InspectorCommand{"leak_counters",
+                     "Live and created instances of each counted class", 0,
+                     [](InspectorHandler*, const QList<QByteArray>&) {
+                       QJsonObject obj;
+#ifdef MZ_DEBUG
+                       obj["value"] = LeakDetector::countersToJson();
+#else
+                       obj["error"] = "Available in debug builds only";
+#endif
+                       return obj;
+                     }},
+
+    InspectorCommand{"profiler_start",
+                     "Start streaming timing events in the Chrome trace format",
+                     0,
+                     [](InspectorHandler*, const QList<QByteArray>&) {
+                       Profiler::instance()->start();
+                       return QJsonObject();
+                     }},
+
+    InspectorCommand{"profiler_stop",
+                     "Stop the profiling session and return its trace", 0,
+                     [](InspectorHandler*, const QList<QByteArray>&) {
+                       QJsonObject obj;
+                       obj["value"] = Profiler::instance()->stop();
+                       return obj;
+                     }},
+
     InspectorCommand{
         "set_subscription_start_date",
         "Changes the start date of the subscription", 1,
@@ -781,6 +810,9 @@ InspectorHandler::InspectorHandler(QObject* parent) : QObject(parent) {
           &QNetworkAccessManager::finished, this,
           &InspectorHandler::networkRequestFinished);
 
+  connect(Profiler::instance(), &Profiler::eventAdded, this,
+          &InspectorHandler::profilerEventAdded);
+
   if (s_constructorCallback) {
     s_constructorCallback(this);
   }
@@ -839,6 +871,13 @@ void InspectorHandler::logEntryAdded(const QByteArray& log) {
   send(QJsonDocument(obj).toJson(QJsonDocument::Compact));
 }
 
+void InspectorHandler::profilerEventAdded(const QJsonObject& event) {
+  QJsonObject obj;
+  obj["type"] = "profiler";
+  obj["value"] = event;
+  send(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+}
+
 void InspectorHandler::networkRequestFinished(QNetworkReply* reply) {
   if (!s_forwardNetwork) {
     return;
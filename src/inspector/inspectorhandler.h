@@ -8,6 +8,7 @@
 #include <QByteArray>
 #include <QObject>
 
+class QJsonObject;
 class QNetworkReply;
 class QUrl;
 class QQuickItem;
@@ -51,6 +52,7 @@ class InspectorHandler : public QObject {
   void addonLoadCompleted();
   void logEntryAdded(const QByteArray& log);
   void networkRequestFinished(QNetworkReply* reply);
+  void profilerEventAdded(const QJsonObject& event);
 };
 
 #endif  // INSPECTORHANDLER_H
@@ -6,6 +6,7 @@
 
 #include <QtMath>
 
+#include "iprangeset.h"
 #include "leakdetector.h"
 
 IPAddress::IPAddress() { MZ_COUNT_CTOR(IPAddress); }
@@ -237,24 +238,9 @@ QList<IPAddress> IPAddress::subnets() const {
 // static
 QList<IPAddress> IPAddress::excludeAddresses(
     const QList<IPAddress>& sourceList, const QList<IPAddress>& excludeList) {
-  QList<IPAddress> results = sourceList;
-
-  for (const IPAddress& exclude : excludeList) {
-    QList<IPAddress> newResults;
-
-    for (const IPAddress& ip : results) {
-      if (!ip.overlaps(exclude)) {
-        newResults.append(ip);
-      } else if (exclude.subnetOf(ip) && exclude != ip) {
-        QList<IPAddress> range = ip.excludeAddresses(exclude);
-        newResults.append(range);
-      }
-    }
-
-    results = newResults;
-  }
-
-  return results;
+  IPRangeSet set(sourceList);
+  set.remove(excludeList);
+  return set.toList();
 }
 
 QList<IPAddress> IPAddress::excludeAddresses(const IPAddress& ip) const {
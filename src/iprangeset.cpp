@@ -0,0 +1,312 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "iprangeset.h"
+
+#include <QtAlgorithms>
+#include <QtEndian>
+#include <algorithm>
+#include <iterator>
+
+#include "leakdetector.h"
+
+IPRangeSet::IPRangeSet() { MZ_COUNT_CTOR(IPRangeSet); }
+
+IPRangeSet::IPRangeSet(const QList<IPAddress>& list) {
+  MZ_COUNT_CTOR(IPRangeSet);
+  split(list, m_ipv4, m_ipv6);
+}
+
+IPRangeSet::IPRangeSet(const IPRangeSet& other) {
+  MZ_COUNT_CTOR(IPRangeSet);
+  *this = other;
+}
+
+IPRangeSet& IPRangeSet::operator=(const IPRangeSet& other) {
+  if (this == &other) return *this;
+
+  m_ipv4 = other.m_ipv4;
+  m_ipv6 = other.m_ipv6;
+
+  return *this;
+}
+
+IPRangeSet::~IPRangeSet() { MZ_COUNT_DTOR(IPRangeSet); }
+
+void IPRangeSet::add(const IPAddress& ip) { add(QList<IPAddress>{ip}); }
+
+void IPRangeSet::add(const QList<IPAddress>& list) {
+  add(IPRangeSet(list));
+}
+
+void IPRangeSet::add(const IPRangeSet& other) {
+  m_ipv4 = unite(m_ipv4, other.m_ipv4);
+  m_ipv6 = unite(m_ipv6, other.m_ipv6);
+}
+
+void IPRangeSet::remove(const IPAddress& ip) { remove(QList<IPAddress>{ip}); }
+
+void IPRangeSet::remove(const QList<IPAddress>& list) {
+  remove(IPRangeSet(list));
+}
+
+void IPRangeSet::remove(const IPRangeSet& other) {
+  m_ipv4 = subtract(m_ipv4, other.m_ipv4);
+  m_ipv6 = subtract(m_ipv6, other.m_ipv6);
+}
+
+bool IPRangeSet::contains(const QHostAddress& address) const {
+  if (address.protocol() != QAbstractSocket::IPv4Protocol &&
+      address.protocol() != QAbstractSocket::IPv6Protocol) {
+    return false;
+  }
+
+  Range range;
+  bool ipv6 = false;
+  if (!fromIPAddress(IPAddress(address), range, ipv6)) {
+    return false;
+  }
+
+  const RangeList& ranges = ipv6 ? m_ipv6 : m_ipv4;
+  auto it = std::upper_bound(ranges.cbegin(), ranges.cend(), range.m_first,
+                             [](const Uint128& value, const Range& r) {
+                               return value < r.m_first;
+                             });
+  if (it == ranges.cbegin()) {
+    return false;
+  }
+
+  return std::prev(it)->m_last >= range.m_first;
+}
+
+QList<IPAddress> IPRangeSet::toList() const {
+  QList<IPAddress> list;
+  for (const Range& range : m_ipv4) {
+    appendPrefixes(range, false, list);
+  }
+  for (const Range& range : m_ipv6) {
+    appendPrefixes(range, true, list);
+  }
+  return list;
+}
+
+// static
+bool IPRangeSet::fromIPAddress(const IPAddress& ip, Range& range,
+                               bool& ipv6) {
+  Uint128 address;
+  int bits;
+
+  switch (ip.type()) {
+    case QAbstractSocket::IPv4Protocol:
+      address.m_low = ip.address().toIPv4Address();
+      bits = 32;
+      ipv6 = false;
+      break;
+
+    case QAbstractSocket::IPv6Protocol: {
+      Q_IPV6ADDR raw = ip.address().toIPv6Address();
+      address.m_high = qFromBigEndian<quint64>(&raw[0]);
+      address.m_low = qFromBigEndian<quint64>(&raw[8]);
+      bits = 128;
+      ipv6 = true;
+      break;
+    }
+
+    default:
+      return false;
+  }
+
+  Uint128 hostmask = Uint128::lowBits(bits - ip.prefixLength());
+  range.m_first = address & ~hostmask;
+  range.m_last = range.m_first | hostmask;
+  return true;
+}
+
+// static
+void IPRangeSet::split(const QList<IPAddress>& list, RangeList& ipv4,
+                       RangeList& ipv6) {
+  for (const IPAddress& ip : list) {
+    Range range;
+    bool isIPv6 = false;
+    if (fromIPAddress(ip, range, isIPv6)) {
+      (isIPv6 ? ipv6 : ipv4).append(range);
+    }
+  }
+
+  normalize(ipv4);
+  normalize(ipv6);
+}
+
+// static
+void IPRangeSet::normalize(RangeList& ranges) {
+  std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) {
+    return a.m_first < b.m_first;
+  });
+
+  RangeList result;
+  result.reserve(ranges.size());
+  for (const Range& range : ranges) {
+    appendMerged(result, range);
+  }
+  ranges = result;
+}
+
+// static
+void IPRangeSet::appendMerged(RangeList& ranges, const Range& range) {
+  // Ranges are appended in order of their first address. Overlapping and
+  // adjacent ranges are folded into the last one.
+  if (!ranges.isEmpty()) {
+    Range& last = ranges.last();
+    if (last.m_last == ~Uint128() || range.m_first <= last.m_last.next()) {
+      last.m_last = std::max(last.m_last, range.m_last);
+      return;
+    }
+  }
+
+  ranges.append(range);
+}
+
+// static
+IPRangeSet::RangeList IPRangeSet::unite(const RangeList& a,
+                                        const RangeList& b) {
+  RangeList result;
+  result.reserve(a.size() + b.size());
+
+  qsizetype i = 0;
+  qsizetype j = 0;
+  while (i < a.size() || j < b.size()) {
+    if (j >= b.size() || (i < a.size() && a[i].m_first < b[j].m_first)) {
+      appendMerged(result, a[i++]);
+    } else {
+      appendMerged(result, b[j++]);
+    }
+  }
+
+  return result;
+}
+
+// static
+IPRangeSet::RangeList IPRangeSet::subtract(const RangeList& a,
+                                           const RangeList& b) {
+  RangeList result;
+  result.reserve(a.size());
+
+  qsizetype j = 0;
+  for (Range range : a) {
+    // Skip the excluded ranges which end before this one starts.
+    while (j < b.size() && b[j].m_last < range.m_first) {
+      ++j;
+    }
+
+    bool consumed = false;
+    for (qsizetype k = j; k < b.size() && b[k].m_first <= range.m_last; ++k) {
+      if (b[k].m_first > range.m_first) {
+        result.append(Range{range.m_first, b[k].m_first.previous()});
+      }
+      if (b[k].m_last >= range.m_last) {
+        consumed = true;
+        break;
+      }
+      range.m_first = b[k].m_last.next();
+    }
+
+    if (!consumed) {
+      result.append(range);
+    }
+  }
+
+  return result;
+}
+
+// static
+IPAddress IPRangeSet::toIPAddress(const Uint128& address, int prefixLength,
+                                  bool ipv6) {
+  if (!ipv6) {
+    return IPAddress(QHostAddress(static_cast<quint32>(address.m_low)),
+                     prefixLength);
+  }
+
+  Q_IPV6ADDR raw;
+  qToBigEndian<quint64>(address.m_high, &raw[0]);
+  qToBigEndian<quint64>(address.m_low, &raw[8]);
+  return IPAddress(QHostAddress(raw), prefixLength);
+}
+
+// static
+void IPRangeSet::appendPrefixes(const Range& range, bool ipv6,
+                                QList<IPAddress>& list) {
+  const int bits = ipv6 ? 128 : 32;
+
+  // Emit the largest aligned block starting at the first address that fits
+  // in the range, then continue after it.
+  Uint128 start = range.m_first;
+  for (;;) {
+    int hostBits = std::min(start.trailingZeros(), bits);
+    Uint128 last = start | Uint128::lowBits(hostBits);
+    while (last > range.m_last) {
+      --hostBits;
+      last = start | Uint128::lowBits(hostBits);
+    }
+
+    list.append(toIPAddress(start, bits - hostBits, ipv6));
+    if (last >= range.m_last) {
+      return;
+    }
+    start = last.next();
+  }
+}
+
+// static
+IPRangeSet::Uint128 IPRangeSet::Uint128::lowBits(int count) {
+  Q_ASSERT(count >= 0 && count <= 128);
+
+  Uint128 value;
+  if (count >= 128) {
+    value.m_high = ~quint64(0);
+    value.m_low = ~quint64(0);
+  } else if (count >= 64) {
+    value.m_high = count > 64 ? (~quint64(0) >> (128 - count)) : 0;
+    value.m_low = ~quint64(0);
+  } else {
+    value.m_low = count > 0 ? (~quint64(0) >> (64 - count)) : 0;
+  }
+  return value;
+}
+
+IPRangeSet::Uint128 IPRangeSet::Uint128::operator|(
+    const Uint128& other) const {
+  return Uint128{m_high | other.m_high, m_low | other.m_low};
+}
+
+IPRangeSet::Uint128 IPRangeSet::Uint128::operator&(
+    const Uint128& other) const {
+  return Uint128{m_high & other.m_high, m_low & other.m_low};
+}
+
+IPRangeSet::Uint128 IPRangeSet::Uint128::operator~() const {
+  return Uint128{~m_high, ~m_low};
+}
+
+IPRangeSet::Uint128 IPRangeSet::Uint128::next() const {
+  Uint128 value = *this;
+  if (++value.m_low == 0) {
+    ++value.m_high;
+  }
+  return value;
+}
+
+IPRangeSet::Uint128 IPRangeSet::Uint128::previous() const {
+  Uint128 value = *this;
+  if (value.m_low-- == 0) {
+    --value.m_high;
+  }
+  return value;
+}
+
+int IPRangeSet::Uint128::trailingZeros() const {
+  if (m_low != 0) {
+    return qCountTrailingZeroBits(m_low);
+  }
+  return 64 + qCountTrailingZeroBits(m_high);
+}
@@ -0,0 +1,88 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef IPRANGESET_H
+#define IPRANGESET_H
+
+#include <compare>
+
+#include <QHostAddress>
+#include <QList>
+
+#include "ipaddress.h"
+
+/**
+ * @brief Set of IPv4 and IPv6 addresses
+ *
+ * Each family is stored as a sorted list of disjoint, non-adjacent ranges
+ * of raw integer addresses. Union and difference are linear merges of two
+ * such lists, so excluding thousands of prefixes costs one sort instead of
+ * one pass over the whole result per excluded prefix.
+ */
+class IPRangeSet final {
+ public:
+  IPRangeSet();
+  explicit IPRangeSet(const QList<IPAddress>& list);
+  IPRangeSet(const IPRangeSet& other);
+  IPRangeSet& operator=(const IPRangeSet& other);
+  ~IPRangeSet();
+
+  void add(const IPAddress& ip);
+  void add(const QList<IPAddress>& list);
+  void add(const IPRangeSet& other);
+
+  void remove(const IPAddress& ip);
+  void remove(const QList<IPAddress>& list);
+  void remove(const IPRangeSet& other);
+
+  bool isEmpty() const { return m_ipv4.isEmpty() && m_ipv6.isEmpty(); }
+  bool contains(const QHostAddress& address) const;
+
+  // Returns the smallest list of prefixes covering the set, IPv4 first.
+  QList<IPAddress> toList() const;
+
+ private:
+  // 128-bit unsigned integer. IPv4 addresses only use the low word.
+  struct Uint128 {
+    quint64 m_high = 0;
+    quint64 m_low = 0;
+
+    auto operator<=>(const Uint128& other) const = default;
+
+    // Value with the lowest count bits set.
+    static Uint128 lowBits(int count);
+
+    Uint128 operator|(const Uint128& other) const;
+    Uint128 operator&(const Uint128& other) const;
+    Uint128 operator~() const;
+    Uint128 next() const;
+    Uint128 previous() const;
+    int trailingZeros() const;
+  };
+
+  // Inclusive range of addresses.
+  struct Range {
+    Uint128 m_first;
+    Uint128 m_last;
+  };
+
+  using RangeList = QList<Range>;
+
+  static bool fromIPAddress(const IPAddress& ip, Range& range, bool& ipv6);
+  static void split(const QList<IPAddress>& list, RangeList& ipv4,
+                    RangeList& ipv6);
+  static void normalize(RangeList& ranges);
+  static void appendMerged(RangeList& ranges, const Range& range);
+  static RangeList unite(const RangeList& a, const RangeList& b);
+  static RangeList subtract(const RangeList& a, const RangeList& b);
+  static IPAddress toIPAddress(const Uint128& address, int prefixLength,
+                               bool ipv6);
+  static void appendPrefixes(const Range& range, bool ipv6,
+                             QList<IPAddress>& list);
+
+  RangeList m_ipv4;
+  RangeList m_ipv6;
+};
+
+#endif  // IPRANGESET_H
@@ -0,0 +1,435 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "jsonstreamreader.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Maximum nesting of objects and arrays.
+constexpr qsizetype JSON_MAX_DEPTH = 1024;
+
+// Integers with up to this many digits fit exactly in a double.
+constexpr qsizetype JSON_MAX_EXACT_DIGITS = 15;
+
+JsonStreamReader::JsonStreamReader(QByteArrayView data)
+    : m_pos(data.data()), m_end(data.data() + data.size()) {}
+
+bool JsonStreamReader::fail() {
+  m_error = true;
+  return false;
+}
+
+void JsonStreamReader::skipWhitespace() {
+  while (m_pos < m_end) {
+    switch (*m_pos) {
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+        ++m_pos;
+        break;
+      default:
+        return;
+    }
+  }
+}
+
+bool JsonStreamReader::expect(char c) {
+  skipWhitespace();
+  if (m_pos >= m_end || *m_pos != c) {
+    return fail();
+  }
+  ++m_pos;
+  return true;
+}
+
+JsonStreamReader::Type JsonStreamReader::peek() {
+  if (m_error) {
+    return Invalid;
+  }
+
+  skipWhitespace();
+  if (m_pos >= m_end) {
+    return Invalid;
+  }
+
+  switch (*m_pos) {
+    case '{':
+      return Object;
+    case '[':
+      return Array;
+    case '"':
+      return String;
+    case 't':
+    case 'f':
+      return Bool;
+    case 'n':
+      return Null;
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+      return Number;
+    default:
+      return Invalid;
+  }
+}
+
+bool JsonStreamReader::enterObject() {
+  if (peek() != Object || m_first.size() >= JSON_MAX_DEPTH) {
+    return fail();
+  }
+  ++m_pos;
+  m_first.append(true);
+  return true;
+}
+
+bool JsonStreamReader::enterArray() {
+  if (peek() != Array || m_first.size() >= JSON_MAX_DEPTH) {
+    return fail();
+  }
+  ++m_pos;
+  m_first.append(true);
+  return true;
+}
+
+bool JsonStreamReader::nextMember(char close) {
+  if (m_error || m_first.isEmpty()) {
+    return fail();
+  }
+
+  skipWhitespace();
+  if (m_pos >= m_end) {
+    return fail();
+  }
+
+  if (m_first.last()) {
+    m_first.last() = false;
+    if (*m_pos == close) {
+      ++m_pos;
+      m_first.removeLast();
+      return false;
+    }
+    return true;
+  }
+
+  if (*m_pos == close) {
+    ++m_pos;
+    m_first.removeLast();
+    return false;
+  }
+
+  if (*m_pos != ',') {
+    return fail();
+  }
+  ++m_pos;
+  return true;
+}
+
+bool JsonStreamReader::nextKey(QByteArrayView& key) {
+  if (!nextMember('}')) {
+    return false;
+  }
+
+  skipWhitespace();
+  QByteArrayView raw;
+  bool escaped = false;
+  if (!scanString(raw, escaped)) {
+    return false;
+  }
+
+  if (escaped) {
+    QString decoded;
+    if (!unescape(raw, decoded)) {
+      return false;
+    }
+    m_keyBuffer = decoded.toUtf8();
+    key = m_keyBuffer;
+  } else {
+    key = raw;
+  }
+
+  return expect(':');
+}
+
+bool JsonStreamReader::nextElement() { return nextMember(']'); }
+
+bool JsonStreamReader::scanString(QByteArrayView& raw, bool& escaped) {
+  if (m_pos >= m_end || *m_pos != '"') {
+    return fail();
+  }
+
+  const char* start = ++m_pos;
+  while (m_pos < m_end) {
+    const char c = *m_pos;
+    if (c == '"') {
+      raw = QByteArrayView(start, m_pos - start);
+      ++m_pos;
+      return true;
+    }
+    if (c == '\\') {
+      escaped = true;
+      m_pos += 2;
+      continue;
+    }
+    if (static_cast<unsigned char>(c) < 0x20) {
+      return fail();
+    }
+    ++m_pos;
+  }
+
+  return fail();
+}
+
+bool JsonStreamReader::unescape(QByteArrayView raw, QString& value) {
+  value.clear();
+  value.reserve(raw.size());
+
+  const char* pos = raw.data();
+  const char* end = raw.data() + raw.size();
+  while (pos < end) {
+    const char* run = pos;
+    while (pos < end && *pos != '\\') {
+      ++pos;
+    }
+    if (pos > run) {
+      value.append(QString::fromUtf8(run, pos - run));
+    }
+    if (pos >= end) {
+      break;
+    }
+
+    // scanString() guarantees a character after the backslash.
+    ++pos;
+    switch (*pos++) {
+      case '"':
+        value.append(QLatin1Char('"'));
+        break;
+      case '\\':
+        value.append(QLatin1Char('\\'));
+        break;
+      case '/':
+        value.append(QLatin1Char('/'));
+        break;
+      case 'b':
+        value.append(QLatin1Char('\b'));
+        break;
+      case 'f':
+        value.append(QLatin1Char('\f'));
+        break;
+      case 'n':
+        value.append(QLatin1Char('\n'));
+        break;
+      case 'r':
+        value.append(QLatin1Char('\r'));
+        break;
+      case 't':
+        value.append(QLatin1Char('\t'));
+        break;
+      case 'u': {
+        if ((end - pos) < 4) {
+          return fail();
+        }
+        char16_t unit = 0;
+        for (int i = 0; i < 4; ++i) {
+          const char c = *pos++;
+          unit <<= 4;
+          if (c >= '0' && c <= '9') {
+            unit |= c - '0';
+          } else if (c >= 'a' && c <= 'f') {
+            unit |= c - 'a' + 10;
+          } else if (c >= 'A' && c <= 'F') {
+            unit |= c - 'A' + 10;
+          } else {
+            return fail();
+          }
+        }
+        // Surrogate pairs come as two escapes, and are appended as is.
+        value.append(QChar(unit));
+        break;
+      }
+      default:
+        return fail();
+    }
+  }
+
+  return true;
+}
+
+bool JsonStreamReader::scanNumber(QByteArrayView& raw) {
+  auto isDigit = [this]() {
+    return m_pos < m_end && *m_pos >= '0' && *m_pos <= '9';
+  };
+  auto skipDigits = [&]() {
+    if (!isDigit()) {
+      return false;
+    }
+    while (isDigit()) {
+      ++m_pos;
+    }
+    return true;
+  };
+
+  const char* start = m_pos;
+  if (m_pos < m_end && *m_pos == '-') {
+    ++m_pos;
+  }
+  if (m_pos < m_end && *m_pos == '0') {
+    ++m_pos;
+  } else if (!skipDigits()) {
+    return fail();
+  }
+  if (m_pos < m_end && *m_pos == '.') {
+    ++m_pos;
+    if (!skipDigits()) {
+      return fail();
+    }
+  }
+  if (m_pos < m_end && (*m_pos == 'e' || *m_pos == 'E')) {
+    ++m_pos;
+    if (m_pos < m_end && (*m_pos == '+' || *m_pos == '-')) {
+      ++m_pos;
+    }
+    if (!skipDigits()) {
+      return fail();
+    }
+  }
+
+  raw = QByteArrayView(start, m_pos - start);
+  return true;
+}
+
+bool JsonStreamReader::scanLiteral(QByteArrayView literal) {
+  if ((m_end - m_pos) < literal.size() ||
+      memcmp(m_pos, literal.data(), literal.size()) != 0) {
+    return fail();
+  }
+  m_pos += literal.size();
+  return true;
+}
+
+bool JsonStreamReader::readString(QString& value) {
+  if (peek() != String) {
+    return fail();
+  }
+
+  QByteArrayView raw;
+  bool escaped = false;
+  if (!scanString(raw, escaped)) {
+    return false;
+  }
+
+  if (escaped) {
+    return unescape(raw, value);
+  }
+
+  value = QString::fromUtf8(raw);
+  return true;
+}
+
+bool JsonStreamReader::readDouble(double& value) {
+  if (peek() != Number) {
+    return fail();
+  }
+
+  QByteArrayView raw;
+  if (!scanNumber(raw)) {
+    return false;
+  }
+
+  // Integers, which is what most documents are made of, are converted
+  // directly as long as they are exactly representable.
+  const bool negative = raw.startsWith('-');
+  QByteArrayView digits = negative ? raw.sliced(1) : raw;
+  if (digits.size() <= JSON_MAX_EXACT_DIGITS &&
+      std::all_of(digits.begin(), digits.end(),
+                  [](char c) { return c >= '0' && c <= '9'; })) {
+    qint64 integer = 0;
+    for (char c : digits) {
+      integer = integer * 10 + (c - '0');
+    }
+    value = static_cast<double>(negative ? -integer : integer);
+    return true;
+  }
+
+  bool ok = false;
+  value = QByteArray::fromRawData(raw.data(), raw.size()).toDouble(&ok);
+  return ok || fail();
+}
+
+bool JsonStreamReader::readBool(bool& value) {
+  if (peek() != Bool) {
+    return fail();
+  }
+
+  value = *m_pos == 't';
+  return scanLiteral(value ? "true" : "false");
+}
+
+bool JsonStreamReader::skipValue() {
+  switch (peek()) {
+    case Null:
+      return scanLiteral("null");
+
+    case Bool: {
+      bool value;
+      return readBool(value);
+    }
+
+    case Number: {
+      QByteArrayView raw;
+      return scanNumber(raw);
+    }
+
+    case String: {
+      QByteArrayView raw;
+      bool escaped = false;
+      return scanString(raw, escaped);
+    }
+
+    case Array:
+      if (!enterArray()) {
+        return false;
+      }
+      while (nextElement()) {
+        if (!skipValue()) {
+          return false;
+        }
+      }
+      return !m_error;
+
+    case Object: {
+      if (!enterObject()) {
+        return false;
+      }
+      QByteArrayView key;
+      while (nextKey(key)) {
+        if (!skipValue()) {
+          return false;
+        }
+      }
+      return !m_error;
+    }
+
+    default:
+      return fail();
+  }
+}
+
+bool JsonStreamReader::atEnd() {
+  if (m_error || !m_first.isEmpty()) {
+    return false;
+  }
+
+  skipWhitespace();
+  return m_pos == m_end;
+}
@@ -0,0 +1,89 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef JSONSTREAMREADER_H
+#define JSONSTREAMREADER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <QVarLengthArray>
+
+/**
+ * @brief Pull parser for JSON documents
+ *
+ * Walks a JSON document in place, one token at a time, without building a
+ * QJsonDocument. The caller drives it with the structure it expects:
+ *
+ *   if (!reader.enterObject()) return false;
+ *   QByteArrayView key;
+ *   while (reader.nextKey(key)) {
+ *     if (key == "name") { if (!reader.readString(name)) return false; }
+ *     else if (!reader.skipValue()) return false;
+ *   }
+ *   if (reader.hasError()) return false;
+ *
+ * Once an error has been found, every call fails and hasError() is set. The
+ * data must outlive the reader.
+ */
+class JsonStreamReader final {
+ public:
+  enum Type {
+    Invalid,
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object,
+  };
+
+  explicit JsonStreamReader(QByteArrayView data);
+
+  bool hasError() const { return m_error; }
+
+  // Returns the type of the next value, without consuming it.
+  Type peek();
+
+  // Enter an object, then iterate its members with nextKey(). It returns
+  // false once the end of the object is reached, or on error. Each key must
+  // be followed by reading or skipping its value.
+  bool enterObject();
+  bool nextKey(QByteArrayView& key);
+
+  // Enter an array, then iterate its elements with nextElement(), which
+  // works like nextKey().
+  bool enterArray();
+  bool nextElement();
+
+  bool readString(QString& value);
+  bool readDouble(double& value);
+  bool readBool(bool& value);
+  bool skipValue();
+
+  // True if nothing but whitespace is left after the top-level value.
+  bool atEnd();
+
+ private:
+  bool fail();
+  void skipWhitespace();
+  bool nextMember(char close);
+  bool expect(char c);
+  bool scanString(QByteArrayView& raw, bool& escaped);
+  bool unescape(QByteArrayView raw, QString& value);
+  bool scanNumber(QByteArrayView& raw);
+  bool scanLiteral(QByteArrayView literal);
+
+  const char* m_pos;
+  const char* m_end;
+  bool m_error = false;
+
+  // One entry per open container, true until its first member is read.
+  QVarLengthArray<bool, 16> m_first;
+
+  // Keys containing escape sequences are decoded here.
+  QByteArray m_keyBuffer;
+};
+
+#endif  // JSONSTREAMREADER_H
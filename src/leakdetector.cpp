@@ -5,14 +5,40 @@
 #include "leakdetector.h"
 
 #include <QHash>
+#include <QJsonObject>
 #include <QMutex>
 #include <QObject>
+#include <QPair>
 #include <QTextStream>
 
 #ifdef MZ_DEBUG
-static QMutex s_leakDetector;
+// The live objects are spread across shards by address, so that threads
+// counting different objects rarely wait for each other.
+constexpr size_t LEAK_DETECTOR_SHARDS = 32;
+
+namespace {
+// The same address is counted once per type, for a class and its bases.
+using Allocation = QPair<void*, LeakDetector::Counter*>;
+
+struct Shard {
+  QMutex m_mutex;
+  QHash<Allocation, uint32_t> m_allocations;
+};
+
+Shard* shards() {
+  // Never released: objects can still be destroyed during the static
+  // destruction.
+  static Shard* s_shards = new Shard[LEAK_DETECTOR_SHARDS];
+  return s_shards;
+}
+
+Shard& shardFor(void* ptr) {
+  return shards()[qHash(ptr) % LEAK_DETECTOR_SHARDS];
+}
 
-QHash<QString, QHash<void*, uint32_t>> s_leaks;
+// Every counter created so far, linked through Counter::m_next.
+std::atomic<LeakDetector::Counter*> s_counters{nullptr};
+}  // namespace
 #endif
 
 LeakDetector::LeakDetector() {
@@ -27,49 +53,81 @@ LeakDetector::~LeakDetector() {
 
   out << "== MZ  - Leak report ===================" << Qt::endl;
 
-  bool hasLeaks = false;
-  for (auto i = s_leaks.begin(); i != s_leaks.end(); ++i) {
-    QString className = i.key();
-
-    if (i->size() == 0) {
-      continue;
+  QHash<Counter*, QList<QPair<void*, uint32_t>>> leaks;
+  for (size_t i = 0; i < LEAK_DETECTOR_SHARDS; ++i) {
+    Shard& shard = shards()[i];
+    QMutexLocker lock(&shard.m_mutex);
+    for (auto l = shard.m_allocations.cbegin();
+         l != shard.m_allocations.cend(); ++l) {
+      leaks[l.key().second].append({l.key().first, l.value()});
     }
+  }
 
-    hasLeaks = true;
-    out << className << Qt::endl;
+  for (auto i = leaks.cbegin(); i != leaks.cend(); ++i) {
+    out << i.key()->m_typeName << Qt::endl;
 
-    for (auto l = i->begin(); l != i->end(); ++l) {
-      out << "  - ptr: " << l.key() << " size:" << l.value() << Qt::endl;
+    for (const QPair<void*, uint32_t>& leak : i.value()) {
+      out << "  - ptr: " << leak.first << " size:" << leak.second
+          << Qt::endl;
     }
   }
 
-  if (!hasLeaks) {
+  if (leaks.isEmpty()) {
     out << "No leaks detected." << Qt::endl;
   }
 #endif
 }
 
 #ifdef MZ_DEBUG
-void LeakDetector::logCtor(void* ptr, const char* typeName, uint32_t size) {
-  QMutexLocker lock(&s_leakDetector);
-
-  QString type(typeName);
-  if (!s_leaks.contains(type)) {
-    s_leaks.insert(type, QHash<void*, uint32_t>());
+LeakDetector::Counter::Counter(const char* typeName) : m_typeName(typeName) {
+  m_next = s_counters.load();
+  while (!s_counters.compare_exchange_weak(m_next, this)) {
   }
+}
 
-  s_leaks[type].insert(ptr, size);
+// static
+void LeakDetector::logCtor(Counter* counter, void* ptr, uint32_t size) {
+  counter->m_alive.fetch_add(1, std::memory_order_relaxed);
+  counter->m_created.fetch_add(1, std::memory_order_relaxed);
+  counter->m_aliveBytes.fetch_add(size, std::memory_order_relaxed);
+
+  Shard& shard = shardFor(ptr);
+  QMutexLocker lock(&shard.m_mutex);
+  shard.m_allocations.insert({ptr, counter}, size);
 }
 
-void LeakDetector::logDtor(void* ptr, const char* typeName, uint32_t size) {
-  QMutexLocker lock(&s_leakDetector);
+// static
+void LeakDetector::logDtor(Counter* counter, void* ptr, uint32_t size) {
+  counter->m_alive.fetch_sub(1, std::memory_order_relaxed);
+  counter->m_aliveBytes.fetch_sub(size, std::memory_order_relaxed);
+
+  Shard& shard = shardFor(ptr);
+  QMutexLocker lock(&shard.m_mutex);
+
+  auto i = shard.m_allocations.find({ptr, counter});
+  if (i == shard.m_allocations.end()) {
+    Q_ASSERT(false);
+    return;
+  }
 
-  QString type(typeName);
-  Q_ASSERT(s_leaks.contains(type));
+  Q_ASSERT(i.value() == size);
+  shard.m_allocations.erase(i);
+}
+
+// static
+QJsonObject LeakDetector::countersToJson() {
+  QJsonObject obj;
+
+  for (Counter* counter = s_counters.load(); counter;
+       counter = counter->m_next) {
+    QJsonObject entry;
+    entry["alive"] = counter->m_alive.load(std::memory_order_relaxed);
+    entry["created"] = counter->m_created.load(std::memory_order_relaxed);
+    entry["aliveBytes"] =
+        counter->m_aliveBytes.load(std::memory_order_relaxed);
+    obj[counter->m_typeName] = entry;
+  }
 
-  QHash<void*, uint32_t>& leak = s_leaks[type];
-  Q_ASSERT(leak.contains(ptr));
-  Q_ASSERT(leak[ptr] == size);
-  leak.remove(ptr);
+  return obj;
 }
 #endif
@@ -8,18 +8,22 @@
 #include <QObject>
 
 #ifdef MZ_DEBUG
-#  define MZ_COUNT_CTOR(_type)                                   \
-    do {                                                         \
-      static_assert(std::is_class<_type>(),                      \
-                    "Token '" #_type "' is not a class type.");  \
-      LeakDetector::logCtor((void*)this, #_type, sizeof(*this)); \
+#  include <atomic>
+
+#  define MZ_COUNT_CTOR(_type)                                    \
+    do {                                                          \
+      static_assert(std::is_class<_type>(),                       \
+                    "Token '" #_type "' is not a class type.");   \
+      LeakDetector::logCtor(LeakDetector::counter<_type>(#_type), \
+                            (void*)this, sizeof(*this));          \
     } while (0)
 
-#  define MZ_COUNT_DTOR(_type)                                   \
-    do {                                                         \
-      static_assert(std::is_class<_type>(),                      \
-                    "Token '" #_type "' is not a class type.");  \
-      LeakDetector::logDtor((void*)this, #_type, sizeof(*this)); \
+#  define MZ_COUNT_DTOR(_type)                                    \
+    do {                                                          \
+      static_assert(std::is_class<_type>(),                       \
+                    "Token '" #_type "' is not a class type.");   \
+      LeakDetector::logDtor(LeakDetector::counter<_type>(#_type), \
+                            (void*)this, sizeof(*this));          \
     } while (0)
 
 #else
@@ -27,14 +31,37 @@
 #  define MZ_COUNT_DTOR(_type)
 #endif
 
+class QJsonObject;
+
 class LeakDetector {
  public:
   LeakDetector();
   ~LeakDetector();
 
 #ifdef MZ_DEBUG
-  static void logCtor(void* ptr, const char* typeName, uint32_t size);
-  static void logDtor(void* ptr, const char* typeName, uint32_t size);
+  // Instances of one counted type. Each type gets its counter the first time
+  // it is counted, and keeps it until the process exits.
+  struct Counter {
+    explicit Counter(const char* typeName);
+
+    const char* const m_typeName;
+    std::atomic<qint64> m_alive{0};
+    std::atomic<qint64> m_created{0};
+    std::atomic<qint64> m_aliveBytes{0};
+    Counter* m_next = nullptr;
+  };
+
+  template <typename T>
+  static Counter* counter(const char* typeName) {
+    static Counter s_counter(typeName);
+    return &s_counter;
+  }
+
+  static void logCtor(Counter* counter, void* ptr, uint32_t size);
+  static void logDtor(Counter* counter, void* ptr, uint32_t size);
+
+  // Alive, created and alive bytes of each type counted so far.
+  static QJsonObject countersToJson();
 #endif
 };
 
@@ -6,7 +6,6 @@
 
 #include <stdint.h>
 
-#include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
 #include <QMetaType>
@@ -113,6 +112,10 @@ void LocalSocketController::initializeInternal() {
 
   logger.debug() << "Connecting to:" << m_path;
   m_socket->abort();
+
+  // The framing is negotiated again with whichever daemon answers.
+  m_framing = DaemonFraming();
+  m_binary = false;
   m_socket->connectToServer(m_path);
 }
 
@@ -160,6 +163,7 @@ void LocalSocketController::checkStatus() {
 
     QJsonObject json;
     json.insert("type", "status");
+    json.insert("framing", DaemonFraming::VERSION);
     write(json, "status");
   }
 }
@@ -203,37 +207,22 @@ void LocalSocketController::readData() {
 
   Q_ASSERT(m_socket);
   Q_ASSERT(m_daemonState == eInitializing || m_daemonState == eReady);
-  QByteArray input = m_socket->readAll();
-  m_buffer.append(input);
-
-  while (true) {
-    int pos = m_buffer.indexOf("\n");
-    if (pos == -1) {
-      break;
-    }
-
-    QByteArray line = m_buffer.left(pos);
-    m_buffer.remove(0, pos + 1);
-
-    QByteArray command(line);
-    command = command.trimmed();
-
-    if (command.isEmpty()) {
-      continue;
-    }
+  m_framing.append(m_socket->readAll());
 
-    parseCommand(command);
+  QJsonObject obj;
+  bool binary = false;
+  while (m_framing.next(obj, binary)) {
+    parseCommand(obj, binary);
   }
-}
 
-void LocalSocketController::parseCommand(const QByteArray& command) {
-  QJsonDocument json = QJsonDocument::fromJson(command);
-  if (!json.isObject()) {
-    logger.error() << "Invalid JSON - object expected";
-    return;
+  if (m_framing.corrupted()) {
+    logger.error() << "Corrupted stream - closing the connection";
+    m_socket->abort();
   }
+}
 
-  QJsonObject obj = json.object();
+void LocalSocketController::parseCommand(const QJsonObject& obj,
+                                         bool binary) {
   QJsonValue typeValue = obj.value("type");
   if (!typeValue.isString()) {
     logger.error() << "Invalid JSON - no type";
@@ -244,6 +233,11 @@ void LocalSocketController::parseCommand(const QByteArray& command) {
   logger.debug() << "Parse command:" << type;
   clearTimeout(type);
 
+  if (type == "status" &&
+      obj.value("framing").toInt() == DaemonFraming::VERSION) {
+    m_binary = true;
+  }
+
   if (m_daemonState == eInitializing && type == "status") {
     m_daemonState = eReady;
 
@@ -340,20 +334,22 @@ void LocalSocketController::parseCommand(const QByteArray& command) {
     }
 
     QJsonValue logs = obj.value("logs");
-    m_logCallback(logs.isString() ? logs.toString().replace("|", "\n")
-                                  : QString());
+    QString text = logs.toString();
+    if (!binary) {
+      text.replace("|", "\n");
+    }
+    m_logCallback(text);
     m_logCallback = nullptr;
     return;
   }
 
-  logger.warning() << "Invalid command received:" << command;
+  logger.warning() << "Invalid command received:" << type;
 }
 
 void LocalSocketController::write(const QJsonObject& message,
                                   const QString& expectedResponseType,
                                   int timeout) {
-  QByteArray payload = QJsonDocument(message).toJson(QJsonDocument::Compact);
-  payload.append('\n');
+  QByteArray payload = DaemonFraming::encode(message, m_binary);
 
   // If an immediate response to this message is expected, start a timer to
   // throw an error if that response fails to arrive in a timely manner. This
@@ -10,6 +10,7 @@
 #include <functional>
 
 #include "controllerimpl.h"
+#include "daemon/daemonframing.h"
 
 class QJsonObject;
 
@@ -49,7 +50,7 @@ class LocalSocketController final : public ControllerImpl {
   void daemonConnected();
   void errorOccurred(QLocalSocket::LocalSocketError socketError);
   void readData();
-  void parseCommand(const QByteArray& command);
+  void parseCommand(const QJsonObject& obj, bool binary);
   void clearTimeout(const QString& responseType);
   void clearAllTimeouts();
 
@@ -77,7 +78,10 @@ class LocalSocketController final : public ControllerImpl {
   const QString m_path;
   QLocalSocket* m_socket = nullptr;
 
-  QByteArray m_buffer;
+  DaemonFraming m_framing;
+
+  // True once the daemon has advertised the binary framing.
+  bool m_binary = false;
 
   std::function<void(const QString&)> m_logCallback = nullptr;
 
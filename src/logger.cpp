@@ -11,46 +11,117 @@
 
 Logger::Logger(const QString& className) : m_className(className) {}
 
+Logger::Log Logger::log(LogLevel level) { return Log(this, level); }
 Logger::Log Logger::error() { return Log(this, LogLevel::Error); }
 Logger::Log Logger::warning() { return Log(this, LogLevel::Warning); }
 Logger::Log Logger::info() { return Log(this, LogLevel::Info); }
 Logger::Log Logger::debug() { return Log(this, LogLevel::Debug); }
 
 Logger::Log::Log(Logger* logger, LogLevel logLevel)
-    : m_logger(logger), m_logLevel(logLevel), m_data(new Data()) {}
+    : m_logger(logger),
+      m_logLevel(logLevel),
+      m_enabled(Logger::isEnabled(logLevel)) {}
 
 Logger::Log::~Log() {
+  if (!m_enabled) {
+    return;
+  }
+
+  // Handed over as a view of the buffer: queued records are copied straight
+  // into the log ring.
+  QStringView message(m_buffer.constData(), m_buffer.size());
   LogHandler::messageHandler(m_logLevel, m_logger->className(),
-                             m_data->m_buffer.trimmed());
-  delete m_data;
+                             message.trimmed());
+}
+
+void Logger::Log::append(QStringView value) {
+  m_buffer.append(value.data(), value.size());
+  m_buffer.append(QLatin1Char(' '));
 }
 
-#define CREATE_LOG_OP_REF(x)                  \
-  Logger::Log& Logger::Log::operator<<(x t) { \
-    m_data->m_ts << t << ' ';                 \
-    return *this;                             \
+void Logger::Log::appendUtf8(const char* value, qsizetype length) {
+  // Most of what gets logged is plain ASCII, which maps directly to UTF-16.
+  for (qsizetype i = 0; i < length; ++i) {
+    if (static_cast<unsigned char>(value[i]) >= 0x80) {
+      QString decoded = QString::fromUtf8(value + i, length - i);
+      m_buffer.append(decoded.constData(), decoded.size());
+      break;
+    }
+    m_buffer.append(QLatin1Char(value[i]));
   }
+  m_buffer.append(QLatin1Char(' '));
+}
+
+Logger::Log& Logger::Log::operator<<(uint64_t t) {
+  if (!m_enabled) {
+    return *this;
+  }
+
+  QChar digits[20];
+  qsizetype pos = sizeof(digits) / sizeof(QChar);
+  do {
+    digits[--pos] = QChar(static_cast<char16_t>(u'0' + (t % 10)));
+    t /= 10;
+  } while (t > 0);
+  append(QStringView(digits + pos, std::end(digits)));
+  return *this;
+}
 
-CREATE_LOG_OP_REF(uint64_t);
-CREATE_LOG_OP_REF(const char*);
-CREATE_LOG_OP_REF(const QString&);
-CREATE_LOG_OP_REF(const QByteArray&);
-CREATE_LOG_OP_REF(const void*);
+Logger::Log& Logger::Log::operator<<(const char* t) {
+  if (m_enabled) {
+    appendUtf8(t, t ? qstrlen(t) : 0);
+  }
+  return *this;
+}
 
-#undef CREATE_LOG_OP_REF
+Logger::Log& Logger::Log::operator<<(const QString& t) {
+  if (m_enabled) {
+    append(t);
+  }
+  return *this;
+}
+
+Logger::Log& Logger::Log::operator<<(const QByteArray& t) {
+  if (m_enabled) {
+    appendUtf8(t.constData(), t.length());
+  }
+  return *this;
+}
+
+Logger::Log& Logger::Log::operator<<(const void* t) {
+  if (m_enabled) {
+    append(QString("0x%1").arg(reinterpret_cast<quintptr>(t), 0, 16));
+  }
+  return *this;
+}
 
 Logger::Log& Logger::Log::operator<<(const QStringList& t) {
-  m_data->m_ts << '[' << t.join(",") << ']' << ' ';
+  if (m_enabled) {
+    append("[" + t.join(",") + "]");
+  }
   return *this;
 }
 
 Logger::Log& Logger::Log::operator<<(const QJsonObject& t) {
-  m_data->m_ts << QJsonDocument(t).toJson(QJsonDocument::Indented) << ' ';
+  if (m_enabled) {
+    append(QString::fromUtf8(QJsonDocument(t).toJson(QJsonDocument::Indented)));
+  }
   return *this;
 }
 
+// Only the output of a manipulator is kept, such as the newline of
+// Qt::endl. Changes to the number formatting are not carried over.
 Logger::Log& Logger::Log::operator<<(QTextStreamFunction t) {
-  m_data->m_ts << t;
+  if (!m_enabled) {
+    return *this;
+  }
+
+  QString output;
+  {
+    QTextStream ts(&output, QIODevice::WriteOnly);
+    ts << t;
+  }
+  m_buffer.append(output.constData(), output.size());
   return *this;
 }
 
@@ -78,6 +149,10 @@ QString Logger::keys(const QString& input) {
 
 void Logger::Log::addMetaEnum(quint64 value, const QMetaObject* meta,
                               const char* name) {
+  if (!m_enabled) {
+    return;
+  }
+
   QMetaEnum me = meta->enumerator(meta->indexOfEnumerator(name));
 
   QString out;
@@ -99,5 +174,5 @@ void Logger::Log::addMetaEnum(quint64 value, const QMetaObject* meta,
     ts << value << ")";
   }
 
-  m_data->m_ts << out << ' ';
+  append(out);
 }
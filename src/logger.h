@@ -9,21 +9,52 @@
 #include <QObject>
 #include <QString>
 #include <QTextStream>
+#include <QVarLengthArray>
+#include <atomic>
 
 #include "loglevel.h"
 
 class QJsonObject;
 
+// Log statements below this level are compiled out. Define it to one of the
+// LogLevel values to strip the more verbose levels from a build.
+#ifndef MZ_LOG_MIN_LEVEL
+#  define MZ_LOG_MIN_LEVEL Trace
+#endif
+
+// Like logger.debug() and friends, but the arguments are only evaluated when
+// the level is enabled:
+//   MZ_LOG(logger, Debug) << "Peer:" << logger.keys(publicKey);
+#define MZ_LOG(logger, level)      \
+  if (!Logger::isEnabled(level)) { \
+  } else                           \
+    (logger).log(level)
+
 class Logger {
  public:
   Logger(const QString& className);
 
   const QString& className() const { return m_className; }
 
+  static constexpr bool isCompiledIn(LogLevel level) {
+    return level >= MZ_LOG_MIN_LEVEL;
+  }
+
+  static bool isEnabled(LogLevel level) {
+    return isCompiledIn(level) &&
+           (level >= s_minLevel.load(std::memory_order_relaxed));
+  }
+
+  // Discard log statements below this level at runtime.
+  static void setMinLevel(LogLevel level) {
+    s_minLevel.store(level, std::memory_order_relaxed);
+  }
+
   class Log {
    public:
     Log(Logger* logger, LogLevel level);
     ~Log();
+    Q_DISABLE_COPY_MOVE(Log)
 
     Log& operator<<(uint64_t t);
     Log& operator<<(const char* t);
@@ -38,6 +69,9 @@ class Logger {
     template <typename T>
     typename std::enable_if<QtPrivate::IsQEnumHelper<T>::Value, Log&>::type
     operator<<(T t) {
+      if (!m_enabled) {
+        return *this;
+      }
       const QMetaObject* meta = qt_getEnumMetaObject(t);
       const char* name = qt_getEnumName(t);
       addMetaEnum(typename QFlags<T>::Int(t), meta, name);
@@ -47,19 +81,20 @@ class Logger {
    private:
     void addMetaEnum(quint64 value, const QMetaObject* meta, const char* name);
 
+    // Append a value to the message, followed by a separator.
+    void append(QStringView value);
+    void appendUtf8(const char* value, qsizetype length);
+
     Logger* m_logger;
     LogLevel m_logLevel;
+    bool m_enabled;
 
-    struct Data {
-      Data() : m_ts(&m_buffer, QIODevice::WriteOnly) {}
-
-      QString m_buffer;
-      QTextStream m_ts;
-    };
-
-    Data* m_data;
+    // Log statements are temporaries, so short messages are formatted on the
+    // stack and only spill to the heap when they outgrow this buffer.
+    QVarLengthArray<QChar, 256> m_buffer;
   };
 
+  Log log(LogLevel level);
   Log error();
   Log warning();
   Log info();
@@ -75,6 +110,8 @@ class Logger {
 
  private:
   QString m_className;
+
+  static inline std::atomic<LogLevel> s_minLevel = Trace;
 };
 
 #endif  // LOGGER_H
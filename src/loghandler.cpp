@@ -8,13 +8,23 @@
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QList>
 #include <QMessageLogContext>
+#include <QMetaMethod>
 #include <QProcessEnvironment>
 #include <QScopeGuard>
+#include <QSemaphore>
 #include <QStandardPaths>
 #include <QString>
 #include <QTextStream>
+#include <QThread>
 #include <QUrl>
+#include <QtEndian>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <utility>
 
 #include "constants.h"
 #include "feature/feature.h"
@@ -34,12 +44,322 @@
 
 constexpr qint64 LOG_MAX_FILE_SIZE = 204800;
 
+// Number of records buffered by the asynchronous writer. Must be a power of
+// two. Producers drain the ring themselves when it fills up.
+constexpr quint64 LOG_RING_SIZE = 1024;
+static_assert((LOG_RING_SIZE & (LOG_RING_SIZE - 1)) == 0);
+
+// UTF-16 code units available for the strings of a record in the ring, about
+// 1 KiB per slot. Longer records are written synchronously.
+constexpr qsizetype LOG_RECORD_TEXT_SIZE = 480;
+
+// Records logged while a record is written out, e.g. by a slot connected to
+// logEntryAdded(), are set aside and written right after it. A slot logging
+// something for every record would otherwise never let the write end.
+constexpr qsizetype LOG_MAX_PENDING_LOGS = 64;
+
+// How long the asynchronous writer sleeps when it has nothing to do.
+constexpr int LOG_WRITER_IDLE_MSEC = 1000;
+
+// Binary log segments. The active segment is rotated once it reaches half
+// of LOG_MAX_FILE_SIZE, replacing the previous one, so that at most
+// LOG_MAX_FILE_SIZE bytes are kept on disk without ever rewriting a file.
+//
+// A segment starts with LOG_SEGMENT_MAGIC and a little-endian quint32
+// version, followed by records. Every record is a quint32 payload length
+// and the payload: a qint64 timestamp in msecs since the epoch, a quint8
+// log level, a quint8 "from Qt" flag, a qint32 line number and then the
+// class name, file, function and message as quint32-length-prefixed UTF-8.
+// See tools/logviewer/logsegment.js for the decoder.
+constexpr const char* LOG_SEGMENT_FILE_NAME = "mozillavpn.log.seg";
+constexpr const char* LOG_SEGMENT_PREVIOUS_FILE_NAME = "mozillavpn.log.1.seg";
+constexpr const char LOG_SEGMENT_MAGIC[] = "MZLOGSEG";
+constexpr qsizetype LOG_SEGMENT_MAGIC_SIZE = sizeof(LOG_SEGMENT_MAGIC) - 1;
+constexpr quint32 LOG_SEGMENT_VERSION = 1;
+constexpr qsizetype LOG_SEGMENT_HEADER_SIZE = LOG_SEGMENT_MAGIC_SIZE + 4;
+constexpr qsizetype LOG_SEGMENT_RECORD_FIXED_SIZE = 8 + 1 + 1 + 4 + (4 * 4);
+
 namespace {
 QMutex s_mutex;
 QString s_location =
     QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
 LogHandler* s_instance = nullptr;
 
+// A log record copied into a fixed-size slot of the ring, so that producers
+// never allocate. The class name, file, function and message are stored back
+// to back in m_text, as UTF-16.
+struct LogRecord {
+  qint64 m_timestamp;
+  qint32 m_line;
+  LogLevel m_logLevel;
+  bool m_fromQT;
+  quint16 m_lengths[4];
+  char16_t m_text[LOG_RECORD_TEXT_SIZE];
+
+  // Whether the strings fit in a slot. The Latin-1 views must also be plain
+  // ASCII, which file and function names are.
+  static bool fits(QStringView className, QLatin1String file,
+                   QLatin1String function, QStringView message) {
+    qsizetype size =
+        className.size() + file.size() + function.size() + message.size();
+    if (size > LOG_RECORD_TEXT_SIZE) {
+      return false;
+    }
+
+    for (QLatin1String value : {file, function}) {
+      for (char c : value) {
+        if (static_cast<uchar>(c) >= 0x80) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  void fill(LogLevel logLevel, bool fromQT, QStringView className,
+            QLatin1String file, QLatin1String function, qint32 line,
+            QStringView message) {
+    Q_ASSERT(fits(className, file, function, message));
+
+    char16_t* out = m_text;
+    memcpy(out, className.utf16(), className.size() * sizeof(char16_t));
+    out += className.size();
+    for (QLatin1String value : {file, function}) {
+      for (char c : value) {
+        *out++ = static_cast<char16_t>(c);
+      }
+    }
+    memcpy(out, message.utf16(), message.size() * sizeof(char16_t));
+
+    m_timestamp = QDateTime::currentMSecsSinceEpoch();
+    m_line = line;
+    m_logLevel = logLevel;
+    m_fromQT = fromQT;
+    m_lengths[0] = static_cast<quint16>(className.size());
+    m_lengths[1] = static_cast<quint16>(file.size());
+    m_lengths[2] = static_cast<quint16>(function.size());
+    m_lengths[3] = static_cast<quint16>(message.size());
+  }
+
+  void toLog(LogHandler::Log& log) const {
+    const QChar* text = reinterpret_cast<const QChar*>(m_text);
+    QString* fields[] = {&log.m_className, &log.m_file, &log.m_function,
+                         &log.m_message};
+    for (int i = 0; i < 4; ++i) {
+      *fields[i] = QString(text, m_lengths[i]);
+      text += m_lengths[i];
+    }
+
+    log.m_timestamp = m_timestamp;
+    log.m_line = m_line;
+    log.m_logLevel = m_logLevel;
+    log.m_fromQT = m_fromQT;
+  }
+};
+
+// Bounded multi-producer ring of log records. Each slot carries a sequence
+// number telling whether it is free for the producer claiming that position
+// or holds a record for the consumer. Producers never take a lock, the
+// single consumer is serialized by s_mutex.
+class LogRing final {
+ public:
+  LogRing() : m_slots(new Slot[LOG_RING_SIZE]) {
+    for (quint64 i = 0; i < LOG_RING_SIZE; ++i) {
+      m_slots[i].m_sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Claims a slot and lets `fill` write the record into it. Returns false if
+  // the ring is full.
+  template <typename F>
+  bool push(F&& fill) {
+    quint64 pos = m_head.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot& slot = m_slots[pos & (LOG_RING_SIZE - 1)];
+      quint64 seq = slot.m_sequence.load(std::memory_order_acquire);
+      qint64 diff = static_cast<qint64>(seq - pos);
+      if (diff == 0) {
+        if (m_head.compare_exchange_weak(pos, pos + 1,
+                                         std::memory_order_relaxed)) {
+          fill(slot.m_record);
+          slot.m_sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool pop(LogHandler::Log& log) {
+    quint64 pos = m_tail.load(std::memory_order_relaxed);
+    Slot& slot = m_slots[pos & (LOG_RING_SIZE - 1)];
+    if (slot.m_sequence.load(std::memory_order_acquire) != pos + 1) {
+      return false;
+    }
+    slot.m_record.toLog(log);
+    slot.m_sequence.store(pos + LOG_RING_SIZE, std::memory_order_release);
+    m_tail.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool isEmpty() const {
+    quint64 pos = m_tail.load(std::memory_order_relaxed);
+    const Slot& slot = m_slots[pos & (LOG_RING_SIZE - 1)];
+    return slot.m_sequence.load(std::memory_order_acquire) != pos + 1;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<quint64> m_sequence;
+    LogRecord m_record;
+  };
+  std::unique_ptr<Slot[]> m_slots;
+
+  alignas(64) std::atomic<quint64> m_head = 0;
+  alignas(64) std::atomic<quint64> m_tail = 0;
+};
+
+// Allocated the first time the asynchronous mode is enabled, and then kept
+// around so that records queued while it gets disabled are not lost.
+LogRing* s_logRing = nullptr;
+// Set while the asynchronous mode is enabled.
+std::atomic<LogRing*> s_activeRing = nullptr;
+
+QThread* s_writer = nullptr;
+QSemaphore s_writerWakeup;
+std::atomic<bool> s_writerIdle = false;
+std::atomic<bool> s_writerStop = false;
+
+// Set while this thread writes a record out, with s_mutex held. A record
+// logged from there can't take s_mutex again.
+thread_local bool s_writing = false;
+// Records set aside while s_writing was set. See LOG_MAX_PENDING_LOGS.
+thread_local QList<LogHandler::Log> s_pendingLogs;
+
+bool s_binaryFormat = false;
+
+template <typename T>
+void appendInteger(QByteArray& buffer, T value) {
+  T le = qToLittleEndian(value);
+  buffer.append(reinterpret_cast<const char*>(&le), sizeof(T));
+}
+
+void appendString(QByteArray& buffer, const QString& value) {
+  QByteArray utf8 = value.toUtf8();
+  appendInteger<quint32>(buffer, static_cast<quint32>(utf8.length()));
+  buffer.append(utf8);
+}
+
+QByteArray encodeLog(const LogHandler::Log& log) {
+  QByteArray payload;
+  payload.reserve(LOG_SEGMENT_RECORD_FIXED_SIZE + log.m_message.length());
+  appendInteger<qint64>(payload, log.m_timestamp);
+  appendInteger<quint8>(payload, static_cast<quint8>(log.m_logLevel));
+  appendInteger<quint8>(payload, log.m_fromQT ? 1 : 0);
+  appendInteger<qint32>(payload, log.m_line);
+  appendString(payload, log.m_className);
+  appendString(payload, log.m_file);
+  appendString(payload, log.m_function);
+  appendString(payload, log.m_message);
+
+  QByteArray record;
+  record.reserve(4 + payload.length());
+  appendInteger<quint32>(record, static_cast<quint32>(payload.length()));
+  record.append(payload);
+  return record;
+}
+
+class SegmentReader final {
+ public:
+  SegmentReader(const char* data, qsizetype size)
+      : m_pos(data), m_end(data + size) {}
+
+  quint64 remaining() const { return static_cast<quint64>(m_end - m_pos); }
+
+  template <typename T>
+  bool readInteger(T& value) {
+    if (remaining() < sizeof(T)) {
+      return false;
+    }
+    value = qFromLittleEndian<T>(m_pos);
+    m_pos += sizeof(T);
+    return true;
+  }
+
+  bool readString(QString& value) {
+    quint32 length;
+    if (!readInteger(length) || (remaining() < length)) {
+      return false;
+    }
+    value = QString::fromUtf8(m_pos, length);
+    m_pos += length;
+    return true;
+  }
+
+  bool readLog(LogHandler::Log& log) {
+    quint32 length;
+    if (!readInteger(length) || (remaining() < length)) {
+      return false;
+    }
+
+    // Read the payload on its own, so that any fields added by a later
+    // version of the format are skipped.
+    SegmentReader payload(m_pos, length);
+    m_pos += length;
+
+    quint8 level;
+    quint8 fromQT;
+    qint32 line;
+    if (!payload.readInteger(log.m_timestamp) || !payload.readInteger(level) ||
+        !payload.readInteger(fromQT) || !payload.readInteger(line) ||
+        !payload.readString(log.m_className) ||
+        !payload.readString(log.m_file) ||
+        !payload.readString(log.m_function) ||
+        !payload.readString(log.m_message)) {
+      return false;
+    }
+    log.m_logLevel = static_cast<LogLevel>(level);
+    log.m_fromQT = fromQT != 0;
+    log.m_line = line;
+    return true;
+  }
+
+ private:
+  const char* m_pos;
+  const char* m_end;
+};
+
+QByteArray segmentHeader() {
+  QByteArray header(LOG_SEGMENT_MAGIC, LOG_SEGMENT_MAGIC_SIZE);
+  appendInteger<quint32>(header, LOG_SEGMENT_VERSION);
+  return header;
+}
+
+// Writes a binary segment out as text. Decoding stops at the first
+// truncated record, which is what a crash in the middle of a write leaves.
+void decodeLogSegment(QTextStream& out, const QString& filename) {
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return;
+  }
+
+  QByteArray content = file.readAll();
+  if (!content.startsWith(segmentHeader())) {
+    return;
+  }
+
+  SegmentReader reader(content.constData() + LOG_SEGMENT_HEADER_SIZE,
+                       content.length() - LOG_SEGMENT_HEADER_SIZE);
+
+  LogHandler::Log log;
+  while (reader.readLog(log)) {
+    LogHandler::prettyOutput(out, log);
+  }
+}
+
 LogLevel qtTypeToLogLevel(QtMsgType type) {
   switch (type) {
     case QtDebugMsg:
@@ -116,26 +436,218 @@ LogHandler* LogHandler::instance() {
 void LogHandler::messageQTHandler(QtMsgType type,
                                   const QMessageLogContext& context,
                                   const QString& message) {
-  QMutexLocker<QMutex> lock(&s_mutex);
-  maybeCreate(lock)->addLog(Log(qtTypeToLogLevel(type), context.file,
-                                context.function, context.line, message),
-                            lock);
+  // Fatal messages are logged as errors, which are flushed before the
+  // process aborts.
+  LogLevel logLevel = qtTypeToLogLevel(type);
+  if (enqueueLog(logLevel, true, QStringView(), QLatin1String(context.file),
+                 QLatin1String(context.function), context.line, message)) {
+    return;
+  }
+
+  addLogSync(Log(logLevel, context.file, context.function, context.line,
+                 message));
 }
 
 // static
 void LogHandler::messageHandler(LogLevel logLevel, const QString& className,
-                                const QString& message) {
-  QMutexLocker<QMutex> lock(&s_mutex);
-  maybeCreate(lock)->addLog(Log(logLevel, className, message), lock);
+                                QStringView message) {
+  if (enqueueLog(logLevel, false, className, QLatin1String(), QLatin1String(),
+                 -1, message)) {
+    return;
+  }
+
+  addLogSync(Log(logLevel, className, message.toString()));
 }
 
 // static
 void LogHandler::rustMessageHandler(int32_t logLevel, char* message) {
+  Log log(static_cast<LogLevel>(logLevel), "Rust", QString::fromUtf8(message));
+  if (enqueueLog(log.m_logLevel, false, log.m_className, QLatin1String(),
+                 QLatin1String(), log.m_line, log.m_message)) {
+    return;
+  }
+
+  addLogSync(log);
+}
+
+// static
+void LogHandler::addLogSync(const Log& log) {
+  if (s_writing) {
+    // Logged while writing a record out, most likely by a slot connected to
+    // logEntryAdded(). Taking s_mutex again would deadlock: this record is
+    // written once the current one is done.
+    if (s_pendingLogs.length() < LOG_MAX_PENDING_LOGS) {
+      s_pendingLogs.append(log);
+    }
+    return;
+  }
+
+  // Anything still queued in the ring was logged before this record.
   QMutexLocker<QMutex> lock(&s_mutex);
+  LogHandler* handler = maybeCreate(lock);
+  handler->drainLogs(lock);
+  handler->addLog(log, lock);
+}
 
-  maybeCreate(lock)->addLog(
-      Log(static_cast<LogLevel>(logLevel), "Rust", QString::fromUtf8(message)),
-      lock);
+// static
+bool LogHandler::enqueueLog(LogLevel logLevel, bool fromQT,
+                            QStringView className, QLatin1String file,
+                            QLatin1String function, qint32 line,
+                            QStringView message) {
+  LogRing* ring = s_activeRing.load(std::memory_order_acquire);
+  if (!ring) {
+    return false;
+  }
+
+  // Records that don't fit in a slot are written synchronously instead.
+  if (!LogRecord::fits(className, file, function, message)) {
+    return false;
+  }
+
+  // Errors are written out before returning, so that they (and everything
+  // logged before them) make it to disk even if we are about to crash.
+  const bool urgent = logLevel >= Error;
+
+  auto fill = [&](LogRecord& record) {
+    record.fill(logLevel, fromQT, className, file, function, line, message);
+  };
+  while (!ring->push(fill)) {
+    if (s_writing) {
+      // We are the one draining the ring: set the record aside instead.
+      Log log;
+      log.m_timestamp = QDateTime::currentMSecsSinceEpoch();
+      log.m_logLevel = logLevel;
+      log.m_fromQT = fromQT;
+      log.m_className = className.toString();
+      log.m_file = file;
+      log.m_function = function;
+      log.m_line = line;
+      log.m_message = message.toString();
+      addLogSync(log);
+      return true;
+    }
+
+    // The writer is falling behind. Rather than dropping the record or
+    // waiting for it, drain the ring from this thread.
+    QMutexLocker<QMutex> lock(&s_mutex);
+    maybeCreate(lock)->drainLogs(lock);
+  }
+
+  // Logged while writing a record out: it will be drained with the rest.
+  if (s_writing) {
+    return true;
+  }
+
+  // The asynchronous mode may have been disabled while we were queueing.
+  if (urgent || !s_activeRing.load(std::memory_order_acquire)) {
+    QMutexLocker<QMutex> lock(&s_mutex);
+    maybeCreate(lock)->drainLogs(lock);
+  } else if (s_writerIdle.exchange(false)) {
+    s_writerWakeup.release();
+  }
+  return true;
+}
+
+// static
+void LogHandler::flushPendingLogs() {
+  // The records can't be written out if this thread was in the middle of
+  // writing one.
+  if (s_writing) {
+    return;
+  }
+
+  // Crash handlers can run on a thread that holds s_mutex, or while another
+  // thread holding it is stuck. Better to lose the pending records than to
+  // hang the crash report.
+  if (!s_mutex.tryLock()) {
+    return;
+  }
+  auto unlock = qScopeGuard([]() { s_mutex.unlock(); });
+
+  // QMutexLocker can't adopt a mutex that is already locked. A null one
+  // doesn't lock anything, and stands for the lock taken above.
+  QMutexLocker<QMutex> lock(static_cast<QMutex*>(nullptr));
+  if (s_instance) {
+    s_instance->drainLogs(lock);
+  }
+}
+
+// static
+void LogHandler::setAsynchronous(bool enabled) {
+  QMutexLocker<QMutex> lock(&s_mutex);
+  LogHandler* handler = maybeCreate(lock);
+  if (enabled == (s_writer != nullptr)) {
+    return;
+  }
+
+  if (enabled) {
+    if (!s_logRing) {
+      s_logRing = new LogRing();
+      std::atexit([]() {
+        QMutexLocker<QMutex> lock(&s_mutex);
+        if (s_instance) {
+          s_instance->drainLogs(lock);
+        }
+      });
+    }
+
+    s_writerStop = false;
+    s_writer = QThread::create(&LogHandler::writerLoop);
+    s_writer->setObjectName("LogWriter");
+    s_writer->start(QThread::LowPriority);
+    s_activeRing.store(s_logRing, std::memory_order_release);
+    return;
+  }
+
+  s_activeRing.store(nullptr, std::memory_order_release);
+  s_writerStop = true;
+  s_writerWakeup.release();
+
+  // The writer needs the lock to finish its current batch.
+  QThread* writer = s_writer;
+  s_writer = nullptr;
+  lock.unlock();
+  writer->wait();
+  delete writer;
+  lock.relock();
+
+  handler->drainLogs(lock);
+}
+
+// static
+void LogHandler::writerLoop() {
+  while (!s_writerStop.load(std::memory_order_acquire)) {
+    {
+      QMutexLocker<QMutex> lock(&s_mutex);
+      maybeCreate(lock)->drainLogs(lock);
+    }
+
+    // Tell the producers to wake us up, unless something was queued while we
+    // were not looking.
+    s_writerIdle = true;
+    if (s_logRing->isEmpty()) {
+      s_writerWakeup.tryAcquire(1, LOG_WRITER_IDLE_MSEC);
+    }
+    s_writerIdle = false;
+  }
+}
+
+void LogHandler::drainLogs(const QMutexLocker<QMutex>& proofOfLock) {
+  if (!s_logRing) {
+    return;
+  }
+
+  // Write the whole batch before flushing the file.
+  bool written = false;
+  Log log;
+  while (s_logRing->pop(log)) {
+    writeLog(log, proofOfLock);
+    written = true;
+  }
+
+  if (written) {
+    flushLogFile(proofOfLock);
+  }
 }
 
 // static
@@ -149,7 +661,10 @@ LogHandler* LogHandler::maybeCreate(const QMutexLocker<QMutex>& proofOfLock) {
 
 // static
 void LogHandler::prettyOutput(QTextStream& out, const LogHandler::Log& log) {
-  out << "[" << log.m_dateTime.toString("dd.MM.yyyy hh:mm:ss.zzz") << "] ";
+  out << "["
+      << QDateTime::fromMSecsSinceEpoch(log.m_timestamp)
+             .toString("dd.MM.yyyy hh:mm:ss.zzz")
+      << "] ";
 
   if (!log.m_className.isEmpty()) {
     out << "(" << log.m_className << ") ";
@@ -205,7 +720,7 @@ void LogHandler::prettyOutput(QTextStream& out, const LogHandler::Log& log) {
     out << log.m_message;
   }
 
-  out << Qt::endl;
+  out << '\n';
 }
 
 // static
@@ -228,8 +743,61 @@ LogHandler::LogHandler(const QMutexLocker<QMutex>& proofOfLock) {
 
 void LogHandler::addLog(const Log& log,
                         const QMutexLocker<QMutex>& proofOfLock) {
+  writeLog(log, proofOfLock);
+  flushLogFile(proofOfLock);
+}
+
+void LogHandler::flushLogFile(const QMutexLocker<QMutex>& proofOfLock) {
+  Q_UNUSED(proofOfLock);
+
+  if (m_output) {
+    m_output->flush();
+  } else if (m_logFile) {
+    m_logFile->flush();
+  }
+}
+
+void LogHandler::writeLog(const Log& log,
+                          const QMutexLocker<QMutex>& proofOfLock) {
+  writeLogRecord(log, proofOfLock);
+
+  // Then whatever was logged in the meantime, see LOG_MAX_PENDING_LOGS.
+  for (qsizetype i = 0; i < LOG_MAX_PENDING_LOGS && !s_pendingLogs.isEmpty();
+       ++i) {
+    writeLogRecord(s_pendingLogs.takeFirst(), proofOfLock);
+  }
+  s_pendingLogs.clear();
+}
+
+void LogHandler::writeLogRecord(const Log& log,
+                                const QMutexLocker<QMutex>& proofOfLock) {
+  bool wasWriting = std::exchange(s_writing, true);
+  auto guard = qScopeGuard([wasWriting]() { s_writing = wasWriting; });
+
   if (m_output) {
     prettyOutput(*m_output, log);
+  } else if (m_logFile) {
+    QByteArray record = encodeLog(log);
+    m_logFile->write(record);
+    m_segmentSize += record.length();
+    if (m_segmentSize >= (LOG_MAX_FILE_SIZE / 2)) {
+      rotateLogSegment(proofOfLock);
+    }
+  }
+
+  // Anything else wants the record as text. Don't format it for nobody, the
+  // binary format is meant to be cheaper than that.
+  bool toAndroid = false;
+#if defined(MZ_ANDROID)
+#  ifdef MZ_DEBUG
+  toAndroid = true;
+#  else
+  toAndroid = !Constants::inProduction();
+#  endif
+#endif
+  if (!m_stderrEnabled && !toAndroid &&
+      !isSignalConnected(QMetaMethod::fromSignal(&LogHandler::logEntryAdded))) {
+    return;
   }
 
   QByteArray buffer;
@@ -254,27 +822,17 @@ void LogHandler::addLog(const Log& log,
     }
 #else
     QTextStream out(stderr);
-    prettyOutput(out, log);
+    out << buffer;
 #endif
   }
 
   emit logEntryAdded(buffer);
 
 #if defined(MZ_ANDROID)
-#  ifdef MZ_DEBUG
-  const char* str = buffer.constData();
-  if (str) {
-    __android_log_write(ANDROID_LOG_DEBUG, Constants::ANDROID_LOG_NAME, str);
-  }
-#  else
-  if (!Constants::inProduction()) {
-    const char* str = buffer.constData();
-    if (str) {
-      __android_log_write(ANDROID_LOG_DEBUG, Constants::ANDROID_LOG_NAME, str);
-    }
+  if (toAndroid) {
+    __android_log_write(ANDROID_LOG_DEBUG, Constants::ANDROID_LOG_NAME,
+                        buffer.constData());
   }
-#  endif
-
 #endif
 }
 
@@ -286,6 +844,18 @@ void LogHandler::writeLogs(QTextStream& out) {
     return;
   }
 
+  s_instance->drainLogs(lock);
+
+  // Binary segments are decoded in place, there is no need to reopen them.
+  if (s_binaryFormat) {
+    s_instance->flushLogFile(lock);
+
+    QDir logDir(s_location);
+    decodeLogSegment(out, logDir.filePath(LOG_SEGMENT_PREVIOUS_FILE_NAME));
+    decodeLogSegment(out, logDir.filePath(LOG_SEGMENT_FILE_NAME));
+    return;
+  }
+
   QString logFileName = s_instance->m_logFile->fileName();
   s_instance->closeLogFile(lock);
 
@@ -313,6 +883,8 @@ void LogHandler::cleanupLogFile(const QMutexLocker<QMutex>& proofOfLock) {
     return;
   }
 
+  s_instance->drainLogs(proofOfLock);
+
   QString logFileName = s_instance->m_logFile->fileName();
   s_instance->closeLogFile(proofOfLock);
 
@@ -321,9 +893,45 @@ void LogHandler::cleanupLogFile(const QMutexLocker<QMutex>& proofOfLock) {
     file.remove();
   }
 
+  if (s_binaryFormat) {
+    QFile::remove(QDir(s_location).filePath(LOG_SEGMENT_PREVIOUS_FILE_NAME));
+  }
+
   s_instance->openLogFile(proofOfLock);
 }
 
+// static
+void LogHandler::setBinaryFormat(bool enabled) {
+  QMutexLocker<QMutex> lock(&s_mutex);
+  if (s_binaryFormat == enabled) {
+    return;
+  }
+
+  LogHandler* handler = maybeCreate(lock);
+  handler->drainLogs(lock);
+
+  bool wasOpen = handler->m_logFile != nullptr;
+  handler->closeLogFile(lock);
+  s_binaryFormat = enabled;
+  if (wasOpen) {
+    handler->openLogFile(lock);
+  }
+}
+
+void LogHandler::rotateLogSegment(const QMutexLocker<QMutex>& proofOfLock) {
+  Q_ASSERT(s_binaryFormat);
+  Q_ASSERT(m_logFile);
+
+  QString logFileName = m_logFile->fileName();
+  QString previousFileName =
+      QFileInfo(logFileName).dir().filePath(LOG_SEGMENT_PREVIOUS_FILE_NAME);
+
+  closeLogFile(proofOfLock);
+  QFile::remove(previousFileName);
+  QFile::rename(logFileName, previousFileName);
+  openLogFile(proofOfLock);
+}
+
 // static
 void LogHandler::setLocation(const QString& path) {
   QMutexLocker<QMutex> lock(&s_mutex);
@@ -385,7 +993,19 @@ void LogHandler::openLogFile(const QMutexLocker<QMutex>& proofOfLock) {
     }
   }
 
+  // Only the active format is read back. The text log is left alone when
+  // switching to binary segments, so that the tools reading it keep working
+  // with what was written before.
   QString logFileName = appDataLocation.filePath(Constants::LOG_FILE_NAME);
+  if (s_binaryFormat) {
+    openLogSegment(proofOfLock,
+                   appDataLocation.filePath(LOG_SEGMENT_FILE_NAME));
+    return;
+  }
+
+  QFile::remove(appDataLocation.filePath(LOG_SEGMENT_FILE_NAME));
+  QFile::remove(appDataLocation.filePath(LOG_SEGMENT_PREVIOUS_FILE_NAME));
+
   truncateLogFile(proofOfLock, logFileName);
 
   m_logFile = new QFile(logFileName);
@@ -404,6 +1024,33 @@ void LogHandler::openLogFile(const QMutexLocker<QMutex>& proofOfLock) {
 #endif
 }
 
+void LogHandler::openLogSegment(const QMutexLocker<QMutex>& proofOfLock,
+                                const QString& filename) {
+  Q_UNUSED(proofOfLock);
+
+  m_logFile = new QFile(filename);
+  if (!m_logFile->open(QIODevice::WriteOnly | QIODevice::Append)) {
+    delete m_logFile;
+    m_logFile = nullptr;
+    return;
+  }
+
+  // Start a new segment, or carry on with the one left by a previous run
+  // unless it was written with another version of the format.
+  m_segmentSize = m_logFile->size();
+  if (m_segmentSize > 0) {
+    QFile existing(filename);
+    if (!existing.open(QIODevice::ReadOnly) ||
+        existing.read(LOG_SEGMENT_HEADER_SIZE) != segmentHeader()) {
+      m_logFile->resize(0);
+      m_segmentSize = 0;
+    }
+  }
+  if (m_segmentSize == 0) {
+    m_segmentSize = m_logFile->write(segmentHeader());
+  }
+}
+
 void LogHandler::closeLogFile(const QMutexLocker<QMutex>& proofOfLock) {
   Q_UNUSED(proofOfLock);
 
@@ -413,6 +1060,7 @@ void LogHandler::closeLogFile(const QMutexLocker<QMutex>& proofOfLock) {
 
     delete m_logFile;
     m_logFile = nullptr;
+    m_segmentSize = 0;
   }
 }
 
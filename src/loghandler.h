@@ -33,7 +33,7 @@ class LogHandler final : public QObject {
 
     Log(LogLevel logLevel, const QString& className, const QString& message)
         : m_logLevel(logLevel),
-          m_dateTime(QDateTime::currentDateTime()),
+          m_timestamp(QDateTime::currentMSecsSinceEpoch()),
           m_className(className),
           m_message(message),
           m_fromQT(false) {}
@@ -41,7 +41,7 @@ class LogHandler final : public QObject {
     Log(LogLevel logLevel, const QString& file, const QString& function,
         uint32_t line, const QString& message)
         : m_logLevel(logLevel),
-          m_dateTime(QDateTime::currentDateTime()),
+          m_timestamp(QDateTime::currentMSecsSinceEpoch()),
           m_file(file),
           m_function(function),
           m_message(message),
@@ -49,7 +49,8 @@ class LogHandler final : public QObject {
           m_fromQT(true) {}
 
     LogLevel m_logLevel = LogLevel::Debug;
-    QDateTime m_dateTime;
+    // Milliseconds since the epoch, converted to local time when printed.
+    qint64 m_timestamp = 0;
     QString m_file;
     QString m_function;
     QString m_className;
@@ -69,8 +70,9 @@ class LogHandler final : public QObject {
                                const QMessageLogContext& context,
                                const QString& message);
 
+  // The message is only copied if it can't be queued as it is.
   static void messageHandler(LogLevel logLevel, const QString& className,
-                             const QString& message);
+                             QStringView message);
 
   static void rustMessageHandler(int32_t logLevel, char* message);
 
@@ -84,6 +86,21 @@ class LogHandler final : public QObject {
 
   static void setStderr(bool enabled = true);
 
+  // When enabled, log records are queued into a lock-free ring and written
+  // out in batches by a background thread. Errors are still flushed before
+  // the call returns, and anything pending is flushed when the process exits.
+  static void setAsynchronous(bool enabled = true);
+
+  // Writes out whatever the asynchronous writer has not written yet. Meant
+  // for crash handlers.
+  static void flushPendingLogs();
+
+  // When enabled, logs are written as rotated binary segments rather than a
+  // text file, and only formatted when they are retrieved. The segments can
+  // be decoded offline with tools/logviewer. Logs are written as text unless
+  // this is called.
+  static void setBinaryFormat(bool enabled = true);
+
   void serializeLogs(QTextStream* out,
                      std::function<void()>&& finalizeCallback);
 
@@ -91,6 +108,9 @@ class LogHandler final : public QObject {
   void unregisterLogSerializer(LogSerializer* logSerializer);
 
  signals:
+  // Emitted from the thread writing the record out. In asynchronous mode,
+  // that is the log writer thread: connect with a receiver object, so that
+  // the slot is queued to its thread.
   void logEntryAdded(const QByteArray& log);
   void viewLogsNeeded();
   void logsReady(const QString& logs);
@@ -103,10 +123,31 @@ class LogHandler final : public QObject {
 
   void addLog(const Log& log, const QMutexLocker<QMutex>& proofOfLock);
 
+  void writeLog(const Log& log, const QMutexLocker<QMutex>& proofOfLock);
+
+  void writeLogRecord(const Log& log, const QMutexLocker<QMutex>& proofOfLock);
+
+  void drainLogs(const QMutexLocker<QMutex>& proofOfLock);
+
+  static bool enqueueLog(LogLevel logLevel, bool fromQT, QStringView className,
+                         QLatin1String file, QLatin1String function,
+                         qint32 line, QStringView message);
+
+  static void addLogSync(const Log& log);
+
+  static void writerLoop();
+
   void openLogFile(const QMutexLocker<QMutex>& proofOfLock);
 
   void closeLogFile(const QMutexLocker<QMutex>& proofOfLock);
 
+  void flushLogFile(const QMutexLocker<QMutex>& proofOfLock);
+
+  void openLogSegment(const QMutexLocker<QMutex>& proofOfLock,
+                      const QString& filename);
+
+  void rotateLogSegment(const QMutexLocker<QMutex>& proofOfLock);
+
   static void cleanupLogFile(const QMutexLocker<QMutex>& proofOfLock);
 
   static void truncateLogFile(const QMutexLocker<QMutex>& proofOfLock,
@@ -122,6 +163,7 @@ class LogHandler final : public QObject {
 
   QFile* m_logFile = nullptr;
   QTextStream* m_output = nullptr;
+  qint64 m_segmentSize = 0;
 
   QList<LogSerializer*> m_logSerializers;
 };
@@ -4,12 +4,14 @@
 
 #include "server.h"
 
+#include <QDataStream>
 #include <QDateTime>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonValue>
 #include <QRandomGenerator>
 
+#include "jsonstreamreader.h"
 #include "leakdetector.h"
 
 Server::Server() { MZ_COUNT_CTOR(Server); }
@@ -129,6 +131,134 @@ bool Server::fromJson(const QJsonObject& obj) {
   return true;
 }
 
+bool Server::fromJson(JsonStreamReader& reader) {
+  // Reset.
+  m_hostname = "";
+
+  if (!reader.enterObject()) {
+    return false;
+  }
+
+  QString hostname;
+  QString ipv4AddrIn;
+  QString ipv4Gateway;
+  QString ipv6AddrIn;
+  QString ipv6Gateway;
+  QString publicKey;
+  QString socksName;
+  double weight = 0;
+  double multihopPort = 0;
+  QList<QPair<uint32_t, uint32_t>> prList;
+  bool hasHostname = false;
+  bool hasIpv4AddrIn = false;
+  bool hasIpv4Gateway = false;
+  bool hasPublicKey = false;
+  bool hasWeight = false;
+  bool hasPortRanges = false;
+
+  // Optional properties take their default value when of the wrong type.
+  auto readOptionalString = [&reader](QString& value) {
+    if (reader.peek() != JsonStreamReader::String) {
+      value.clear();
+      return reader.skipValue();
+    }
+    return reader.readString(value);
+  };
+
+  QByteArrayView key;
+  while (reader.nextKey(key)) {
+    bool ok;
+    if (key == "hostname") {
+      ok = hasHostname = reader.readString(hostname);
+    } else if (key == "ipv4_addr_in") {
+      ok = hasIpv4AddrIn = reader.readString(ipv4AddrIn);
+    } else if (key == "ipv4_gateway") {
+      ok = hasIpv4Gateway = reader.readString(ipv4Gateway);
+    } else if (key == "ipv6_addr_in") {
+      // If this object comes from the IOS migration, this is missing.
+      ok = readOptionalString(ipv6AddrIn);
+    } else if (key == "ipv6_gateway") {
+      // If the server doesn't support IPv6, then this is missing.
+      ok = readOptionalString(ipv6Gateway);
+    } else if (key == "public_key") {
+      ok = hasPublicKey = reader.readString(publicKey);
+    } else if (key == "socks5_name") {
+      ok = readOptionalString(socksName);
+    } else if (key == "weight") {
+      ok = hasWeight = reader.readDouble(weight);
+    } else if (key == "multihop_port") {
+      multihopPort = 0;
+      ok = reader.peek() == JsonStreamReader::Number
+               ? reader.readDouble(multihopPort)
+               : reader.skipValue();
+    } else if (key == "port_ranges") {
+      prList.clear();
+      ok = hasPortRanges = reader.enterArray();
+      while (ok && reader.nextElement()) {
+        double a;
+        double b;
+        ok = reader.enterArray() && reader.nextElement() &&
+             reader.readDouble(a) && reader.nextElement() &&
+             reader.readDouble(b) && !reader.nextElement() &&
+             !reader.hasError();
+        if (ok) {
+          prList.append(QPair<uint32_t, uint32_t>(static_cast<int>(a),
+                                                  static_cast<int>(b)));
+        }
+      }
+      ok = ok && !reader.hasError();
+    } else {
+      ok = reader.skipValue();
+    }
+
+    if (!ok) {
+      return false;
+    }
+  }
+
+  if (reader.hasError() || !hasHostname || !hasIpv4AddrIn ||
+      !hasIpv4Gateway || !hasPublicKey || !hasWeight || !hasPortRanges) {
+    return false;
+  }
+
+  m_hostname = hostname;
+  m_ipv4AddrIn = ipv4AddrIn;
+  m_ipv4Gateway = ipv4Gateway;
+  m_ipv6AddrIn = ipv6AddrIn;
+  m_ipv6Gateway = ipv6Gateway;
+  m_portRanges.swap(prList);
+  m_publicKey = publicKey;
+  m_weight = static_cast<int>(weight);
+  m_socksName = socksName;
+  m_multihopPort = static_cast<int>(multihopPort);
+
+  return true;
+}
+
+void Server::toSnapshot(QDataStream& stream) const {
+  stream << m_hostname << m_ipv4AddrIn << m_ipv4Gateway << m_ipv6AddrIn
+         << m_ipv6Gateway << m_portRanges << m_publicKey << m_socksName
+         << m_weight << m_multihopPort;
+}
+
+bool Server::fromSnapshot(QDataStream& stream) {
+  stream >> m_hostname >> m_ipv4AddrIn >> m_ipv4Gateway >> m_ipv6AddrIn >>
+      m_ipv6Gateway >> m_portRanges >> m_publicKey >> m_socksName >>
+      m_weight >> m_multihopPort;
+
+  if (stream.status() != QDataStream::Ok || m_hostname.isEmpty()) {
+    m_hostname = "";
+    return false;
+  }
+
+  return true;
+}
+
+void Server::setLocation(const QString& countryCode, const QString& cityName) {
+  m_countryCode = countryCode;
+  m_cityName = cityName;
+}
+
 bool Server::fromMultihop(const Server& exit, const Server& entry) {
   m_hostname = exit.m_hostname;
   m_ipv4Gateway = exit.m_ipv4Gateway;
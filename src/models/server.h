@@ -9,6 +9,8 @@
 #include <QPair>
 #include <QString>
 
+class JsonStreamReader;
+class QDataStream;
 class QJsonObject;
 
 class Server final {
@@ -20,6 +22,12 @@ class Server final {
   ~Server();
 
   [[nodiscard]] bool fromJson(const QJsonObject& obj);
+  [[nodiscard]] bool fromJson(JsonStreamReader& reader);
+
+  // Binary form used by the server list snapshot. The location is not part
+  // of it, see setLocation().
+  void toSnapshot(QDataStream& stream) const;
+  [[nodiscard]] bool fromSnapshot(QDataStream& stream);
   bool fromMultihop(const Server& exit, const Server& entry);
 
   static const Server& weightChooser(const QList<Server>& servers);
@@ -52,6 +60,10 @@ class Server final {
 
   bool forcePort(uint32_t port);
 
+  // For servers read with a JsonStreamReader or from a snapshot, where the
+  // location is only known once the enclosing objects have been read.
+  void setLocation(const QString& countryCode, const QString& cityName);
+
   bool operator==(const Server& other) const {
     return m_publicKey == other.m_publicKey;
   }
@@ -4,12 +4,15 @@
 
 #include "servercity.h"
 
+#include <QDataStream>
+#include <QDateTime>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonValue>
 
 #include "constants.h"
 #include "feature/feature.h"
+#include "jsonstreamreader.h"
 #include "leakdetector.h"
 #include "localizer.h"
 #include "location.h"
@@ -26,11 +29,12 @@ ServerCity::ServerCity(const ServerCity& other) {
   MZ_COUNT_CTOR(ServerCity);
   *this = other;
 
-  // Changes in the average latency may cause the connection score to change.
+  // Changes in the user location may cause the connection score to change.
+  // ServerLatency takes care of the latency and of the cooldowns.
   MozillaVPN* vpn = MozillaVPN::instance();
   if (vpn) {
-    connect(vpn->serverLatency(), &ServerLatency::progressChanged, this,
-            [this] { emit scoreChanged(); });
+    connect(vpn->location(), &Location::changed, this,
+            [this] { refreshScore(); });
   }
 }
 
@@ -40,9 +44,13 @@ ServerCity& ServerCity::operator=(const ServerCity& other) {
   m_name = other.m_name;
   m_code = other.m_code;
   m_country = other.m_country;
+  m_hashKey = other.m_hashKey;
   m_latitude = other.m_latitude;
   m_longitude = other.m_longitude;
   m_servers = other.m_servers;
+  m_latency = other.m_latency;
+  m_score = other.m_score;
+  m_activeServerCount = other.m_activeServerCount;
 
   return *this;
 }
@@ -100,10 +108,135 @@ bool ServerCity::fromJson(const QJsonObject& obj, const QString& country) {
   m_latitude = latitude.toDouble();
   m_longitude = longitude.toDouble();
   m_servers.swap(servers);
+  m_latency = -1;
 
   return true;
 }
 
+bool ServerCity::fromJson(JsonStreamReader& reader, QList<Server>& servers) {
+  if (!reader.enterObject()) {
+    return false;
+  }
+
+  QString name;
+  QString code;
+  double latitude = 0;
+  double longitude = 0;
+  QList<QString> pubkeys;
+  bool hasName = false;
+  bool hasCode = false;
+  bool hasLatitude = false;
+  bool hasLongitude = false;
+  bool hasServers = false;
+
+  QByteArrayView key;
+  while (reader.nextKey(key)) {
+    bool ok;
+    if (key == "name") {
+      ok = hasName = reader.readString(name);
+    } else if (key == "code") {
+      ok = hasCode = reader.readString(code);
+    } else if (key == "latitude") {
+      ok = hasLatitude = reader.readDouble(latitude);
+    } else if (key == "longitude") {
+      ok = hasLongitude = reader.readDouble(longitude);
+    } else if (key == "servers") {
+      pubkeys.clear();
+      ok = hasServers = reader.enterArray();
+      while (ok && reader.nextElement()) {
+        Server server;
+        ok = server.fromJson(reader);
+        if (ok) {
+          // The key is shared with the server, rather than copied.
+          pubkeys.append(server.publicKey());
+          servers.append(server);
+        }
+      }
+      ok = ok && !reader.hasError();
+    } else {
+      ok = reader.skipValue();
+    }
+
+    if (!ok) {
+      return false;
+    }
+  }
+
+  if (reader.hasError() || !hasName || !hasCode || !hasLatitude ||
+      !hasLongitude || !hasServers) {
+    return false;
+  }
+
+  // The name can come after the servers, so filter them out only now.
+  if (Constants::inProduction() && name.contains("BETA")) {
+    pubkeys.clear();
+  }
+
+  m_name = name;
+  m_code = code;
+  m_country.clear();
+  m_hashKey.clear();
+  m_latitude = latitude;
+  m_longitude = longitude;
+  m_servers.swap(pubkeys);
+  m_latency = -1;
+
+  return true;
+}
+
+void ServerCity::toSnapshot(QDataStream& stream,
+                            const QList<const Server*>& servers) const {
+  stream << m_name << m_code << m_latitude << m_longitude
+         << static_cast<quint32>(servers.size());
+  for (const Server* server : servers) {
+    server->toSnapshot(stream);
+  }
+}
+
+bool ServerCity::fromSnapshot(QDataStream& stream, QList<Server>& servers) {
+  QString name;
+  QString code;
+  double latitude;
+  double longitude;
+  quint32 count;
+  stream >> name >> code >> latitude >> longitude >> count;
+  if (stream.status() != QDataStream::Ok || name.isEmpty()) {
+    return false;
+  }
+
+  QList<QString> pubkeys;
+  for (quint32 i = 0; i < count; ++i) {
+    Server server;
+    if (!server.fromSnapshot(stream)) {
+      return false;
+    }
+    pubkeys.append(server.publicKey());
+    servers.append(server);
+  }
+
+  // The servers of hidden cities are part of the snapshot, as they are part
+  // of the list, so filter them out the same way fromJson() does.
+  if (Constants::inProduction() && name.contains("BETA")) {
+    pubkeys.clear();
+  }
+
+  m_name = name;
+  m_code = code;
+  m_country.clear();
+  m_hashKey.clear();
+  m_latitude = latitude;
+  m_longitude = longitude;
+  m_servers.swap(pubkeys);
+  m_latency = -1;
+
+  return true;
+}
+
+void ServerCity::setCountry(const QString& country) {
+  m_country = country;
+  m_hashKey = hashKey(m_country, m_name);
+}
+
 // static
 QString ServerCity::hashKey(const QString& country, const QString cityName) {
   return cityName + "," + country;
@@ -114,6 +247,13 @@ const QString ServerCity::localizedName() const {
 }
 
 qint64 ServerCity::latency() const {
+  if (m_latency < 0) {
+    m_latency = computeLatency();
+  }
+  return m_latency;
+}
+
+qint64 ServerCity::computeLatency() const {
   ServerLatency* serverLatency = MozillaVPN::instance()->serverLatency();
   int numLatencySamples = 0;
   qint64 sumLatencyMsec = 0;
@@ -131,6 +271,40 @@ qint64 ServerCity::latency() const {
   return (sumLatencyMsec + numLatencySamples - 1) / numLatencySamples;
 }
 
+// Called by ServerLatency when one of our servers has a new measurement.
+void ServerCity::updateLatency() const {
+  m_latency = computeLatency();
+  m_score = connectionScore();
+  m_activeServerCount = activeServerCount();
+  emit scoreChanged();
+}
+
+// Called when something the scores depend on may have changed, such as the
+// average latency or the cooldown of one of our servers. Avoid re-scoring the
+// city unless one of the scores did change. The multi-hop score only depends
+// on the cooldowns, and not on the latency.
+void ServerCity::refreshScore() const {
+  int score = connectionScore();
+  int activeServers = activeServerCount();
+  if (score != m_score || activeServers != m_activeServerCount) {
+    m_score = score;
+    m_activeServerCount = activeServers;
+    emit scoreChanged();
+  }
+}
+
+int ServerCity::activeServerCount() const {
+  ServerLatency* serverLatency = MozillaVPN::instance()->serverLatency();
+  qint64 now = QDateTime::currentSecsSinceEpoch();
+  int count = 0;
+  for (const QString& pubkey : m_servers) {
+    if (serverLatency->getCooldown(pubkey) <= now) {
+      count++;
+    }
+  }
+  return count;
+}
+
 int ServerCity::connectionScore() const {
   ServerLatency* serverLatency = MozillaVPN::instance()->serverLatency();
   QString userCountry = MozillaVPN::instance()->location()->countryCode();
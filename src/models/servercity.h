@@ -11,6 +11,8 @@
 
 #include "server.h"
 
+class JsonStreamReader;
+class QDataStream;
 class QJsonObject;
 
 class ServerCity final : public QObject {
@@ -32,6 +34,18 @@ class ServerCity final : public QObject {
 
   [[nodiscard]] bool fromJson(const QJsonObject& obj, const QString& country);
 
+  // Reads a city and appends its servers to |servers|. The country is not
+  // part of the city object: it must be set with setCountry() afterwards.
+  [[nodiscard]] bool fromJson(JsonStreamReader& reader, QList<Server>& servers);
+  void setCountry(const QString& country);
+
+  // Binary form used by the server list snapshot, followed by |servers|.
+  // Like the JSON stream, reading it appends the servers to |servers| and
+  // leaves the country unset.
+  void toSnapshot(QDataStream& stream,
+                  const QList<const Server*>& servers) const;
+  [[nodiscard]] bool fromSnapshot(QDataStream& stream, QList<Server>& servers);
+
   bool initialized() const { return !m_name.isEmpty(); }
 
   const QString& name() const { return m_name; }
@@ -55,12 +69,18 @@ class ServerCity final : public QObject {
                                 const QString& cityName) const;
 
   qint64 latency() const;
+  void updateLatency() const;
+  void refreshScore() const;
 
   const QList<QString> servers() const { return m_servers; }
 
  signals:
   void scoreChanged() const;
 
+ private:
+  qint64 computeLatency() const;
+  int activeServerCount() const;
+
  private:
   QString m_country;
   QString m_name;
@@ -70,6 +90,14 @@ class ServerCity final : public QObject {
   double m_longitude;
 
   QList<QString> m_servers;
+
+  // The average latency of our servers is cached, and only recomputed when
+  // one of them gets a new measurement. A negative value means unknown.
+  mutable qint64 m_latency = -1;
+
+  // What the scores were computed from when scoreChanged() was last emitted.
+  mutable int m_score = -1;
+  mutable int m_activeServerCount = -1;
 };
 
 #endif  // SERVERCITY_H
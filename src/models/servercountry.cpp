@@ -4,12 +4,14 @@
 
 #include "servercountry.h"
 
+#include <QDataStream>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonValue>
 #include <QStringList>
 
 #include "collator.h"
+#include "jsonstreamreader.h"
 #include "leakdetector.h"
 #include "localizer.h"
 #include "serverdata.h"
@@ -73,6 +75,138 @@ bool ServerCountry::fromJson(const QJsonObject& countryObj) {
   return true;
 }
 
+bool ServerCountry::fromJson(JsonStreamReader& reader,
+                             QList<ServerCity>& cities,
+                             QList<Server>& servers) {
+  if (!reader.enterObject()) {
+    return false;
+  }
+
+  const qsizetype firstCity = cities.size();
+  const qsizetype firstServer = servers.size();
+
+  // Where the servers of each city end in |servers|.
+  QList<qsizetype> serverEnds;
+
+  QString countryName;
+  QString countryCode;
+  bool hasName = false;
+  bool hasCode = false;
+  bool hasCities = false;
+
+  QByteArrayView key;
+  while (reader.nextKey(key)) {
+    bool ok;
+    if (key == "name") {
+      ok = hasName = reader.readString(countryName);
+    } else if (key == "code") {
+      ok = hasCode = reader.readString(countryCode);
+    } else if (key == "cities") {
+      cities.resize(firstCity);
+      servers.resize(firstServer);
+      serverEnds.clear();
+      ok = hasCities = reader.enterArray();
+      while (ok && reader.nextElement()) {
+        ServerCity city;
+        ok = city.fromJson(reader, servers) && !city.name().isEmpty();
+        if (ok) {
+          cities.append(city);
+          serverEnds.append(servers.size());
+        }
+      }
+      ok = ok && !reader.hasError();
+    } else {
+      ok = reader.skipValue();
+    }
+
+    if (!ok) {
+      return false;
+    }
+  }
+
+  if (reader.hasError() || !hasName || !hasCode || !hasCities) {
+    return false;
+  }
+
+  QList<QString> cityNames;
+  cityNames.reserve(serverEnds.size());
+
+  qsizetype serverIndex = firstServer;
+  for (qsizetype i = 0; i < serverEnds.size(); ++i) {
+    ServerCity& city = cities[firstCity + i];
+    city.setCountry(countryCode);
+    cityNames.append(city.name());
+
+    for (; serverIndex < serverEnds.at(i); ++serverIndex) {
+      servers[serverIndex].setLocation(countryCode, city.name());
+    }
+  }
+
+  m_name = countryName;
+  m_code = countryCode;
+  m_cities.swap(cityNames);
+
+  sortCities();
+
+  return true;
+}
+
+void ServerCountry::toSnapshot(
+    QDataStream& stream, const QHash<QString, ServerCity>& cities,
+    const QHash<QString, QList<const Server*>>& servers) const {
+  QList<const ServerCity*> list;
+  for (const QString& cityName : m_cities) {
+    auto it = cities.constFind(ServerCity::hashKey(m_code, cityName));
+    if (it != cities.constEnd()) {
+      list.append(&it.value());
+    }
+  }
+
+  stream << m_name << m_code << static_cast<quint32>(list.size());
+  for (const ServerCity* city : list) {
+    city->toSnapshot(stream, servers.value(city->hashKey()));
+  }
+}
+
+bool ServerCountry::fromSnapshot(QDataStream& stream,
+                                 QList<ServerCity>& cities,
+                                 QList<Server>& servers) {
+  QString countryName;
+  QString countryCode;
+  quint32 count;
+  stream >> countryName >> countryCode >> count;
+  if (stream.status() != QDataStream::Ok) {
+    return false;
+  }
+
+  QList<QString> cityNames;
+  for (quint32 i = 0; i < count; ++i) {
+    const qsizetype firstServer = servers.size();
+
+    ServerCity city;
+    if (!city.fromSnapshot(stream, servers)) {
+      return false;
+    }
+
+    city.setCountry(countryCode);
+    for (qsizetype j = firstServer; j < servers.size(); ++j) {
+      servers[j].setLocation(countryCode, city.name());
+    }
+
+    cityNames.append(city.name());
+    cities.append(city);
+  }
+
+  m_name = countryName;
+  m_code = countryCode;
+  m_cities.swap(cityNames);
+
+  // The snapshot may have been written with another language.
+  sortCities();
+
+  return true;
+}
+
 QString ServerCountry::localizedName() const {
   return Localizer::instance()->getTranslatedCountryName(m_code, m_name);
 }
@@ -5,11 +5,14 @@
 #ifndef SERVERCOUNTRY_H
 #define SERVERCOUNTRY_H
 
+#include <QHash>
 #include <QList>
 #include <QString>
 
 #include "servercity.h"
 
+class JsonStreamReader;
+class QDataStream;
 class QJsonObject;
 
 class ServerCountry final {
@@ -21,6 +24,21 @@ class ServerCountry final {
 
   [[nodiscard]] bool fromJson(const QJsonObject& obj);
 
+  // Reads a country in a single pass, appending its cities and servers to
+  // |cities| and |servers| with their location already set.
+  [[nodiscard]] bool fromJson(JsonStreamReader& reader,
+                              QList<ServerCity>& cities,
+                              QList<Server>& servers);
+
+  // Binary form used by the server list snapshot. |cities| and |servers|
+  // are the cities of the model, and its servers grouped by city hash key.
+  void toSnapshot(
+      QDataStream& stream, const QHash<QString, ServerCity>& cities,
+      const QHash<QString, QList<const Server*>>& servers) const;
+  [[nodiscard]] bool fromSnapshot(QDataStream& stream,
+                                  QList<ServerCity>& cities,
+                                  QList<Server>& servers);
+
   const QString& name() const { return m_name; }
 
   const QString& code() const { return m_code; }
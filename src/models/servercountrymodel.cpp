@@ -4,18 +4,27 @@
 
 #include "servercountrymodel.h"
 
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QRandomGenerator>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtEndian>
 
 #include "collator.h"
 #include "constants.h"
 #include "feature/feature.h"
+#include "jsonstreamreader.h"
 #include "leakdetector.h"
 #include "localizer.h"
 #include "logger.h"
 #include "mozillavpn.h"
+#include "profiler.h"
 #include "recommendedlocationmodel.h"
 #include "servercountry.h"
 #include "serverdata.h"
@@ -24,11 +33,53 @@
 
 namespace {
 Logger logger("ServerCountryModel");
+
+#ifdef UNIT_TEST
+QString s_snapshotDirectory;
+#endif
+}  // namespace
+
+// The parsed server list is also kept in a binary snapshot, which is loaded
+// instead of parsing the JSON at startup. It is made of:
+// - SNAPSHOT_MAGIC, and SNAPSHOT_VERSION as a little-endian quint32;
+// - the SHA-256 of the JSON the snapshot was built from, so that a snapshot
+//   that doesn't match the list in the settings is ignored;
+// - the SHA-256 of the payload, to detect corrupted files;
+// - the payload: the countries, cities and servers, then the cooldowns, in
+//   QDataStream format.
+constexpr const char* SNAPSHOT_FILE_NAME = "servers.snapshot";
+constexpr const char SNAPSHOT_MAGIC[] = "MZSRVSNP";
+constexpr qsizetype SNAPSHOT_MAGIC_SIZE = sizeof(SNAPSHOT_MAGIC) - 1;
+constexpr quint32 SNAPSHOT_VERSION = 1;
+constexpr qsizetype SNAPSHOT_DIGEST_SIZE = 32;
+constexpr qsizetype SNAPSHOT_HEADER_SIZE =
+    SNAPSHOT_MAGIC_SIZE + 4 + (2 * SNAPSHOT_DIGEST_SIZE);
+constexpr QDataStream::Version SNAPSHOT_STREAM_VERSION = QDataStream::Qt_6_2;
+constexpr int SNAPSHOT_WRITE_DELAY_MSEC = 2000;
+
+ServerCountryModel::ServerCountryModel() {
+  MZ_COUNT_CTOR(ServerCountryModel);
+
+  m_snapshotTimer.setSingleShot(true);
+  m_snapshotTimer.setInterval(SNAPSHOT_WRITE_DELAY_MSEC);
+  connect(&m_snapshotTimer, &QTimer::timeout, this,
+          &ServerCountryModel::writeSnapshot);
+
+  m_snapshotWriter.setMaxThreadCount(1);
+
+  // Flush while the server latencies are still around.
+  if (QCoreApplication* app = QCoreApplication::instance()) {
+    connect(app, &QCoreApplication::aboutToQuit, this,
+            &ServerCountryModel::flushSnapshot);
+  }
 }
 
-ServerCountryModel::ServerCountryModel() { MZ_COUNT_CTOR(ServerCountryModel); }
+ServerCountryModel::~ServerCountryModel() {
+  MZ_COUNT_DTOR(ServerCountryModel);
 
-ServerCountryModel::~ServerCountryModel() { MZ_COUNT_DTOR(ServerCountryModel); }
+  flushSnapshot();
+  m_snapshotWriter.waitForDone();
+}
 
 bool ServerCountryModel::fromSettings() {
   SettingsHolder* settingsHolder = SettingsHolder::instance();
@@ -37,18 +88,30 @@ bool ServerCountryModel::fromSettings() {
   logger.debug() << "Reading the server list from settings";
 
   const QByteArray json = settingsHolder->servers();
-  if (json.isEmpty() || !fromJsonInternal(json)) {
+  if (json.isEmpty()) {
+    return false;
+  }
+
+  const QByteArray jsonDigest = digest(json);
+  if (fromSnapshot(jsonDigest)) {
+    m_digest = jsonDigest;
+    return true;
+  }
+
+  if (!fromJsonInternal(json)) {
     return false;
   }
 
-  m_rawJson = json;
+  m_digest = jsonDigest;
+  scheduleSnapshot();
   return true;
 }
 
 bool ServerCountryModel::fromJson(const QByteArray& s) {
+  MZ_PROFILE_SCOPE("models", "ServerCountryModel::fromJson");
   logger.debug() << "Reading from JSON";
 
-  if (!s.isEmpty() && m_rawJson == s) {
+  if (!s.isEmpty() && m_digest == digest(s)) {
     logger.debug() << "Nothing has changed";
     return true;
   }
@@ -57,88 +120,269 @@ bool ServerCountryModel::fromJson(const QByteArray& s) {
     return false;
   }
 
-  m_rawJson = s;
+  m_digest = digest(s);
+  scheduleSnapshot();
   emit changed();
   return true;
 }
 
+// static
+QByteArray ServerCountryModel::digest(const QByteArray& data) {
+  return QCryptographicHash::hash(data, QCryptographicHash::Sha256);
+}
+
 bool ServerCountryModel::fromJsonInternal(const QByteArray& s) {
+  QList<ServerCountry> countries;
+  QList<ServerCity> cities;
+  QList<Server> servers;
+  const bool ok = parseJson(s, countries, cities, servers);
+  return reset(ok, countries, cities, servers);
+}
+
+bool ServerCountryModel::reset(bool ok, QList<ServerCountry>& countries,
+                               const QList<ServerCity>& cities,
+                               const QList<Server>& servers) {
   beginResetModel();
 
-  m_rawJson = "";
+  m_digest.clear();
   m_countries.clear();
   m_cities.clear();
   m_servers.clear();
 
-  QJsonDocument doc = QJsonDocument::fromJson(s);
-  if (!doc.isObject()) {
+  if (ok) {
+    m_countries.swap(countries);
+
+    m_cities.reserve(cities.size());
+    for (const ServerCity& city : cities) {
+      m_cities.insert(city.hashKey(), city);
+    }
+
+    m_servers.reserve(servers.size());
+    for (const Server& server : servers) {
+      m_servers.insert(server.publicKey(), server);
+    }
+
+    sortCountries();
+  }
+
+  endResetModel();
+
+  return ok;
+}
+
+// static
+QString ServerCountryModel::snapshotFileName() {
+#ifdef UNIT_TEST
+  if (!s_snapshotDirectory.isEmpty()) {
+    return QDir(s_snapshotDirectory).filePath(SNAPSHOT_FILE_NAME);
+  }
+#endif
+
+  return QDir(QStandardPaths::writableLocation(
+                  QStandardPaths::AppDataLocation))
+      .filePath(SNAPSHOT_FILE_NAME);
+}
+
+#ifdef UNIT_TEST
+// static
+void ServerCountryModel::setSnapshotDirectory(const QString& path) {
+  s_snapshotDirectory = path;
+}
+#endif
+
+bool ServerCountryModel::fromSnapshot(const QByteArray& jsonDigest) {
+  QFile file(snapshotFileName());
+  if (!file.open(QIODevice::ReadOnly) || file.size() < SNAPSHOT_HEADER_SIZE) {
     return false;
   }
 
-  QJsonObject obj = doc.object();
+  // The file is read through a mapping, rather than copied to the heap.
+  const uchar* data = file.map(0, file.size());
+  if (!data) {
+    return false;
+  }
+
+  const char* header = reinterpret_cast<const char*>(data);
+  const char* payload = header + SNAPSHOT_HEADER_SIZE;
+  const qsizetype payloadSize = file.size() - SNAPSHOT_HEADER_SIZE;
+
+  QByteArrayView magic(header, SNAPSHOT_MAGIC_SIZE);
+  QByteArrayView sourceDigest(header + SNAPSHOT_MAGIC_SIZE + 4,
+                              SNAPSHOT_DIGEST_SIZE);
+  QByteArrayView checksum(sourceDigest.data() + SNAPSHOT_DIGEST_SIZE,
+                          SNAPSHOT_DIGEST_SIZE);
 
-  QJsonValue countries = obj.value("countries");
-  if (!countries.isArray()) {
+  if (magic != QByteArrayView(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_SIZE) ||
+      qFromLittleEndian<quint32>(header + SNAPSHOT_MAGIC_SIZE) !=
+          SNAPSHOT_VERSION) {
+    logger.debug() << "Unsupported server list snapshot";
     return false;
   }
 
-  QJsonArray countriesArray = countries.toArray();
-  for (const QJsonValue& countryValue : countriesArray) {
-    if (!countryValue.isObject()) {
-      return false;
-    }
+  if (sourceDigest != jsonDigest) {
+    logger.debug() << "The server list snapshot is stale";
+    return false;
+  }
 
-    QJsonObject countryObj = countryValue.toObject();
+  const QByteArray bytes = QByteArray::fromRawData(payload, payloadSize);
+  if (checksum != digest(bytes)) {
+    logger.warning() << "The server list snapshot is corrupted";
+    return false;
+  }
 
+  QDataStream stream(bytes);
+  stream.setVersion(SNAPSHOT_STREAM_VERSION);
+
+  QList<ServerCountry> countries;
+  QList<ServerCity> cities;
+  QList<Server> servers;
+  quint32 count;
+  stream >> count;
+  for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
     ServerCountry country;
-    if (!country.fromJson(countryObj)) {
+    if (!country.fromSnapshot(stream, cities, servers)) {
       return false;
     }
+    countries.append(country);
+  }
 
-    if (country.cities().isEmpty()) {
-      continue;
+  QHash<QString, qint64> cooldowns;
+  stream >> cooldowns;
+  if (stream.status() != QDataStream::Ok || !stream.atEnd()) {
+    return false;
+  }
+
+  logger.debug() << "Server list loaded from the snapshot";
+  reset(true, countries, cities, servers);
+
+  // Cooldowns are stored as expiration times.
+  ServerLatency* serverLatency = MozillaVPN::instance()->serverLatency();
+  const qint64 now = QDateTime::currentSecsSinceEpoch();
+  for (auto i = cooldowns.constBegin(); i != cooldowns.constEnd(); ++i) {
+    if (i.value() > now && m_servers.contains(i.key())) {
+      serverLatency->setCooldown(i.key(), i.value() - now);
     }
+  }
 
-    m_countries.append(country);
+  return true;
+}
 
-    QJsonValue cities = countryObj.value("cities");
-    if (!cities.isArray()) {
-      return false;
+void ServerCountryModel::scheduleSnapshot() {
+  if (!m_snapshotTimer.isActive()) {
+    m_snapshotTimer.start();
+  }
+}
+
+void ServerCountryModel::flushSnapshot() {
+  if (m_snapshotTimer.isActive()) {
+    m_snapshotTimer.stop();
+    writeSnapshot();
+  }
+}
+
+void ServerCountryModel::writeSnapshot() {
+  if (m_digest.isEmpty()) {
+    return;
+  }
+
+  QHash<QString, QList<const Server*>> serversByCity;
+  for (const Server& server : m_servers) {
+    serversByCity[ServerCity::hashKey(server.countryCode(), server.cityName())]
+        .append(&server);
+  }
+
+  // MozillaVPN is already gone when the model itself is destroyed.
+  QHash<QString, qint64> cooldowns;
+  MozillaVPN* vpn = MozillaVPN::instance();
+  const qint64 now = QDateTime::currentSecsSinceEpoch();
+  for (auto i = m_servers.constBegin(); vpn && i != m_servers.constEnd(); ++i) {
+    qint64 cooldown = vpn->serverLatency()->getCooldown(i.key());
+    if (cooldown > now) {
+      cooldowns.insert(i.key(), cooldown);
     }
+  }
 
-    QJsonArray cityArray = cities.toArray();
-    for (const QJsonValue& cityValue : cityArray) {
-      if (!cityValue.isObject()) {
-        return false;
-      }
-      QJsonObject cityObj = cityValue.toObject();
-      QJsonValue servers = cityObj.value("servers");
-      if (!servers.isArray()) {
+  QByteArray payload;
+  {
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(SNAPSHOT_STREAM_VERSION);
+    stream << static_cast<quint32>(m_countries.size());
+    for (const ServerCountry& country : m_countries) {
+      country.toSnapshot(stream, m_cities, serversByCity);
+    }
+    stream << cooldowns;
+  }
+
+  QByteArray header(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_SIZE);
+  header.resize(SNAPSHOT_MAGIC_SIZE + 4);
+  qToLittleEndian<quint32>(SNAPSHOT_VERSION,
+                           header.data() + SNAPSHOT_MAGIC_SIZE);
+  header.append(m_digest);
+  header.append(digest(payload));
+  Q_ASSERT(header.size() == SNAPSHOT_HEADER_SIZE);
+
+  // Serializing is cheap, the file system is not: the write happens on the
+  // worker thread.
+  m_snapshotWriter.start([fileName = snapshotFileName(), header, payload]() {
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(header) < 0 ||
+        file.write(payload) < 0 || !file.commit()) {
+      logger.warning() << "Unable to write the server list snapshot";
+    }
+  });
+}
+
+// The server list is read in a single pass, without building a
+// QJsonDocument. Country and city names are shared by all the objects
+// referencing them.
+bool ServerCountryModel::parseJson(const QByteArray& s,
+                                   QList<ServerCountry>& countries,
+                                   QList<ServerCity>& cities,
+                                   QList<Server>& servers) {
+  JsonStreamReader reader(s);
+  if (!reader.enterObject()) {
+    return false;
+  }
+
+  bool hasCountries = false;
+
+  QByteArrayView key;
+  while (reader.nextKey(key)) {
+    if (key != "countries") {
+      if (!reader.skipValue()) {
         return false;
       }
+      continue;
+    }
+
+    countries.clear();
+    cities.clear();
+    servers.clear();
+
+    if (!reader.enterArray()) {
+      return false;
+    }
 
-      ServerCity city;
-      if (!city.fromJson(cityObj, country.code())) {
+    while (reader.nextElement()) {
+      ServerCountry country;
+      if (!country.fromJson(reader, cities, servers)) {
         return false;
       }
-      m_cities[city.hashKey()] = city;
 
-      QJsonArray serverArray = servers.toArray();
-      for (const QJsonValue& serverValue : serverArray) {
-        Server server(country.code(), city.name());
-        if (!server.fromJson(serverValue.toObject())) {
-          return false;
-        }
-        m_servers[server.publicKey()] = server;
+      if (!country.cities().isEmpty()) {
+        countries.append(country);
       }
     }
-  }
 
-  sortCountries();
-
-  endResetModel();
+    if (reader.hasError()) {
+      return false;
+    }
+    hasCountries = true;
+  }
 
-  return true;
+  return hasCountries && reader.atEnd();
 }
 
 QHash<int, QByteArray> ServerCountryModel::roleNames() const {
@@ -256,6 +500,8 @@ void ServerCountryModel::setCooldownForAllServersInACity(
           pubkey, Constants::SERVER_UNRESPONSIVE_COOLDOWN_SEC);
     }
   }
+
+  scheduleSnapshot();
 }
 
 namespace {
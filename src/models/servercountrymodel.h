@@ -8,6 +8,8 @@
 #include <QAbstractListModel>
 #include <QByteArray>
 #include <QObject>
+#include <QThreadPool>
+#include <QTimer>
 
 #include "servercountry.h"
 
@@ -32,7 +34,7 @@ class ServerCountryModel final : public QAbstractListModel {
 
   [[nodiscard]] bool fromJson(const QByteArray& data);
 
-  bool initialized() const { return !m_rawJson.isEmpty(); }
+  bool initialized() const { return !m_digest.isEmpty(); }
 
   QStringList pickBest() const;
 
@@ -48,6 +50,13 @@ class ServerCountryModel final : public QAbstractListModel {
 
   const QList<ServerCountry>& countries() const { return m_countries; }
 
+  // Where the binary snapshot of the server list is kept.
+  static QString snapshotFileName();
+
+#ifdef UNIT_TEST
+  static void setSnapshotDirectory(const QString& path);
+#endif
+
   void retranslate();
   void setCooldownForAllServersInACity(const QString& countryCode,
                                        const QString& cityCode);
@@ -67,15 +76,39 @@ class ServerCountryModel final : public QAbstractListModel {
 
  private:
   [[nodiscard]] bool fromJsonInternal(const QByteArray& data);
+  bool reset(bool ok, QList<ServerCountry>& countries,
+             const QList<ServerCity>& cities, const QList<Server>& servers);
+  [[nodiscard]] bool parseJson(const QByteArray& data,
+                               QList<ServerCountry>& countries,
+                               QList<ServerCity>& cities,
+                               QList<Server>& servers);
+
+  static QByteArray digest(const QByteArray& data);
+
+  [[nodiscard]] bool fromSnapshot(const QByteArray& jsonDigest);
+  void scheduleSnapshot();
+  void flushSnapshot();
+  void writeSnapshot();
 
   void sortCountries();
 
  private:
-  QByteArray m_rawJson;
+  // SHA-256 of the last server list loaded. The list itself is not kept
+  // around, this is enough to tell when it changes.
+  QByteArray m_digest;
 
   QList<ServerCountry> m_countries;
   QHash<QString, ServerCity> m_cities;
   QHash<QString, Server> m_servers;
+
+  // Snapshot writes are coalesced by this timer, then written out by a
+  // single worker thread so that they land in order.
+  QTimer m_snapshotTimer;
+  QThreadPool m_snapshotWriter;
+
+#ifdef UNIT_TEST
+  friend class TestModels;
+#endif
 };
 
 #endif  // SERVERCOUNTRYMODEL_H
@@ -126,10 +126,13 @@ MozillaVPN::MozillaVPN() : App(nullptr), m_private(new MozillaVPNPrivate()) {
         {new TaskAccount(ErrorHandler::DoNotPropagateError),
          new TaskServers(ErrorHandler::DoNotPropagateError),
          new TaskCaptivePortalLookup(ErrorHandler::DoNotPropagateError),
-         new TaskHeartbeat(), new TaskAddonIndex(),
+         new TaskHeartbeat(),
          new TaskGetSubscriptionDetails(
              TaskGetSubscriptionDetails::NoAuthenticationFlow,
              ErrorHandler::PropagateError)}));
+
+    // The add-on index runs on its own, next to the other tasks.
+    TaskScheduler::scheduleTask(new TaskAddonIndex());
   });
 
   connect(this, &MozillaVPN::stateChanged, [this]() {
@@ -777,6 +780,7 @@ void MozillaVPN::reset(bool forceInitialState) {
   deactivate();
 
   SettingsManager::instance()->reset();
+  NetworkManager::instance()->responseCache()->clear();
   m_private->m_keys.forgetKeys();
   m_private->m_serverData.forget();
 
@@ -1249,6 +1253,11 @@ void MozillaVPN::scheduleRefreshDataTasks() {
     }
   }
 
+  // The tasks of the group run together. Let them start on a warm connection.
+  if (Feature::get(Feature::Feature_sharedApiConnections)->isSupported()) {
+    NetworkManager::instance()->preconnect(QUrl(Constants::apiBaseUrl()));
+  }
+
   TaskScheduler::scheduleTask(new TaskGroup(refreshTasks));
 }
 
@@ -6,6 +6,7 @@
 
 #include "constants.h"
 #include "leakdetector.h"
+#include "logger.h"
 #include "networkrequest.h"
 #include "settingsholder.h"
 
@@ -13,9 +14,13 @@
 #  include "platforms/windows/windowsutils.h"
 #endif
 
+#include <QNetworkAccessManager>
 #include <QTextStream>
+#include <QUrl>
 
 namespace {
+Logger logger("NetworkManager");
+
 NetworkManager* s_instance = nullptr;
 
 bool localhostRequestCallback(NetworkRequest* request) {
@@ -106,6 +111,31 @@ void NetworkManager::clearCache() {
   m_clearCacheNeeded = true;
 }
 
+void NetworkManager::preconnect(const QUrl& url) {
+#ifdef MZ_WASM
+  // The requests are sent by the browser.
+  Q_UNUSED(url);
+#else
+  logger.debug() << "Preconnecting to" << url.host();
+
+#  ifndef QT_NO_SSL
+  if (url.scheme() == "https") {
+    // Offer HTTP/2, so that the requests allowing it can share this
+    // connection.
+    QSslConfiguration config = QSslConfiguration::defaultConfiguration();
+    config.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2,
+                                    QSslConfiguration::NextProtocolHttp1_1});
+    networkAccessManager()->connectToHostEncrypted(
+        url.host(), static_cast<quint16>(url.port(443)), config, QString());
+    return;
+  }
+#  endif
+
+  networkAccessManager()->connectToHost(url.host(),
+                                        static_cast<quint16>(url.port(80)));
+#endif
+}
+
 void NetworkManager::increaseNetworkRequestCount() { ++m_requestCount; }
 
 void NetworkManager::decreaseNetworkRequestCount() {
@@ -7,7 +7,10 @@
 
 #include <QObject>
 
+#include "networkresponsecache.h"
+
 class QNetworkAccessManager;
+class QUrl;
 
 class NetworkManager : public QObject {
   Q_OBJECT
@@ -28,6 +31,11 @@ class NetworkManager : public QObject {
 
   void clearCache();
 
+  // Opens a connection to the host of the URL ahead of the first request.
+  void preconnect(const QUrl& url);
+
+  NetworkResponseCache* responseCache() { return &m_responseCache; }
+
   void increaseNetworkRequestCount();
   void decreaseNetworkRequestCount();
 
@@ -40,6 +48,8 @@ class NetworkManager : public QObject {
  private:
   uint32_t m_requestCount = 0;
   bool m_clearCacheNeeded = false;
+
+  NetworkResponseCache m_responseCache;
 };
 
 #endif  // NETWORKMANAGER_H
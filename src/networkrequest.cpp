@@ -5,6 +5,7 @@
 #include "networkrequest.h"
 
 #include <QDirIterator>
+#include <QHash>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QNetworkAccessManager>
@@ -12,7 +13,10 @@
 #include <QNetworkRequest>
 #include <QRegularExpression>
 #include <QUrl>
+#include <utility>
 
+#include "constants.h"
+#include "feature/feature.h"
 #include "leakdetector.h"
 #include "logger.h"
 #include "models/apierror.h"
@@ -22,6 +26,8 @@
 
 constexpr int REQUEST_MAX_REDIRECTS = 4;
 
+constexpr int HTTP_STATUS_NOT_MODIFIED = 304;
+
 namespace {
 Logger logger("NetworkRequest");
 
@@ -40,6 +46,9 @@ std::function<bool(NetworkRequest*, const QByteArray&)> s_postResourceCallback =
 std::function<bool(NetworkRequest*, QIODevice*)>
     s_postResourceIODeviceCallback = nullptr;
 
+// The leaders of the GETs in flight, by NetworkRequest::pendingGetKey().
+QHash<QByteArray, NetworkRequest*> s_pendingGets;
+
 }  // namespace
 
 // static
@@ -108,6 +117,20 @@ NetworkRequest::NetworkRequest(Task* parent, int status) : QObject(parent) {
 NetworkRequest::~NetworkRequest() {
   MZ_COUNT_DTOR(NetworkRequest);
 
+  if (m_leader) {
+    m_leader->m_followers.removeOne(this);
+  } else if (!m_followers.isEmpty()) {
+    // The reply is still needed by the other requests sharing it.
+    if (m_reply && !m_reply->isFinished()) {
+      handOverReply();
+    }
+    for (NetworkRequest* follower : std::exchange(m_followers, {})) {
+      follower->m_leader = nullptr;
+      follower->m_reply = nullptr;
+    }
+  }
+  forgetPendingGet();
+
   // During the shutdown, the QML NetworkManager can be released before the
   // deletion of the pending network requests.
   if (NetworkManager::exists()) {
@@ -151,6 +174,10 @@ void NetworkRequest::post(const QUrl& url, QIODevice* uploadData) {
     return;
   }
 
+  if (isSharedApiRequest()) {
+    m_request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+  }
+
   QNetworkAccessManager* manager =
       NetworkManager::instance()->networkAccessManager();
   handleReply(manager->post(m_request, uploadData));
@@ -169,6 +196,10 @@ void NetworkRequest::post(const QUrl& url, const QByteArray& body) {
     return;
   }
 
+  if (isSharedApiRequest()) {
+    m_request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+  }
+
   QNetworkAccessManager* manager =
       NetworkManager::instance()->networkAccessManager();
   handleReply(manager->post(m_request, body));
@@ -183,6 +214,10 @@ void NetworkRequest::deleteResource(const QUrl& url) {
     return;
   }
 
+  if (isSharedApiRequest()) {
+    m_request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+  }
+
   QNetworkAccessManager* manager =
       NetworkManager::instance()->networkAccessManager();
   handleReply(manager->deleteResource(m_request));
@@ -250,8 +285,10 @@ void NetworkRequest::replyFinished() {
   logger.debug() << "Network reply received - status:" << status
                  << "- expected:" << expectStatusString();
 
-  m_replyData.append(m_reply->readAll());
+  readReplyData();
   processData(m_reply->error(), m_reply->errorString(), status, m_replyData);
+  completeFollowers(m_reply->error(), m_reply->errorString(), status,
+                    m_replyData);
 }
 
 void NetworkRequest::processData(QNetworkReply::NetworkError error,
@@ -259,15 +296,23 @@ void NetworkRequest::processData(QNetworkReply::NetworkError error,
                                  const QByteArray& data) {
   m_completed = true;
   m_timer.stop();
+  forgetPendingGet();
 
 #ifdef MZ_WASM
   m_finalStatusCode = status;
 #endif
 
+  if (status == HTTP_STATUS_NOT_MODIFIED && m_cachedResponse.isValid()) {
+    logger.debug() << "Network resource not modified";
+    emit requestNotModified(m_cachedResponse.m_data);
+    return;
+  }
+
   // Check for expected HTTP reponse statuses. This can distinguish successful
   // responses (eg: 200 vs. 201), but it allows for expected error conditions
   // (eg: 404 when it's okay for the resource not to exist).
   if ((status != 0) && m_expectedStatusCodes.contains(status)) {
+    maybeStoreResponse(error, status, data);
     emit requestCompleted(data);
     return;
   }
@@ -280,7 +325,8 @@ void NetworkRequest::processData(QNetworkReply::NetworkError error,
     // If the response looks and smells like guardian API error, then log it.
     ApiError err;
     QString contentType =
-        m_reply->header(QNetworkRequest::ContentTypeHeader).toString();
+        m_reply ? m_reply->header(QNetworkRequest::ContentTypeHeader).toString()
+                : QString();
     if (contentType.contains("json") && err.fromJson(data)) {
       logger.error() << "Remote API error" << err.errnum() << "-"
                      << err.message();
@@ -306,12 +352,30 @@ void NetworkRequest::processData(QNetworkReply::NetworkError error,
     return;
   }
 
+  maybeStoreResponse(error, status, data);
   emit requestCompleted(data);
 }
 
+void NetworkRequest::maybeStoreResponse(QNetworkReply::NetworkError error,
+                                        int status, const QByteArray& data) {
+  if (!m_responseCacheEnabled || !m_reply || m_leader ||
+      m_reply->operation() != QNetworkAccessManager::GetOperation ||
+      error != QNetworkReply::NoError || status != 200) {
+    return;
+  }
+
+  NetworkResponseCache::Entry entry;
+  entry.m_etag = m_reply->rawHeader("ETag");
+  entry.m_lastModified = m_reply->rawHeader("Last-Modified");
+  entry.m_data = data;
+
+  NetworkManager::instance()->responseCache()->store(
+      m_request.url(), m_request.rawHeader("Authorization"), entry);
+}
+
 qint64 NetworkRequest::discardData() {
   qint64 bytes = m_replyData.size();
-  if (m_reply != nullptr) {
+  if (m_reply != nullptr && !m_leader) {
     bytes += m_reply->skip(m_reply->bytesAvailable());
   }
   m_replyData.clear();
@@ -323,6 +387,21 @@ bool NetworkRequest::isRedirect() const {
   return status >= 300 && status < 400;
 }
 
+void NetworkRequest::readReplyData() {
+  QByteArray data = m_reply->readAll();
+  if (data.isEmpty()) {
+    return;
+  }
+
+  int status = statusCode();
+  if (m_streamingEnabled && status >= 200 && status < 300) {
+    emit requestDataReceived(data);
+    return;
+  }
+
+  m_replyData.append(data);
+}
+
 void NetworkRequest::handleHeaderReceived() {
   // Suppress this signal if a redirect is about to happen.
   int policy =
@@ -365,27 +444,154 @@ void NetworkRequest::timeout() {
   Q_ASSERT(!m_completed);
 
   m_completed = true;
+  forgetPendingGet();
 
-  if (m_reply) {
+  if (m_leader) {
+    // The shared reply goes on for the other requests.
+    detachFromLeader();
+    deleteLater();
+  } else if (m_reply) {
     m_reply->abort();
   }
 
   logger.error() << "Network request timeout";
   emit requestFailed(QNetworkReply::TimeoutError, QByteArray());
+
+  completeFollowers(QNetworkReply::TimeoutError, QString(), 0, QByteArray());
 }
 
 void NetworkRequest::getResource() {
+  if (m_responseCacheEnabled) {
+    m_cachedResponse = NetworkManager::instance()->responseCache()->lookup(
+        m_request.url(), m_request.rawHeader("Authorization"));
+    if (!m_cachedResponse.m_etag.isEmpty()) {
+      m_request.setRawHeader("If-None-Match", m_cachedResponse.m_etag);
+    }
+    if (!m_cachedResponse.m_lastModified.isEmpty()) {
+      m_request.setRawHeader("If-Modified-Since",
+                             m_cachedResponse.m_lastModified);
+    }
+  }
+
   if (s_getResourceCallback && s_getResourceCallback(this)) {
     return;
   }
 
+  if (isSharedApiRequest()) {
+    m_request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+    if (!m_streamingEnabled && joinPendingGet()) {
+      m_timer.start(REQUEST_TIMEOUT);
+      return;
+    }
+  }
+
   QNetworkAccessManager* manager =
       NetworkManager::instance()->networkAccessManager();
   handleReply(manager->get(m_request));
 
+  for (NetworkRequest* follower : m_followers) {
+    follower->m_reply = m_reply;
+  }
+
   m_timer.start(REQUEST_TIMEOUT);
 }
 
+bool NetworkRequest::isSharedApiRequest() const {
+  // Requests with a custom Host header are sent to an IP address, and keep
+  // their own connection.
+  return Feature::get(Feature::Feature_sharedApiConnections)->isSupported() &&
+         !m_request.hasRawHeader("Host") &&
+         m_request.url().host() == QUrl(Constants::apiBaseUrl()).host();
+}
+
+QByteArray NetworkRequest::pendingGetKey() const {
+  QByteArray key = m_request.url().toEncoded();
+  key.append('\n').append(QByteArray::number(
+      m_request.attribute(QNetworkRequest::RedirectPolicyAttribute).toInt()));
+
+  for (const QByteArray& header : m_request.rawHeaderList()) {
+    key.append('\n').append(header).append(':').append(
+        m_request.rawHeader(header));
+  }
+
+  return key;
+}
+
+bool NetworkRequest::joinPendingGet() {
+  forgetPendingGet();
+
+  QByteArray key = pendingGetKey();
+  NetworkRequest* leader = s_pendingGets.value(key);
+  if (leader && m_followers.isEmpty()) {
+    logger.debug() << "Sharing the reply of an identical request";
+    m_leader = leader;
+    m_reply = leader->m_reply;
+    leader->m_followers.append(this);
+    return true;
+  }
+
+  // The next identical GETs will share the reply of this one.
+  m_pendingGetKey = key;
+  s_pendingGets.insert(key, this);
+  return false;
+}
+
+void NetworkRequest::forgetPendingGet() {
+  if (m_pendingGetKey.isEmpty()) {
+    return;
+  }
+
+  if (s_pendingGets.value(m_pendingGetKey) == this) {
+    s_pendingGets.remove(m_pendingGetKey);
+  }
+  m_pendingGetKey.clear();
+}
+
+void NetworkRequest::detachFromLeader() {
+  Q_ASSERT(m_leader);
+
+  m_leader->m_followers.removeOne(this);
+  m_leader = nullptr;
+  m_reply = nullptr;
+}
+
+void NetworkRequest::handOverReply() {
+  Q_ASSERT(m_reply);
+  Q_ASSERT(!m_followers.isEmpty());
+
+  NetworkRequest* next = m_followers.takeFirst();
+  next->m_leader = nullptr;
+  next->m_reply = nullptr;
+
+  m_reply->disconnect(this);
+  next->handleReply(m_reply);
+  next->m_replyData = m_replyData;
+  next->m_followers = std::exchange(m_followers, {});
+  for (NetworkRequest* follower : next->m_followers) {
+    follower->m_leader = next;
+  }
+
+  if (!m_pendingGetKey.isEmpty()) {
+    next->m_pendingGetKey = m_pendingGetKey;
+    s_pendingGets.insert(m_pendingGetKey, next);
+    m_pendingGetKey.clear();
+  }
+
+  m_reply = nullptr;
+}
+
+void NetworkRequest::completeFollowers(QNetworkReply::NetworkError error,
+                                       const QString& errorString,
+                                       int status, const QByteArray& data) {
+  for (NetworkRequest* follower : std::exchange(m_followers, {})) {
+    follower->processData(error, errorString, status, data);
+    follower->m_leader = nullptr;
+    follower->m_reply = nullptr;
+    follower->deleteLater();
+  }
+}
+
 void NetworkRequest::handleReply(QNetworkReply* reply) {
   Q_ASSERT(reply);
   Q_ASSERT(!m_reply);
@@ -398,7 +604,7 @@ void NetworkRequest::handleReply(QNetworkReply* reply) {
 
   m_replyData.clear();
   connect(m_reply, &QIODevice::readyRead, this,
-          [&]() { m_replyData.append(m_reply->readAll()); });
+          &NetworkRequest::readReplyData);
 
 #ifndef QT_NO_SSL
   connect(m_reply, &QNetworkReply::sslErrors, this, &NetworkRequest::sslErrors);
@@ -453,9 +659,41 @@ QByteArray NetworkRequest::rawHeader(const QByteArray& headerName) const {
   return m_reply->rawHeader(headerName);
 }
 
+qint64 NetworkRequest::contentRangeStart() const {
+  // "bytes <first>-<last>/<complete length or *>"
+  QByteArray range = rawHeader("Content-Range").trimmed();
+  if (!range.startsWith("bytes ")) {
+    return -1;
+  }
+
+  qsizetype dash = range.indexOf('-');
+  if (dash < 0) {
+    return -1;
+  }
+
+  bool ok = false;
+  qint64 start = range.mid(6, dash - 6).trimmed().toLongLong(&ok);
+  return ok && start >= 0 ? start : -1;
+}
+
 void NetworkRequest::abort() {
   m_aborted = true;
 
+  if (m_leader || (m_reply && !m_followers.isEmpty())) {
+    // Only this request gives up. The reply goes on for the others sharing
+    // it.
+    if (m_leader) {
+      detachFromLeader();
+    } else {
+      handOverReply();
+    }
+
+    processData(QNetworkReply::OperationCanceledError, "Operation canceled", 0,
+                QByteArray());
+    deleteLater();
+    return;
+  }
+
   if (!m_reply) {
     logger.error() << "INTERNAL ERROR! NetworkRequest::abort called before "
                       "starting the request";
@@ -11,6 +11,8 @@
 #include <QTimer>
 #include <functional>
 
+#include "networkresponsecache.h"
+
 class QHostAddress;
 class QNetworkAccessManager;
 #ifndef QT_NO_SSL
@@ -38,6 +40,16 @@ class NetworkRequest final : public QObject {
 
   void addExpectedStatus(int code) { m_expectedStatusCodes.append(code); }
 
+  // Makes the next GET conditional on the response cached by the previous
+  // one. If the resource has not changed, requestNotModified is emitted
+  // instead of requestCompleted.
+  void enableResponseCache() { m_responseCacheEnabled = true; }
+
+  // Delivers the body of successful responses through requestDataReceived as
+  // it arrives, instead of keeping it in memory. requestCompleted is then
+  // emitted with no data. Error bodies are still handed to requestFailed.
+  void enableStreaming() { m_streamingEnabled = true; }
+
 #ifdef UNIT_TEST
   static void resetRequestHandler();
 #endif
@@ -61,6 +73,11 @@ class NetworkRequest final : public QObject {
   int statusCode() const;
 
   QByteArray rawHeader(const QByteArray& headerName) const;
+
+  // The position of the first byte of a partial response, from its
+  // Content-Range header, or -1 if the header is missing or malformed.
+  qint64 contentRangeStart() const;
+
   QUrl url() const { return m_reply ? m_reply->url() : m_request.url(); }
 
   void abort();
@@ -77,8 +94,22 @@ class NetworkRequest final : public QObject {
 
   void handleReply(QNetworkReply* reply);
   void handleHeaderReceived();
+  void readReplyData();
   void handleRedirect(const QUrl& url);
 
+  void maybeStoreResponse(QNetworkReply::NetworkError error, int status,
+                          const QByteArray& data);
+
+  bool isSharedApiRequest() const;
+  QByteArray pendingGetKey() const;
+  bool joinPendingGet();
+  void forgetPendingGet();
+  void detachFromLeader();
+  void handOverReply();
+  void completeFollowers(QNetworkReply::NetworkError error,
+                         const QString& errorString, int status,
+                         const QByteArray& data);
+
 #ifndef QT_NO_SSL
   bool checkSubjectName(const QSslCertificate& cert);
 #endif
@@ -101,6 +132,8 @@ class NetworkRequest final : public QObject {
   void requestFailed(QNetworkReply::NetworkError error, const QByteArray& data);
   void requestRedirected(NetworkRequest* request, const QUrl& url);
   void requestCompleted(const QByteArray& data);
+  void requestNotModified(const QByteArray& cachedData);
+  void requestDataReceived(const QByteArray& data);
   void requestUpdated(qint64 bytesReceived, qint64 bytesTotal,
                       QNetworkReply* reply);
   void uploadProgressed(qint64 bytesReceived, qint64 bytesTotal,
@@ -124,6 +157,16 @@ class NetworkRequest final : public QObject {
   QByteArray m_replyData;
   QList<int> m_expectedStatusCodes;
 
+  bool m_responseCacheEnabled = false;
+  bool m_streamingEnabled = false;
+  NetworkResponseCache::Entry m_cachedResponse;
+
+  // Identical GETs in flight share the reply of the first one, the leader.
+  // The followers don't own that reply, and are completed by the leader.
+  NetworkRequest* m_leader = nullptr;
+  QList<NetworkRequest*> m_followers;
+  QByteArray m_pendingGetKey;
+
 #ifdef MZ_WASM
   // In wasm network request, m_reply is null. So we need to store the "status
   // code" in a variable member.
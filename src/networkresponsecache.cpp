@@ -0,0 +1,181 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "networkresponsecache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QMessageAuthenticationCode>
+#include <QRandomGenerator>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QUrl>
+
+#include "hacl-star/Hacl_Chacha20Poly1305_32.h"
+#include "leakdetector.h"
+#include "logger.h"
+
+constexpr const char* RESPONSE_CACHE_FOLDER = "responses";
+
+// Bump this when the format of the entries changes.
+constexpr quint32 RESPONSE_CACHE_VERSION = 2;
+
+// Entries are encrypted with ChaCha20-Poly1305, with a key derived from the
+// Authorization header. The token itself only lives in the settings, so an
+// account-specific response can't be read from the cache folder alone.
+constexpr const char* RESPONSE_CACHE_KEY_LABEL = "MozillaVPN response cache";
+constexpr int RESPONSE_CACHE_NONCE_SIZE = 12;
+constexpr int RESPONSE_CACHE_MAC_SIZE = 16;
+
+namespace {
+Logger logger("NetworkResponseCache");
+
+QString rootAppFolder() {
+#ifdef MZ_WASM
+  // https://wiki.qt.io/Qt_for_WebAssembly#Files_and_local_file_system_access
+  return "/";
+#elif defined(UNIT_TEST)
+  return QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+#else
+  return QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+#endif
+}
+
+QByteArray sha256(const QByteArray& data) {
+  return QCryptographicHash::hash(data, QCryptographicHash::Sha256);
+}
+
+QByteArray encryptionKey(const QByteArray& authorization) {
+  return QMessageAuthenticationCode::hash(RESPONSE_CACHE_KEY_LABEL,
+                                          authorization,
+                                          QCryptographicHash::Sha256);
+}
+
+// The entry is bound to its URL and to the format version.
+QByteArray additionalData(const QUrl& url) {
+  QByteArray aad;
+  QDataStream stream(&aad, QIODevice::WriteOnly);
+  stream << RESPONSE_CACHE_VERSION << url.toEncoded();
+  return aad;
+}
+}  // namespace
+
+NetworkResponseCache::NetworkResponseCache()
+    : m_path(QDir(rootAppFolder()).filePath(RESPONSE_CACHE_FOLDER)) {
+  MZ_COUNT_CTOR(NetworkResponseCache);
+}
+
+NetworkResponseCache::~NetworkResponseCache() {
+  MZ_COUNT_DTOR(NetworkResponseCache);
+}
+
+QString NetworkResponseCache::fileName(const QUrl& url) const {
+  return QDir(m_path).filePath(
+      QString::fromLatin1(sha256(url.toEncoded()).toHex()));
+}
+
+NetworkResponseCache::Entry NetworkResponseCache::lookup(
+    const QUrl& url, const QByteArray& authorization) const {
+  QFile file(fileName(url));
+  if (!file.open(QIODevice::ReadOnly)) {
+    return Entry();
+  }
+
+  QDataStream stream(&file);
+  quint32 version = 0;
+  QByteArray nonce;
+  QByteArray mac;
+  QByteArray ciphertext;
+  stream >> version >> nonce >> mac >> ciphertext;
+
+  if (stream.status() != QDataStream::Ok ||
+      version != RESPONSE_CACHE_VERSION ||
+      nonce.length() != RESPONSE_CACHE_NONCE_SIZE ||
+      mac.length() != RESPONSE_CACHE_MAC_SIZE) {
+    // Entries of older versions were not encrypted: don't leave them behind.
+    logger.debug() << "Removing an invalid entry for" << url.path();
+    file.close();
+    QFile::remove(file.fileName());
+    return Entry();
+  }
+
+  // Decryption fails for an entry fetched with another Authorization header.
+  QByteArray key = encryptionKey(authorization);
+  QByteArray aad = additionalData(url);
+  QByteArray plaintext(ciphertext.length(), 0x00);
+  if (Hacl_Chacha20Poly1305_32_aead_decrypt(
+          (uint8_t*)key.data(), (uint8_t*)nonce.data(),
+          static_cast<uint32_t>(aad.length()), (uint8_t*)aad.data(),
+          static_cast<uint32_t>(ciphertext.length()),
+          (uint8_t*)plaintext.data(), (uint8_t*)ciphertext.data(),
+          (uint8_t*)mac.data()) != 0) {
+    return Entry();
+  }
+
+  QDataStream content(plaintext);
+  Entry entry;
+  content >> entry.m_etag >> entry.m_lastModified >> entry.m_data;
+  if (content.status() != QDataStream::Ok) {
+    return Entry();
+  }
+
+  return entry;
+}
+
+void NetworkResponseCache::store(const QUrl& url,
+                                 const QByteArray& authorization,
+                                 const Entry& entry) {
+  if (!entry.isValid()) {
+    QFile::remove(fileName(url));
+    return;
+  }
+
+  if (!QDir().mkpath(m_path)) {
+    logger.warning() << "Unable to create the response cache folder";
+    return;
+  }
+
+  QByteArray plaintext;
+  {
+    QDataStream content(&plaintext, QIODevice::WriteOnly);
+    content << entry.m_etag << entry.m_lastModified << entry.m_data;
+  }
+
+  QByteArray nonce(RESPONSE_CACHE_NONCE_SIZE, 0x00);
+  QRandomGenerator::system()->fillRange(
+      reinterpret_cast<quint32*>(nonce.data()), nonce.length() / 4);
+
+  QByteArray key = encryptionKey(authorization);
+  QByteArray aad = additionalData(url);
+  QByteArray ciphertext(plaintext.length(), 0x00);
+  QByteArray mac(RESPONSE_CACHE_MAC_SIZE, 0x00);
+  Hacl_Chacha20Poly1305_32_aead_encrypt(
+      (uint8_t*)key.data(), (uint8_t*)nonce.data(),
+      static_cast<uint32_t>(aad.length()), (uint8_t*)aad.data(),
+      static_cast<uint32_t>(plaintext.length()), (uint8_t*)plaintext.data(),
+      (uint8_t*)ciphertext.data(), (uint8_t*)mac.data());
+
+  QSaveFile file(fileName(url));
+  if (!file.open(QIODevice::WriteOnly)) {
+    logger.warning() << "Unable to open the response cache entry"
+                     << file.errorString();
+    return;
+  }
+
+  QDataStream stream(&file);
+  stream << RESPONSE_CACHE_VERSION << nonce << mac << ciphertext;
+
+  if (stream.status() != QDataStream::Ok || !file.commit()) {
+    logger.warning() << "Unable to write the response cache entry";
+  }
+}
+
+void NetworkResponseCache::clear() {
+  QDir dir(m_path);
+  if (dir.exists() && !dir.removeRecursively()) {
+    logger.warning() << "Unable to remove the response cache";
+  }
+}
@@ -0,0 +1,59 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef NETWORKRESPONSECACHE_H
+#define NETWORKRESPONSECACHE_H
+
+#include <QByteArray>
+#include <QString>
+
+class QUrl;
+
+/**
+ * @brief On-disk cache of the responses of periodic GET requests
+ *
+ * Each entry keeps the body of the last successful response, together with
+ * its ETag and Last-Modified validators, so that the next request can be
+ * made conditional. Entries are encrypted with a key derived from the
+ * Authorization header they were fetched with, and are ignored once it
+ * changes.
+ */
+class NetworkResponseCache final {
+  Q_DISABLE_COPY_MOVE(NetworkResponseCache)
+
+ public:
+  struct Entry {
+    QByteArray m_etag;
+    QByteArray m_lastModified;
+    QByteArray m_data;
+
+    bool isValid() const {
+      return !m_etag.isEmpty() || !m_lastModified.isEmpty();
+    }
+  };
+
+  NetworkResponseCache();
+  ~NetworkResponseCache();
+
+  Entry lookup(const QUrl& url, const QByteArray& authorization) const;
+
+  // Stores the response, or drops the entry if it has no validators.
+  void store(const QUrl& url, const QByteArray& authorization,
+             const Entry& entry);
+
+  void clear();
+
+  QString path() const { return m_path; }
+
+#ifdef UNIT_TEST
+  void setPath(const QString& path) { m_path = path; }
+#endif
+
+ private:
+  QString fileName(const QUrl& url) const;
+
+  QString m_path;
+};
+
+#endif  // NETWORKRESPONSECACHE_H
@@ -5,6 +5,7 @@
 #include "pinghelper.h"
 
 #include <QDateTime>
+#include <algorithm>
 #include <cmath>
 
 #include "dnspingsender.h"
@@ -71,6 +72,12 @@ void PingHelper::start(const QString& serverIpv4Gateway,
     m_pingData[i].latency = -1;
     m_pingData[i].sequence = 0;
   }
+  m_newestIndex = -1;
+  m_unansweredCount = 0;
+  m_latencySum = 0;
+  m_latencyMean = 0;
+  m_latencyM2 = 0;
+  m_sortedLatencies.clear();
 
   m_pingTimer.start(PING_TIMEOUT);
 }
@@ -88,16 +95,10 @@ void PingHelper::stop() {
 
 void PingHelper::nextPing() {
 #ifdef MZ_DEBUG
-  logger.debug() << "Sending ping seq:" << m_sequence;
+  MZ_LOG(logger, Debug) << "Sending ping seq:" << m_sequence;
 #endif
 
-  // The ICMP sequence number is used to match replies with their originating
-  // request, and serves as an index into the circular buffer. Overflows of
-  // the sequence number acceptable.
-  int index = m_sequence % PING_STATS_WINDOW;
-  m_pingData[index].timestamp = QDateTime::currentMSecsSinceEpoch();
-  m_pingData[index].latency = -1;
-  m_pingData[index].sequence = m_sequence;
+  storePing(m_sequence, QDateTime::currentMSecsSinceEpoch());
   m_pingSender->sendPing(m_gateway, m_sequence);
 
   m_sequence++;
@@ -107,91 +108,145 @@ void PingHelper::pingReceived(quint16 sequence) {
   int index = sequence % PING_STATS_WINDOW;
   if (m_pingData[index].sequence == sequence) {
     qint64 sendTime = m_pingData[index].timestamp;
-    m_pingData[index].latency = QDateTime::currentMSecsSinceEpoch() - sendTime;
+    storeLatency(sequence, QDateTime::currentMSecsSinceEpoch() - sendTime);
     emit pingSentAndReceived(m_pingData[index].latency);
 #ifdef MZ_DEBUG
-    logger.debug() << "Ping answer received seq:" << sequence
-                   << "avg:" << latency()
-                   << "loss:" << QString("%1%").arg(loss() * 100.0)
-                   << "stddev:" << stddev();
+    MZ_LOG(logger, Debug) << "Ping answer received seq:" << sequence
+                          << "avg:" << latency()
+                          << "loss:" << QString("%1%").arg(loss() * 100.0)
+                          << "stddev:" << stddev() << "p95:" << percentile(95);
 #endif
   }
 }
 
-uint PingHelper::latency() const {
-  int recvCount = 0;
-  qint64 totalMsec = 0;
+void PingHelper::storePing(quint16 sequence, qint64 timestamp) {
+  // The ICMP sequence number is used to match replies with their originating
+  // request, and serves as an index into the circular buffer. Overflows of
+  // the sequence number acceptable.
+  int index = sequence % PING_STATS_WINDOW;
+  PingSendData& data = m_pingData[index];
 
-  for (const PingSendData& data : m_pingData) {
-    if (data.latency < 0) {
-      continue;
-    }
-    recvCount++;
-    totalMsec += data.latency;
+  if (data.latency >= 0) {
+    removeLatency(data.latency);
+  } else if (data.timestamp > 0) {
+    m_unansweredCount--;
   }
 
-  if (recvCount <= 0) {
-    return 0.0;
+  data.timestamp = timestamp;
+  data.latency = -1;
+  data.sequence = sequence;
+  m_newestIndex = index;
+
+  if (timestamp > 0) {
+    m_unansweredCount++;
   }
+}
 
-  // Add half the denominator to produce nearest-integer rounding.
-  totalMsec += recvCount / 2;
-  return static_cast<uint>(totalMsec / recvCount);
+void PingHelper::storeLatency(quint16 sequence, qint64 latency) {
+  PingSendData& data = m_pingData[sequence % PING_STATS_WINDOW];
+  Q_ASSERT(data.sequence == sequence);
+
+  if (data.latency >= 0) {
+    removeLatency(data.latency);
+  } else if (data.timestamp > 0) {
+    m_unansweredCount--;
+  }
+
+  data.latency = latency;
+  addLatency(latency);
 }
 
-uint PingHelper::stddev() const {
-  int recvCount = 0;
-  qint64 totalVariance = 0;
-  uint average = PingHelper::latency();
+void PingHelper::addLatency(qint64 latency) {
+  m_latencySum += latency;
+  m_sortedLatencies.insert(std::upper_bound(m_sortedLatencies.begin(),
+                                            m_sortedLatencies.end(), latency),
+                           latency);
 
-  for (const PingSendData& data : m_pingData) {
-    if (data.latency < 0) {
-      continue;
-    }
-    recvCount++;
-    totalVariance += (average - data.latency) * (average - data.latency);
+  const double delta = latency - m_latencyMean;
+  m_latencyMean += delta / m_sortedLatencies.size();
+  m_latencyM2 += delta * (latency - m_latencyMean);
+}
+
+void PingHelper::removeLatency(qint64 latency) {
+  m_latencySum -= latency;
+  auto it = std::lower_bound(m_sortedLatencies.begin(),
+                             m_sortedLatencies.end(), latency);
+  Q_ASSERT(it != m_sortedLatencies.end() && *it == latency);
+  m_sortedLatencies.erase(it);
+
+  if (m_sortedLatencies.isEmpty()) {
+    // Start again from scratch, rather than carrying the rounding errors.
+    m_latencyMean = 0;
+    m_latencyM2 = 0;
+    return;
   }
 
+  const double delta = latency - m_latencyMean;
+  m_latencyMean -= delta / m_sortedLatencies.size();
+  m_latencyM2 = qMax(0.0, m_latencyM2 - delta * (latency - m_latencyMean));
+}
+
+uint PingHelper::latency() const {
+  qint64 recvCount = m_sortedLatencies.size();
   if (recvCount <= 0) {
     return 0.0;
   }
 
-  return std::sqrt((double)totalVariance / recvCount);
+  // Add half the denominator to produce nearest-integer rounding.
+  return static_cast<uint>((m_latencySum + recvCount / 2) / recvCount);
+}
+
+uint PingHelper::stddev() const {
+  if (m_sortedLatencies.isEmpty()) {
+    return 0.0;
+  }
+
+  return std::sqrt(m_latencyM2 / m_sortedLatencies.size());
 }
 
 uint PingHelper::maximum() const {
-  uint maxRtt = 0;
+  // Latencies that do not fit are ignored.
+  auto it = std::lower_bound(m_sortedLatencies.begin(), m_sortedLatencies.end(),
+                             qint64(std::numeric_limits<uint>::max()));
+  if (it == m_sortedLatencies.begin()) {
+    return 0;
+  }
+  return static_cast<uint>(*(it - 1));
+}
 
-  for (const PingSendData& data : m_pingData) {
-    if (data.latency < 0) {
-      continue;
-    }
-    if (data.latency > maxRtt &&
-        data.latency < std::numeric_limits<uint>::max()) {
-      maxRtt = static_cast<uint>(data.latency);
-    }
+uint PingHelper::percentile(int percent) const {
+  Q_ASSERT(percent >= 0 && percent <= 100);
+
+  if (m_sortedLatencies.isEmpty()) {
+    return 0;
   }
-  return maxRtt;
+
+  qsizetype rank = (m_sortedLatencies.size() * percent + 99) / 100;
+  qint64 latency = m_sortedLatencies.at(qMax<qsizetype>(rank, 1) - 1);
+  return static_cast<uint>(
+      qMin<qint64>(latency, std::numeric_limits<uint>::max()));
 }
 
 double PingHelper::loss() const {
-  int sendCount = 0;
-  int recvCount = 0;
-  // Don't count pings that are possibly still in flight as losses.
+  // Don't count pings that are possibly still in flight as losses. They are
+  // the newest ones, so the walk back stops at the first older ping.
   qint64 sendBefore =
       QDateTime::currentMSecsSinceEpoch() - (PING_TIMEOUT.count());
 
-  for (const PingSendData& data : m_pingData) {
-    if (data.latency >= 0) {
-      recvCount++;
-      sendCount++;
-    } else if ((data.timestamp > 0) && (data.timestamp < sendBefore)) {
-      sendCount++;
+  int lostCount = m_unansweredCount;
+  for (int i = 0, index = m_newestIndex; index >= 0 && i < PING_STATS_WINDOW;
+       ++i, index = (index + PING_STATS_WINDOW - 1) % PING_STATS_WINDOW) {
+    const PingSendData& data = m_pingData[index];
+    if (data.timestamp < sendBefore) {
+      break;
+    }
+    if (data.latency < 0) {
+      lostCount--;
     }
   }
 
-  if (sendCount <= 0) {
+  if (lostCount <= 0) {
     return 0.0;
   }
-  return (double)(sendCount - recvCount) / PING_STATS_WINDOW;
+  return (double)lostCount / PING_STATS_WINDOW;
 }
@@ -31,6 +31,9 @@ class PingHelper final : public QObject {
   uint maximum() const;
   double loss() const;
 
+  // Nearest-rank percentile of the latencies in the window, in msec.
+  uint percentile(int percent) const;
+
  signals:
   void pingSentAndReceived(qint64 msec);
 
@@ -39,6 +42,13 @@ class PingHelper final : public QObject {
 
   void pingReceived(quint16 sequence);
 
+  // Fill a slot of the window, keeping the statistics up to date.
+  void storePing(quint16 sequence, qint64 timestamp);
+  void storeLatency(quint16 sequence, qint64 latency);
+
+  void addLatency(qint64 latency);
+  void removeLatency(qint64 latency);
+
  private:
   QHostAddress m_gateway;
   QHostAddress m_source;
@@ -57,6 +67,15 @@ class PingHelper final : public QObject {
   };
   QVector<PingSendData> m_pingData;
 
+  // Statistics of the window, updated at each ping and reply. The mean and
+  // the variance are kept with Welford's algorithm.
+  int m_newestIndex = -1;
+  int m_unansweredCount = 0;
+  qint64 m_latencySum = 0;
+  double m_latencyMean = 0;
+  double m_latencyM2 = 0;
+  QList<qint64> m_sortedLatencies;
+
   QTimer m_pingTimer;
   PingSender* m_pingSender = nullptr;
 
@@ -10,6 +10,12 @@ namespace {
 Logger logger("PingSender");
 }
 
+void PingSender::sendPings(const QList<PingRequest>& requests) {
+  for (const PingRequest& request : requests) {
+    sendPing(request.destination, request.sequence);
+  }
+}
+
 quint16 PingSender::inetChecksum(const void* data, size_t len) {
   int nleft, sum;
   quint16* w;
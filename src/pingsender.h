@@ -7,6 +7,7 @@
 
 #include <QElapsedTimer>
 #include <QHostAddress>
+#include <QList>
 #include <QObject>
 
 class PingSender : public QObject {
@@ -21,6 +22,16 @@ class PingSender : public QObject {
 
   virtual void sendPing(const QHostAddress& destination, quint16 sequence) = 0;
 
+  struct PingRequest {
+    QHostAddress destination;
+    quint16 sequence;
+  };
+
+  // Send a burst of pings. Platforms that can hand several datagrams to the
+  // kernel in one call should override this, otherwise each ping is sent
+  // individually through sendPing().
+  virtual void sendPings(const QList<PingRequest>& requests);
+
   static quint16 inetChecksum(const void* data, size_t length);
 
  signals:
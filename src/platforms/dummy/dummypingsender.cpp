@@ -21,5 +21,10 @@ DummyPingSender::~DummyPingSender() { MZ_COUNT_DTOR(DummyPingSender); }
 
 void DummyPingSender::sendPing(const QHostAddress& dest, quint16 sequence) {
   logger.debug() << "Dummy ping to:" << dest.toString();
-  emit recvPing(sequence);
+
+  // Answer from the event loop, like a real reply would, so that the caller
+  // is never re-entered from within sendPing().
+  QMetaObject::invokeMethod(
+      this, [this, sequence]() { emit recvPing(sequence); },
+      Qt::QueuedConnection);
 }
@@ -4,12 +4,17 @@
 
 #include "apptracker.h"
 
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
 #include <unistd.h>
 
 #include <QDBusConnection>
 #include <QDBusInterface>
+#include <QDBusPendingCallWatcher>
 #include <QMetaType>
 #include <QScopeGuard>
+#include <QSocketNotifier>
 #include <QtDBus/QtDBus>
 
 #include "leakdetector.h"
@@ -24,6 +29,14 @@ constexpr const char* DBUS_SYSTEMD_SERVICE = "org.freedesktop.systemd1";
 constexpr const char* DBUS_SYSTEMD_PATH = "/org/freedesktop/systemd1";
 constexpr const char* DBUS_SYSTEMD_MANAGER = "org.freedesktop.systemd1.Manager";
 constexpr const char* DBUS_SYSTEMD_UNIT = "org.freedesktop.systemd1.Unit";
+constexpr const char* DBUS_SYSTEMD_UNIT_PATH = "/org/freedesktop/systemd1/unit";
+constexpr const char* DBUS_PROPERTIES = "org.freedesktop.DBus.Properties";
+
+// Scope names embed a PID or a UUID, so the cache only needs to outlive the
+// bursts of helper processes.
+constexpr qsizetype APPTRACKER_MAX_CACHED_UNITS = 1024;
+
+constexpr uint32_t APPTRACKER_INOTIFY_MASK = IN_CREATE | IN_DELETE | IN_ONLYDIR;
 
 namespace {
 Logger logger("AppTracker");
@@ -35,12 +48,29 @@ AppTracker::AppTracker(QObject* parent) : QObject(parent) {
 
   /* Monitor for changes to the user's application control groups. */
   m_cgroupMount = LinuxUtils::findCgroup2Path();
+
+  m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_inotifyFd < 0) {
+    logger.error() << "Failed to create the inotify instance:"
+                   << strerror(errno);
+    return;
+  }
+
+  m_inotifyNotifier =
+      new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+  connect(m_inotifyNotifier, &QSocketNotifier::activated, this,
+          &AppTracker::readEvents);
 }
 
 AppTracker::~AppTracker() {
   MZ_COUNT_DTOR(AppTracker);
   logger.debug() << "AppTracker destroyed.";
 
+  delete m_inotifyNotifier;
+  if (m_inotifyFd >= 0) {
+    close(m_inotifyFd);
+  }
+
   m_runningCgroups.clear();
 }
 
@@ -67,23 +97,41 @@ void AppTracker::userCreated(uint userid, const QString& xdgRuntimePath) {
       QDBusConnection::connectToBus(busPath, "user-" + QString::number(userid));
 
   // Watch the user's control groups for new application scopes.
-  m_systemdInterface =
-      new QDBusInterface(DBUS_SYSTEMD_SERVICE, DBUS_SYSTEMD_PATH,
-                         DBUS_SYSTEMD_MANAGER, connection, this);
-  QVariant qv = m_systemdInterface->property("ControlGroup");
+  QDBusInterface systemdInterface(DBUS_SYSTEMD_SERVICE, DBUS_SYSTEMD_PATH,
+                                  DBUS_SYSTEMD_MANAGER, connection);
+  QVariant qv = systemdInterface.property("ControlGroup");
   if (!m_cgroupMount.isEmpty() && qv.typeId() == QMetaType::QString) {
     QString userCgroupPath = m_cgroupMount + qv.toString();
     logger.debug() << "Monitoring Control Groups v2 at:" << userCgroupPath;
 
-    connect(&m_cgroupWatcher, SIGNAL(directoryChanged(QString)), this,
-            SLOT(cgroupsChanged(QString)));
+    addWatch(userCgroupPath, connection.name());
+    addWatch(userCgroupPath + "/app.slice", connection.name());
+  }
+}
+
+void AppTracker::addWatch(const QString& directory, const QString& busName) {
+  if (m_inotifyFd < 0) {
+    return;
+  }
 
-    m_cgroupWatcher.addPath(userCgroupPath);
-    m_cgroupWatcher.addPath(userCgroupPath + "/app.slice");
+  int wd = inotify_add_watch(m_inotifyFd, qPrintable(directory),
+                             APPTRACKER_INOTIFY_MASK);
+  if (wd < 0) {
+    logger.warning() << "Failed to watch" << directory << strerror(errno);
+    return;
+  }
 
-    cgroupsChanged(userCgroupPath);
-    cgroupsChanged(userCgroupPath + "/app.slice");
+  // We need the path starting from the Cgroupv2 mount point.
+  QString canonicalPath = QFileInfo(directory).canonicalFilePath();
+  QString path = QDir(m_cgroupMount).relativeFilePath(canonicalPath);
+  if (!path.startsWith('/')) {
+    path.prepend('/');
   }
+
+  Watch& watch = m_watches[wd];
+  watch.m_path = path;
+  watch.m_busName = busName;
+  rescan(watch);
 }
 
 void AppTracker::userRemoved(uint userid) {
@@ -158,10 +206,38 @@ QString AppTracker::snapDesktopFileId(const QString& scope) {
   return QString("%1_%2.desktop").arg(package).arg(app);
 }
 
-// Make an attempt to resolve the desktop ID from a cgroup scope.
-QString AppTracker::findDesktopFileId(const QString& cgroup) {
-  QString scopeName = QFileInfo(cgroup).fileName();
+// static
+bool AppTracker::isScope(const QString& name) {
+  return name.endsWith(".scope") || name.endsWith("@autostart.service");
+}
+
+// static
+// Object path of a systemd unit, escaped like sd_bus_path_encode() does. This
+// saves a GetUnit round trip for each lookup.
+QString AppTracker::unitPath(const QString& unitName) {
+  QByteArray name = unitName.toUtf8();
+  if (name.isEmpty()) {
+    return QString("%1/_").arg(DBUS_SYSTEMD_UNIT_PATH);
+  }
+
+  QString path = QString("%1/").arg(DBUS_SYSTEMD_UNIT_PATH);
+  for (qsizetype i = 0; i < name.length(); i++) {
+    char c = name.at(i);
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+        (i > 0 && c >= '0' && c <= '9')) {
+      path.append(QChar(c));
+    } else {
+      path.append(QString("_%1").arg(quint8(c), 2, 16, QChar('0')));
+    }
+  }
+  return path;
+}
 
+// static
+// Make an attempt to resolve the desktop ID from the name of a cgroup scope.
+// Returns nothing if only systemd can tell.
+std::optional<QString> AppTracker::scopeDesktopFileId(
+    const QString& scopeName) {
   // Reverse the desktop ID from a cgroup scope and known launcher tools.
   if (scopeName.startsWith("app-gnome-") ||
       scopeName.startsWith("app-flatpak-")) {
@@ -198,57 +274,177 @@ QString AppTracker::findDesktopFileId(const QString& cgroup) {
     return snapDesktopFileId(scopeName);
   }
 
-  // Query the systemd unit for its SourcePath property, which is set to the
-  // desktop file's full path on KDE
-  QDBusReply<QDBusObjectPath> objPath =
-      m_systemdInterface->call("GetUnit", scopeName);
-
-  QDBusInterface interface(DBUS_SYSTEMD_SERVICE, objPath.value().path(),
-                           DBUS_SYSTEMD_UNIT, m_systemdInterface->connection(),
-                           this);
-  QString source = interface.property("SourcePath").toString();
-  if (!source.isEmpty() && source.endsWith(".desktop")) {
-    return LinuxUtils::desktopFileId(source);
-  }
-
-  // Otherwise, we don't know the desktop ID for this control group.
-  return QString();
-}
-
-void AppTracker::cgroupsChanged(const QString& directory) {
-  QDir dir(directory);
-  QDir mountpoint(m_cgroupMount);
-  QFileInfoList newScopes = dir.entryInfoList(
-      QStringList{"*.scope", "*@autostart.service"}, QDir::Dirs);
-  QStringList oldScopes = m_runningCgroups.keys();
-
-  // Figure out what has been added.
-  for (const QFileInfo& scope : newScopes) {
-    // We need the path starting from the Cgroupv2 mount point.
-    QString path = mountpoint.relativeFilePath(scope.canonicalFilePath());
-    if (!path.startsWith('/')) {
-      path.prepend('/');
+  return std::nullopt;
+}
+
+void AppTracker::readEvents() {
+  alignas(struct inotify_event) char buffer[4096];
+
+  while (true) {
+    ssize_t len = read(m_inotifyFd, buffer, sizeof(buffer));
+    if (len <= 0) {
+      if (len < 0 && errno != EAGAIN && errno != EINTR) {
+        logger.error() << "Failed to read inotify events:" << strerror(errno);
+      }
+      return;
     }
 
-    if (oldScopes.removeAll(path) == 0) {
-      // This is a new scope, let's add it.
-      logger.debug() << "Control group created:" << path;
-      QString desktopFileId = findDesktopFileId(path);
-      m_runningCgroups[path] = desktopFileId;
+    // Only the entries that changed are handled.
+    for (ssize_t offset = 0; offset < len;) {
+      const struct inotify_event* event =
+          reinterpret_cast<const struct inotify_event*>(buffer + offset);
+      offset += sizeof(struct inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        // Some events were lost: compare everything again.
+        logger.warning() << "inotify queue overflow";
+        for (const Watch& watch : std::as_const(m_watches)) {
+          rescan(watch);
+        }
+        continue;
+      }
+
+      if (event->mask & IN_IGNORED) {
+        m_watches.remove(event->wd);
+        continue;
+      }
+
+      auto watch = m_watches.constFind(event->wd);
+      if (watch == m_watches.cend() || !(event->mask & IN_ISDIR) ||
+          event->len == 0) {
+        continue;
+      }
+
+      QString name = QString::fromUtf8(event->name);
+      if (!isScope(name)) {
+        continue;
+      }
+
+      if (event->mask & IN_CREATE) {
+        scopeCreated(*watch, name);
+      } else if (event->mask & IN_DELETE) {
+        scopeRemoved(watch->m_path + "/" + name);
+      }
+    }
+  }
+}
+
+void AppTracker::rescan(const Watch& watch) {
+  QDir dir(m_cgroupMount + watch.m_path);
+  QSet<QString> found;
+  for (const QString& name : dir.entryList(
+           QStringList{"*.scope", "*@autostart.service"}, QDir::Dirs)) {
+    found.insert(watch.m_path + "/" + name);
+    scopeCreated(watch, name);
+  }
 
-      emit appLaunched(path, desktopFileId);
+  // Anything else in the same directory has been removed.
+  QStringList known = m_runningCgroups.keys();
+  for (const QStringList& paths : std::as_const(m_pendingUnits)) {
+    known.append(paths);
+  }
+  for (const QString& cgroup : known) {
+    if (!found.contains(cgroup) &&
+        cgroup.section('/', 0, -2) == watch.m_path) {
+      scopeRemoved(cgroup);
     }
   }
+}
+
+void AppTracker::scopeCreated(const Watch& watch, const QString& scopeName) {
+  QString cgroup = watch.m_path + "/" + scopeName;
+  if (m_runningCgroups.contains(cgroup) ||
+      m_pendingUnits.value(scopeName).contains(cgroup)) {
+    return;
+  }
 
-  // Anything left, if it shares the same root directory, has been removed.
-  for (const QString& scope : oldScopes) {
-    QFileInfo scopeInfo(m_cgroupMount + scope);
-    if (scopeInfo.absolutePath() == directory) {
-      logger.debug() << "Control group removed:" << scope;
-      Q_ASSERT(m_runningCgroups.contains(scope));
-      QString desktopFileId = m_runningCgroups.take(scope);
+  logger.debug() << "Control group created:" << cgroup;
 
-      emit appTerminated(scope, desktopFileId);
+  std::optional<QString> desktopFileId = scopeDesktopFileId(scopeName);
+  if (desktopFileId.has_value()) {
+    appFound(cgroup, desktopFileId.value());
+    return;
+  }
+
+  auto cached = m_unitCache.constFind(scopeName);
+  if (cached != m_unitCache.cend()) {
+    appFound(cgroup, cached.value());
+    return;
+  }
+
+  // Concurrent control groups of the same scope share the same call.
+  bool inFlight = m_pendingUnits.contains(scopeName);
+  m_pendingUnits[scopeName].append(cgroup);
+  if (inFlight) {
+    return;
+  }
+
+  // Query the systemd unit for its SourcePath property, which is set to the
+  // desktop file's full path on KDE. The calls are asynchronous, so that a
+  // burst of new scopes does not block the daemon.
+  QDBusMessage call = QDBusMessage::createMethodCall(
+      DBUS_SYSTEMD_SERVICE, unitPath(scopeName), DBUS_PROPERTIES, "Get");
+  call << QString(DBUS_SYSTEMD_UNIT) << QString("SourcePath");
+
+  QDBusConnection connection(watch.m_busName);
+  QDBusPendingCallWatcher* watcher =
+      new QDBusPendingCallWatcher(connection.asyncCall(call), this);
+  connect(watcher, &QDBusPendingCallWatcher::finished, this,
+          [this, scopeName](QDBusPendingCallWatcher* call) {
+            unitLookupCompleted(scopeName, call);
+          });
+  connect(watcher, &QDBusPendingCallWatcher::finished, watcher,
+          &QObject::deleteLater);
+}
+
+void AppTracker::unitLookupCompleted(const QString& scopeName,
+                                     QDBusPendingCallWatcher* call) {
+  QDBusPendingReply<QDBusVariant> reply = *call;
+
+  QString desktopFileId;
+  if (reply.isError()) {
+    logger.debug() << "Failed to get the unit of" << scopeName
+                   << reply.error().message();
+  } else {
+    QString source = reply.value().variant().toString();
+    if (!source.isEmpty() && source.endsWith(".desktop")) {
+      desktopFileId = LinuxUtils::desktopFileId(source);
     }
   }
+
+  if (m_unitCache.size() >= APPTRACKER_MAX_CACHED_UNITS) {
+    m_unitCache.clear();
+  }
+  m_unitCache.insert(scopeName, desktopFileId);
+
+  // Control groups removed in the meantime are no longer in the list.
+  for (const QString& cgroup : m_pendingUnits.take(scopeName)) {
+    appFound(cgroup, desktopFileId);
+  }
+}
+
+void AppTracker::appFound(const QString& cgroup,
+                          const QString& desktopFileId) {
+  m_runningCgroups[cgroup] = desktopFileId;
+  emit appLaunched(cgroup, desktopFileId);
+}
+
+void AppTracker::scopeRemoved(const QString& cgroup) {
+  auto pending = m_pendingUnits.find(cgroup.section('/', -1));
+  if (pending != m_pendingUnits.end() && pending->removeOne(cgroup)) {
+    // Its desktop file ID was never known: nothing was launched.
+    logger.debug() << "Control group removed:" << cgroup;
+    return;
+  }
+
+  auto running = m_runningCgroups.find(cgroup);
+  if (running == m_runningCgroups.end()) {
+    return;
+  }
+
+  logger.debug() << "Control group removed:" << cgroup;
+  QString desktopFileId = running.value();
+  m_runningCgroups.erase(running);
+
+  emit appTerminated(cgroup, desktopFileId);
 }
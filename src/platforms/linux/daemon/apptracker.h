@@ -5,13 +5,14 @@
 #ifndef APPTRACKER_H
 #define APPTRACKER_H
 
-#include <QFileSystemWatcher>
 #include <QHash>
 #include <QString>
+#include <optional>
 
 #include "leakdetector.h"
 
-class QDBusInterface;
+class QDBusPendingCallWatcher;
+class QSocketNotifier;
 
 // Applications on Linux can be a bit vague and hard to define at runtime, so
 // we need to make some assumptions to try and tackle the problem.
@@ -77,25 +78,55 @@ class AppTracker final : public QObject {
   void appLaunched(const QString& cgroup, const QString& desktopFileId);
   void appTerminated(const QString& cgroup, const QString& desktopFileId);
 
- private slots:
-  void cgroupsChanged(const QString& directory);
-
  private:
-  QString findDesktopFileId(const QString& cgroup);
+  // A directory of control groups, watched with inotify.
+  struct Watch {
+    // Path from the cgroup v2 mount point.
+    QString m_path;
+    // Name of the user's D-Bus connection, used to ask systemd.
+    QString m_busName;
+  };
+
+  void addWatch(const QString& directory, const QString& busName);
+  void readEvents();
+  void rescan(const Watch& watch);
+
+  void scopeCreated(const Watch& watch, const QString& scopeName);
+  void scopeRemoved(const QString& cgroup);
+  void appFound(const QString& cgroup, const QString& desktopFileId);
+
+  void unitLookupCompleted(const QString& scopeName,
+                           QDBusPendingCallWatcher* call);
+
+  static bool isScope(const QString& name);
+  static QString unitPath(const QString& unitName);
+  static std::optional<QString> scopeDesktopFileId(const QString& scopeName);
   static QString snapDesktopFileId(const QString& cgroup);
   static QString decodeUnicodeEscape(const QString& str);
 
  private:
   // Monitoring of the user's control groups.
   QString m_cgroupMount;
-  QFileSystemWatcher m_cgroupWatcher;
-  QDBusInterface* m_systemdInterface = nullptr;
+  int m_inotifyFd = -1;
+  QSocketNotifier* m_inotifyNotifier = nullptr;
+  QHash<int, Watch> m_watches;
 
   // The set of control groups that are currently running, and the desktop file
   // IDs to which we have mapped them. The key to this QHash is the control
   // group path, and the value is the mapped desktop file ID, or an empty
   // QString if unknown.
   QHash<QString, QString> m_runningCgroups;
+
+  // Control groups waiting for systemd to tell their desktop file ID, by
+  // scope name. There is one D-Bus call in flight for each key.
+  QHash<QString, QStringList> m_pendingUnits;
+
+  // Desktop file IDs that systemd told us, by scope name.
+  QHash<QString, QString> m_unitCache;
+
+#ifdef UNIT_TEST
+  friend class TestAppTracker;
+#endif
 };
 
 #endif  // APPTRACKER_H
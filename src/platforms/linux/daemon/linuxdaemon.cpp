@@ -3,6 +3,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "command.h"
+#include "commandlineparser.h"
 #include "dbus_adaptor.h"
 #include "dbusservice.h"
 #include "leakdetector.h"
@@ -25,7 +26,30 @@ class CommandLinuxDaemon final : public Command {
 
   int run(QStringList& tokens) override {
     Q_ASSERT(!tokens.isEmpty());
+    QString appName = tokens[0];
+
+    CommandLineParser::Option hOption = CommandLineParser::helpOption();
+    CommandLineParser::Option binaryLogOption(
+        "b", "binary-log",
+        "Write the logs as compact binary segments instead of text.");
+
+    QList<CommandLineParser::Option*> options;
+    options.append(&hOption);
+    options.append(&binaryLogOption);
+
+    CommandLineParser clp;
+    if (clp.parse(tokens, options, false)) {
+      return 1;
+    }
+
+    if (hOption.m_set) {
+      clp.showHelp(this, appName, options, false, false);
+      return 0;
+    }
+
     LogHandler::setLocation("/var/log");
+    LogHandler::setBinaryFormat(binaryLogOption.m_set);
+    LogHandler::setAsynchronous();
 
     return runCommandLineApp([&]() {
       DBusService* dbus = new DBusService(qApp);
@@ -349,14 +349,56 @@ QList<WireguardUtils::PeerStatus> WireguardUtilsLinux::getPeerStatus() {
     status.m_handshake += peer->last_handshake_time.tv_nsec / 1000000;
     status.m_txBytes = peer->tx_bytes;
     status.m_rxBytes = peer->rx_bytes;
-    logger.debug() << "found" << logger.keys(status.m_pubkey) << "handshake"
-                   << peer->last_handshake_time.tv_sec;
+    MZ_LOG(logger, Debug) << "found" << logger.keys(status.m_pubkey)
+                          << "handshake" << peer->last_handshake_time.tv_sec;
     peerList.append(status);
   }
   wg_free_device(device);
   return peerList;
 }
 
+QList<WireguardUtils::PeerStatus> WireguardUtilsLinux::peerStatus(
+    const QStringList& pubkeys) {
+  // Match the peers by their binary key, rather than encoding the key of
+  // every peer of the device.
+  QList<QByteArray> keys;
+  for (const QString& pubkey : pubkeys) {
+    wg_key key;
+    if (wg_key_from_base64(key, qPrintable(pubkey)) != 0) {
+      keys.append(QByteArray());
+      continue;
+    }
+    keys.append(QByteArray(reinterpret_cast<const char*>(key), sizeof(key)));
+  }
+
+  QList<WireguardUtils::PeerStatus> peerList;
+  wg_device* device = nullptr;
+  if (wg_get_device(&device, WG_INTERFACE) != 0) {
+    logger.warning() << "Unable to get stats for" << WG_INTERFACE;
+    return peerList;
+  }
+
+  wg_peer* peer = nullptr;
+  wg_for_each_peer(device, peer) {
+    for (qsizetype i = 0; i < keys.length(); ++i) {
+      const QByteArray& key = keys.at(i);
+      if (key.isEmpty() ||
+          memcmp(peer->public_key, key.constData(), sizeof(wg_key)) != 0) {
+        continue;
+      }
+      PeerStatus status(pubkeys.at(i));
+      status.m_handshake = peer->last_handshake_time.tv_sec * 1000;
+      status.m_handshake += peer->last_handshake_time.tv_nsec / 1000000;
+      status.m_txBytes = peer->tx_bytes;
+      status.m_rxBytes = peer->rx_bytes;
+      peerList.append(status);
+      break;
+    }
+  }
+  wg_free_device(device);
+  return peerList;
+}
+
 bool WireguardUtilsLinux::updateRoutePrefix(const IPAddress& prefix) {
   return rtmSendRoute(RTM_NEWROUTE, prefix, RTN_UNICAST,
                       NLM_F_CREATE | NLM_F_REPLACE);
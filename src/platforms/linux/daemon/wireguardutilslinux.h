@@ -28,6 +28,7 @@ class WireguardUtilsLinux final : public WireguardUtils {
   bool updatePeer(const InterfaceConfig& config) override;
   bool deletePeer(const InterfaceConfig& config) override;
   QList<PeerStatus> getPeerStatus() override;
+  QList<PeerStatus> peerStatus(const QStringList& pubkeys) override;
 
   bool updateRoutePrefix(const IPAddress& prefix) override;
   bool deleteRoutePrefix(const IPAddress& prefix) override;
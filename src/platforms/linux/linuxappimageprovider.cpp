@@ -4,28 +4,100 @@
 
 #include "linuxappimageprovider.h"
 
+#include <sys/time.h>
+
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QDir>
 #include <QDirIterator>
 #include <QIcon>
 #include <QProcessEnvironment>
+#include <QSaveFile>
 #include <QSettings>
+#include <QStandardPaths>
 #include <QString>
 
 #include "leakdetector.h"
+#include "linuxdesktopentrycatalog.h"
 #include "logger.h"
 
 constexpr const char* PIXMAP_FALLBACK_PATH = "/usr/share/pixmaps/";
 constexpr const char* DESKTOP_ICON_LOCATION = "/usr/share/icons/";
 
+constexpr const char* ICON_CACHE_FOLDER = "appicons";
+constexpr const char* ICON_CACHE_SIZE_FILE = "size";
+
+// Enough for a few hundred icons at HiDPI sizes.
+constexpr int ICON_CACHE_MEMORY_BUDGET_KB = 8 * 1024;
+
+// Past this number of files, the least recently used icons are removed from
+// the disk cache.
+constexpr int ICON_CACHE_MAX_DISK_FILES = 2048;
+
 namespace {
 Logger logger("LinuxAppImageProvider");
+
+const QStringList ICON_FILE_SUFFIXES{"png", "svg", "svgz", "xpm"};
+
+// Icon themes in lookup order: the current one, the themes it inherits from,
+// then the fallback theme and hicolor.
+QStringList themeChain() {
+  QStringList chain;
+  QStringList pending{QIcon::themeName()};
+  pending << QIcon::fallbackThemeName() << "hicolor";
+
+  while (!pending.isEmpty()) {
+    QString theme = pending.takeFirst();
+    if (theme.isEmpty() || chain.contains(theme)) {
+      continue;
+    }
+    chain.append(theme);
+
+    QStringList inherits;
+    for (const QString& base : QIcon::themeSearchPaths()) {
+      QString indexFile = QDir(base).filePath(theme + "/index.theme");
+      if (QFileInfo::exists(indexFile)) {
+        QSettings index(indexFile, QSettings::IniFormat);
+        inherits = index.value("Icon Theme/Inherits").toStringList();
+        break;
+      }
+    }
+
+    // Inherited themes come before the fallback ones.
+    for (qsizetype i = 0; i < inherits.length(); ++i) {
+      pending.insert(i, inherits.at(i).trimmed());
+    }
+  }
+
+  return chain;
 }
+}  // namespace
 
 LinuxAppImageProvider::LinuxAppImageProvider(QObject* parent)
     : AppImageProvider(parent, QQuickImageProvider::Image,
                        QQmlImageProviderBase::ForceAsynchronousImageLoading) {
   MZ_COUNT_CTOR(LinuxAppImageProvider);
 
+  // Images are requested from another thread: the catalog must exist first.
+  m_catalog = LinuxDesktopEntryCatalog::instance();
+
+  m_memoryCache.setMaxCost(ICON_CACHE_MEMORY_BUDGET_KB);
+  m_diskCachePath =
+      QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))
+          .filePath(ICON_CACHE_FOLDER);
+
+  QFile sizeFile(QDir(m_diskCachePath).filePath(ICON_CACHE_SIZE_FILE));
+  if (sizeFile.open(QIODevice::ReadOnly)) {
+    QDataStream stream(&sizeFile);
+    stream >> m_lastSize;
+  }
+
+  // Render the icons of the applications in the background, so that they are
+  // ready by the time the list is shown.
+  m_prewarmPool.setMaxThreadCount(1);
+  connect(m_catalog, &LinuxDesktopEntryCatalog::entriesChanged, this,
+          &LinuxAppImageProvider::prewarm);
+
   QStringList searchPaths = QIcon::fallbackSearchPaths();
 
   QProcessEnvironment pe = QProcessEnvironment::systemEnvironment();
@@ -48,6 +120,9 @@ LinuxAppImageProvider::LinuxAppImageProvider(QObject* parent)
 
 LinuxAppImageProvider::~LinuxAppImageProvider() {
   MZ_COUNT_DTOR(LinuxAppImageProvider);
+
+  m_stopping = true;
+  m_prewarmPool.waitForDone();
 }
 
 void LinuxAppImageProvider::addFallbackPaths(const QString& iconDir,
@@ -65,16 +140,225 @@ void LinuxAppImageProvider::addFallbackPaths(const QString& iconDir,
 // from QQuickImageProvider
 QImage LinuxAppImageProvider::requestImage(const QString& id, QSize* size,
                                            const QSize& requestedSize) {
-  QSettings entry(id, QSettings::IniFormat);
-  entry.beginGroup("Desktop Entry");
-  QString name = entry.value("Icon").toString();
-
-  QIcon icon = QIcon::fromTheme(name);
-  QPixmap pixmap = icon.pixmap(requestedSize);
-  size->setHeight(pixmap.height());
-  size->setWidth(pixmap.width());
-  logger.debug() << "Loaded icon" << icon.name() << "size:" << pixmap.width()
-                 << "x" << pixmap.height();
-
-  return pixmap.toImage();
+  rememberSize(requestedSize);
+
+  QImage image = iconImage(id, requestedSize);
+  size->setHeight(image.height());
+  size->setWidth(image.width());
+  return image;
+}
+
+// static
+// Drops the least recently used icons once there are more than maxFiles of
+// them. Icons are touched when they are read, so that their modification
+// time tells when they were last used.
+void LinuxAppImageProvider::evictDiskCache(const QString& path, int maxFiles) {
+  QFileInfoList files =
+      QDir(path).entryInfoList({"*.png"}, QDir::Files, QDir::Time);
+  if (files.length() <= maxFiles) {
+    return;
+  }
+
+  // Go well below the limit, so that the next icons do not evict again.
+  qsizetype keep = maxFiles * 3 / 4;
+  logger.debug() << "Evicting" << files.length() - keep << "cached icons";
+  for (qsizetype i = keep; i < files.length(); ++i) {
+    QFile::remove(files.at(i).filePath());
+  }
+}
+
+QImage LinuxAppImageProvider::iconImage(const QString& id, const QSize& size) {
+  const LinuxDesktopEntry entry = m_catalog->entry(id);
+
+  // The modification time of the desktop file invalidates its icons.
+  QString key = QString("%1|%2|%3|%4x%5|%6")
+                    .arg(id, QIcon::themeName(), entry.m_icon)
+                    .arg(size.width())
+                    .arg(size.height())
+                    .arg(entry.m_mtime);
+
+  // Updating the icon theme changes the icon files, not the desktop file.
+  // Looking them up costs a few stat() calls, but a rendered icon must not
+  // outlive its file, in memory or on disk.
+  key += "|" + iconFileKey(entry.m_icon, size);
+
+  {
+    QMutexLocker lock(&m_cacheMutex);
+    QImage* cached = m_memoryCache.object(key);
+    if (cached) {
+      return *cached;
+    }
+  }
+
+  QMutexLocker renderLock(&m_renderMutex);
+
+  QString fileName =
+      QDir(m_diskCachePath)
+          .filePath(QString::fromLatin1(
+                        QCryptographicHash::hash(key.toUtf8(),
+                                                 QCryptographicHash::Sha1)
+                            .toHex()) +
+                    ".png");
+
+  QImage image(fileName);
+  if (!image.isNull()) {
+    utimes(QFile::encodeName(fileName).constData(), nullptr);
+  } else {
+    QIcon icon = QIcon::fromTheme(entry.m_icon);
+    image = icon.pixmap(size).toImage();
+    logger.debug() << "Rendered icon" << icon.name() << "size:" << image.width()
+                   << "x" << image.height();
+
+    // Missing icons are not cached: they may be installed later on.
+    if (image.isNull()) {
+      return image;
+    }
+
+    QSaveFile file(fileName);
+    if (QDir().mkpath(m_diskCachePath) && file.open(QIODevice::WriteOnly)) {
+      if (!image.save(&file, "PNG") || !file.commit()) {
+        logger.warning() << "Unable to write the icon cache";
+      }
+    }
+  }
+  renderLock.unlock();
+
+  QMutexLocker lock(&m_cacheMutex);
+  m_memoryCache.insert(key, new QImage(image),
+                       qMax<qsizetype>(1, image.sizeInBytes() / 1024));
+  return image;
+}
+
+// The icon files that QIcon may render for an icon name, as a cache key: the
+// one made for the requested size, or else a scalable one, and the latest
+// modification time of them all.
+QString LinuxAppImageProvider::iconFileKey(const QString& iconName,
+                                           const QSize& size) {
+  QStringList candidates;
+  if (QDir::isAbsolutePath(iconName)) {
+    candidates.append(iconName);
+  } else {
+    QMutexLocker lock(&m_iconFilesMutex);
+    if (!m_iconFilesIndexed || m_iconFilesTheme != QIcon::themeName()) {
+      indexIconFiles();
+    }
+    candidates = m_iconFiles.value(iconName);
+  }
+
+  QString sizeDir = QString("%1x%2").arg(size.width()).arg(size.height());
+  QString best;
+  int bestScore = -1;
+  qint64 mtime = 0;
+  for (const QString& path : candidates) {
+    QFileInfo info(path);
+    mtime = qMax(mtime, info.lastModified().toMSecsSinceEpoch());
+
+    QStringList dirs = info.path().split('/');
+    int score = dirs.contains(sizeDir) ? 2 : dirs.contains("scalable") ? 1 : 0;
+    if (score > bestScore) {
+      best = path;
+      bestScore = score;
+    }
+  }
+
+  return QString("%1|%2").arg(best).arg(mtime);
+}
+
+// Must be called with m_iconFilesMutex held.
+void LinuxAppImageProvider::indexIconFiles() {
+  m_iconFiles.clear();
+  m_iconFilesTheme = QIcon::themeName();
+  m_iconFilesIndexed = true;
+
+  // An icon is taken from the first theme that has it, in any of the search
+  // paths. The fallback paths come last.
+  auto merge = [this](const QHash<QString, QStringList>& found) {
+    for (auto it = found.cbegin(); it != found.cend(); ++it) {
+      if (!m_iconFiles.contains(it.key())) {
+        m_iconFiles.insert(it.key(), it.value());
+      }
+    }
+  };
+  auto add = [](QDirIterator& iter, QHash<QString, QStringList>& found) {
+    while (iter.hasNext()) {
+      QFileInfo info(iter.next());
+      if (ICON_FILE_SUFFIXES.contains(info.suffix())) {
+        found[info.completeBaseName()].append(info.filePath());
+      }
+    }
+  };
+
+  for (const QString& theme : themeChain()) {
+    QHash<QString, QStringList> found;
+    for (const QString& base : QIcon::themeSearchPaths()) {
+      QDirIterator iter(QDir(base).filePath(theme), QDir::Files,
+                        QDirIterator::Subdirectories);
+      add(iter, found);
+    }
+    merge(found);
+  }
+
+  QHash<QString, QStringList> found;
+  for (const QString& path : QIcon::fallbackSearchPaths()) {
+    QDirIterator iter(path, QDir::Files);
+    add(iter, found);
+  }
+  merge(found);
+
+  logger.debug() << "Indexed" << m_iconFiles.size() << "icons";
+}
+
+void LinuxAppImageProvider::rememberSize(const QSize& size) {
+  QMutexLocker lock(&m_cacheMutex);
+  if (!size.isValid() || size == m_lastSize) {
+    return;
+  }
+  m_lastSize = size;
+
+  if (!QDir().mkpath(m_diskCachePath)) {
+    return;
+  }
+
+  QSaveFile file(QDir(m_diskCachePath).filePath(ICON_CACHE_SIZE_FILE));
+  if (file.open(QIODevice::WriteOnly)) {
+    QDataStream stream(&file);
+    stream << size;
+    file.commit();
+  }
+}
+
+void LinuxAppImageProvider::prewarm() {
+  QSize size;
+  {
+    QMutexLocker lock(&m_cacheMutex);
+    size = m_lastSize;
+  }
+  // If nothing was ever shown, the size is not known yet: only evict.
+  QStringList ids;
+  if (size.isValid()) {
+    const LinuxDesktopEntries entries = m_catalog->entries();
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+      if (it->m_type == "Application" && !it->m_icon.isEmpty()) {
+        ids.append(it.key());
+      }
+    }
+  }
+
+  m_prewarmPool.clear();
+  m_prewarmPool.start([this, ids, size]() {
+    evictDiskCache(m_diskCachePath, ICON_CACHE_MAX_DISK_FILES);
+
+    {
+      // New applications may have installed new icons.
+      QMutexLocker lock(&m_iconFilesMutex);
+      m_iconFilesIndexed = false;
+    }
+
+    for (const QString& id : ids) {
+      if (m_stopping) {
+        return;
+      }
+      iconImage(id, size);
+    }
+  });
 }
@@ -5,8 +5,17 @@
 #ifndef LINUXAPPIMAGEPROVIDER_H
 #define LINUXAPPIMAGEPROVIDER_H
 
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QThreadPool>
+#include <atomic>
+
 #include "appimageprovider.h"
 
+class LinuxDesktopEntryCatalog;
+
 class LinuxAppImageProvider final : public AppImageProvider {
  public:
   LinuxAppImageProvider(QObject* parent);
@@ -17,6 +26,45 @@ class LinuxAppImageProvider final : public AppImageProvider {
  private:
   static void addFallbackPaths(const QString& dataDir,
                                QStringList& fallbackPaths);
+
+  static void evictDiskCache(const QString& path, int maxFiles);
+
+  QImage iconImage(const QString& id, const QSize& size);
+  QString iconFileKey(const QString& iconName, const QSize& size);
+  void indexIconFiles();
+  void rememberSize(const QSize& size);
+  void prewarm();
+
+ private:
+  LinuxDesktopEntryCatalog* m_catalog = nullptr;
+
+  // Rendered icons, by desktop file, size, theme and the icon file that was
+  // found. The memory cache is bounded by its cost in KiB, and backed by PNG
+  // files on disk.
+  QMutex m_cacheMutex;
+  QCache<QString, QImage> m_memoryCache;
+  QString m_diskCachePath;
+
+  // The size of the last request, used to render the icons in advance.
+  QSize m_lastSize;
+
+  // QIcon is not thread safe: the prewarm pool and the QML image loader
+  // take turns to render.
+  QMutex m_renderMutex;
+
+  // Icon files of the current theme and of the themes it inherits from, by
+  // icon name. Dropped when the theme or the desktop entries change.
+  QMutex m_iconFilesMutex;
+  QHash<QString, QStringList> m_iconFiles;
+  QString m_iconFilesTheme;
+  bool m_iconFilesIndexed = false;
+
+  QThreadPool m_prewarmPool;
+  std::atomic<bool> m_stopping{false};
+
+#ifdef UNIT_TEST
+  friend class TestLinuxAppImageProvider;
+#endif
 };
 
 #endif  // LINUXAPPIMAGEPROVIDER_H
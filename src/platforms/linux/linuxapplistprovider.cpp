@@ -4,19 +4,14 @@
 
 #include "linuxapplistprovider.h"
 
-#include <QDir>
-#include <QDirIterator>
-#include <QProcess>
 #include <QProcessEnvironment>
-#include <QSettings>
+#include <QSet>
 #include <QString>
 
 #include "leakdetector.h"
+#include "linuxdesktopentrycatalog.h"
 #include "logger.h"
 
-constexpr const char* DATA_DIRS_FALLBACK = "/usr/local/share/:/usr/share/";
-constexpr const char* CONFIG_DIRS_FALLBACK = "/etc/xdg/autostart/";
-
 namespace {
 Logger logger("LinuxAppListProvider");
 }
@@ -24,90 +19,66 @@ Logger logger("LinuxAppListProvider");
 LinuxAppListProvider::LinuxAppListProvider(QObject* parent)
     : AppListProvider(parent) {
   MZ_COUNT_CTOR(LinuxAppListProvider);
+
+  connect(LinuxDesktopEntryCatalog::instance(),
+          &LinuxDesktopEntryCatalog::entriesChanged, this, [this]() {
+            if (m_listRequested) {
+              m_listRequested = false;
+              sendApplicationList();
+            }
+          });
 }
 
 LinuxAppListProvider::~LinuxAppListProvider() {
   MZ_COUNT_DTOR(LinuxAppListProvider);
 }
 
-void LinuxAppListProvider::fetchEntries(const QString& dataDir,
-                                        QMap<QString, QString>& map,
-                                        const QSet<QString>& desktopEnv) {
-  logger.debug() << "Fetch Application list from" << dataDir;
-
-  QDirIterator iter(dataDir, QStringList() << "*.desktop", QDir::Files,
-                    QDirIterator::Subdirectories);
-  while (iter.hasNext()) {
-    QFileInfo fileinfo(iter.next());
-    QSettings entry(fileinfo.filePath(), QSettings::IniFormat);
-    entry.beginGroup("Desktop Entry");
-
-    /* Filter out everything except visible applications. */
-    if (entry.value("Type").toString() != "Application") {
-      continue;
-    }
-    if (entry.value("NoDisplay", QVariant(false)).toBool()) {
-      continue;
-    }
-    if (entry.value("Hidden", QVariant(false)).toBool()) {
-      continue;
-    }
-    if (entry.contains("NotShowIn")) {
-      QStringList items =
-          entry.value("NotShowIn").toString().trimmed().split(":");
-      if (desktopEnv.intersects(QSet<QString>(items.begin(), items.end()))) {
-        continue;
-      }
-    }
-    if (entry.contains("OnlyShowIn")) {
-      QStringList items =
-          entry.value("OnlyShowIn").toString().trimmed().split(":");
-      if (!desktopEnv.intersects(QSet<QString>(items.begin(), items.end()))) {
-        continue;
-      }
-    }
+void LinuxAppListProvider::getApplicationList() {
+  logger.debug() << "Fetch Application list from Linux desktop";
 
-    map[fileinfo.absoluteFilePath()] = entry.value("Name").toString();
+  if (!LinuxDesktopEntryCatalog::instance()->isReady()) {
+    m_listRequested = true;
+    return;
   }
+
+  sendApplicationList();
 }
 
-void LinuxAppListProvider::getApplicationList() {
-  logger.debug() << "Fetch Application list from Linux desktop";
+void LinuxAppListProvider::sendApplicationList() {
   QMap<QString, QString> out;
 
   QProcessEnvironment pe = QProcessEnvironment::systemEnvironment();
-  QSet<QString> env;
+  QSet<QString> desktopEnv;
   if (pe.contains("XDG_CURRENT_DESKTOP")) {
     const QStringList parts = pe.value("XDG_CURRENT_DESKTOP").split(":");
-    env += QSet<QString>(parts.begin(), parts.end());
-  }
-
-  QString dataDirs = pe.value("XDG_DATA_DIRS", DATA_DIRS_FALLBACK);
-  for (const QString& part : dataDirs.split(":")) {
-    fetchEntries(part.trimmed() + "/applications", out, env);
-  }
-
-  if (pe.contains("XDG_DATA_HOME")) {
-    fetchEntries(pe.value("XDG_DATA_HOME") + "/applications", out, env);
-  } else if (pe.contains("HOME")) {
-    fetchEntries(pe.value("HOME") + "/.local/share/applications", out, env);
+    desktopEnv += QSet<QString>(parts.begin(), parts.end());
   }
 
-  QMap<QString, QString> autostart;
-  QString configDirs = pe.value("XDG_CONFIG_DIRS", CONFIG_DIRS_FALLBACK);
-  for (const QString& part : configDirs.split(":")) {
-    fetchEntries(part.trimmed() + "/autostart", autostart, env);
-  }
+  const LinuxDesktopEntries entries =
+      LinuxDesktopEntryCatalog::instance()->entries();
+  for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+    const LinuxDesktopEntry& entry = it.value();
 
-  if (pe.contains("XDG_CONFIG_HOME")) {
-    fetchEntries(pe.value("XDG_CONFIG_HOME") + "/autostart", autostart, env);
-  } else if (pe.contains("HOME")) {
-    fetchEntries(pe.value("HOME") + "/.config/autostart", autostart, env);
-  }
+    /* Filter out everything except visible applications. */
+    if (entry.m_type != "Application") {
+      continue;
+    }
+    if (entry.m_noDisplay || entry.m_hidden) {
+      continue;
+    }
+    if (!entry.m_notShowIn.isEmpty() &&
+        desktopEnv.intersects(QSet<QString>(entry.m_notShowIn.begin(),
+                                            entry.m_notShowIn.end()))) {
+      continue;
+    }
+    if (!entry.m_onlyShowIn.isEmpty() &&
+        !desktopEnv.intersects(QSet<QString>(entry.m_onlyShowIn.begin(),
+                                             entry.m_onlyShowIn.end()))) {
+      continue;
+    }
 
-  for (auto itPathName = autostart.constKeyValueBegin();
-       itPathName != autostart.constKeyValueEnd(); ++itPathName) {
-    out[itPathName->first] = itPathName->second + " (autostart)";
+    out[it.key()] =
+        entry.m_autostart ? entry.m_name + " (autostart)" : entry.m_name;
   }
 
   emit newAppList(out);
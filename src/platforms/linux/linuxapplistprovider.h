@@ -8,7 +8,6 @@
 #include <applistprovider.h>
 
 #include <QObject>
-#include <QProcess>
 
 class LinuxAppListProvider final : public AppListProvider {
   Q_OBJECT
@@ -18,8 +17,11 @@ class LinuxAppListProvider final : public AppListProvider {
   void getApplicationList() override;
 
  private:
-  void fetchEntries(const QString& dataDir, QMap<QString, QString>& map,
-                    const QSet<QString>& desktopEnv);
+  void sendApplicationList();
+
+ private:
+  // The list was requested before the catalog was ready.
+  bool m_listRequested = false;
 };
 
 #endif  // LINUXAPPLISTPROVIDER_H
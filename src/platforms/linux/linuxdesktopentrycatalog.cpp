@@ -0,0 +1,224 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "linuxdesktopentrycatalog.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QProcessEnvironment>
+#include <QStandardPaths>
+
+#include "leakdetector.h"
+#include "linuxdesktopentrycatalogworker.h"
+#include "logger.h"
+
+constexpr const char* DATA_DIRS_FALLBACK = "/usr/local/share/:/usr/share/";
+constexpr const char* CONFIG_DIRS_FALLBACK = "/etc/xdg/autostart/";
+
+constexpr const char* DESKTOP_ENTRY_CACHE_FILE = "desktopentries.cache";
+
+namespace {
+Logger logger("LinuxDesktopEntryCatalog");
+
+LinuxDesktopEntryCatalog* s_instance = nullptr;
+}  // namespace
+
+// static
+LinuxDesktopEntryCatalog* LinuxDesktopEntryCatalog::instance() {
+  if (!s_instance) {
+    Q_ASSERT(QThread::currentThread() == qApp->thread());
+    s_instance = new LinuxDesktopEntryCatalog(qApp);
+  }
+  return s_instance;
+}
+
+LinuxDesktopEntryCatalog::LinuxDesktopEntryCatalog(QObject* parent)
+    : QObject(parent) {
+  MZ_COUNT_CTOR(LinuxDesktopEntryCatalog);
+
+  QProcessEnvironment pe = QProcessEnvironment::systemEnvironment();
+
+  QStringList appDirs;
+  QString dataDirs = pe.value("XDG_DATA_DIRS", DATA_DIRS_FALLBACK);
+  for (const QString& part : dataDirs.split(":")) {
+    appDirs.append(part.trimmed() + "/applications");
+  }
+  if (pe.contains("XDG_DATA_HOME")) {
+    appDirs.append(pe.value("XDG_DATA_HOME") + "/applications");
+  } else if (pe.contains("HOME")) {
+    appDirs.append(pe.value("HOME") + "/.local/share/applications");
+  }
+
+  QStringList autostartDirs;
+  QString configDirs = pe.value("XDG_CONFIG_DIRS", CONFIG_DIRS_FALLBACK);
+  for (const QString& part : configDirs.split(":")) {
+    autostartDirs.append(part.trimmed() + "/autostart");
+  }
+  if (pe.contains("XDG_CONFIG_HOME")) {
+    autostartDirs.append(pe.value("XDG_CONFIG_HOME") + "/autostart");
+  } else if (pe.contains("HOME")) {
+    autostartDirs.append(pe.value("HOME") + "/.config/autostart");
+  }
+
+  QString cacheFile =
+      QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))
+          .filePath(DESKTOP_ENTRY_CACHE_FILE);
+
+  m_worker = new LinuxDesktopEntryCatalogWorker(this, &m_thread);
+  connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+  m_thread.start(QThread::LowPriority);
+
+  QMetaObject::invokeMethod(
+      m_worker,
+      [worker = m_worker, appDirs, autostartDirs, cacheFile]() {
+        worker->initialize(appDirs, autostartDirs, cacheFile);
+      },
+      Qt::QueuedConnection);
+}
+
+LinuxDesktopEntryCatalog::~LinuxDesktopEntryCatalog() {
+  MZ_COUNT_DTOR(LinuxDesktopEntryCatalog);
+
+  m_thread.quit();
+  m_thread.wait();
+
+  s_instance = nullptr;
+}
+
+bool LinuxDesktopEntryCatalog::isReady() const {
+  QMutexLocker lock(&m_mutex);
+  return m_ready;
+}
+
+LinuxDesktopEntries LinuxDesktopEntryCatalog::entries() const {
+  QMutexLocker lock(&m_mutex);
+  return m_entries;
+}
+
+LinuxDesktopEntry LinuxDesktopEntryCatalog::entry(const QString& path) const {
+  {
+    QMutexLocker lock(&m_mutex);
+    auto it = m_entries.constFind(path);
+    if (it != m_entries.cend()) {
+      return it.value();
+    }
+  }
+
+  LinuxDesktopEntry entry;
+  parse(path, entry);
+  return entry;
+}
+
+void LinuxDesktopEntryCatalog::setEntries(const LinuxDesktopEntries& entries) {
+  logger.debug() << "Desktop entries:" << entries.size();
+
+  {
+    QMutexLocker lock(&m_mutex);
+    m_entries = entries;
+    m_ready = true;
+  }
+
+  emit entriesChanged();
+}
+
+// static
+bool LinuxDesktopEntryCatalog::parse(const QString& path,
+                                     LinuxDesktopEntry& entry) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  bool inGroup = false;
+  for (const QByteArray& rawLine : file.readAll().split('\n')) {
+    QByteArray line = rawLine.trimmed();
+    if (line.isEmpty() || line.startsWith('#')) {
+      continue;
+    }
+
+    if (line.startsWith('[')) {
+      // The main group comes first: nothing else is needed.
+      if (inGroup) {
+        break;
+      }
+      inGroup = line == "[Desktop Entry]";
+      continue;
+    }
+
+    qsizetype separator = line.indexOf('=');
+    if (!inGroup || separator <= 0) {
+      continue;
+    }
+
+    // Localized keys, such as Name[de], never match.
+    QByteArray key = line.left(separator).trimmed();
+    QString value =
+        unescape(QString::fromUtf8(line.mid(separator + 1).trimmed()));
+
+    if (key == "Type") {
+      entry.m_type = value;
+    } else if (key == "Name") {
+      entry.m_name = value;
+    } else if (key == "Icon") {
+      entry.m_icon = value;
+    } else if (key == "NoDisplay") {
+      entry.m_noDisplay = value == "true";
+    } else if (key == "Hidden") {
+      entry.m_hidden = value == "true";
+    } else if (key == "OnlyShowIn") {
+      entry.m_onlyShowIn = splitList(value);
+    } else if (key == "NotShowIn") {
+      entry.m_notShowIn = splitList(value);
+    }
+  }
+
+  return true;
+}
+
+// static
+// Expand the escape sequences of the desktop entry specification.
+QString LinuxDesktopEntryCatalog::unescape(const QString& value) {
+  if (!value.contains('\\')) {
+    return value;
+  }
+
+  QString result;
+  result.reserve(value.length());
+  for (qsizetype i = 0; i < value.length(); i++) {
+    QChar c = value.at(i);
+    if (c != '\\' || i + 1 >= value.length()) {
+      result.append(c);
+      continue;
+    }
+
+    switch (value.at(++i).unicode()) {
+      case 's':
+        result.append(' ');
+        break;
+      case 'n':
+        result.append('\n');
+        break;
+      case 't':
+        result.append('\t');
+        break;
+      case 'r':
+        result.append('\r');
+        break;
+      default:
+        result.append(value.at(i));
+        break;
+    }
+  }
+  return result;
+}
+
+// static
+QStringList LinuxDesktopEntryCatalog::splitList(const QString& value) {
+  QStringList items = value.split(';', Qt::SkipEmptyParts);
+  for (QString& item : items) {
+    item = item.trimmed();
+  }
+  return items;
+}
@@ -0,0 +1,81 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef LINUXDESKTOPENTRYCATALOG_H
+#define LINUXDESKTOPENTRYCATALOG_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QThread>
+
+class LinuxDesktopEntryCatalogWorker;
+
+// The keys of the main group of a `*.desktop` file that we care about.
+struct LinuxDesktopEntry {
+  QString m_type;
+  QString m_name;
+  QString m_icon;
+  QStringList m_onlyShowIn;
+  QStringList m_notShowIn;
+  bool m_noDisplay = false;
+  bool m_hidden = false;
+
+  // Found in an autostart directory, rather than in the applications menu.
+  bool m_autostart = false;
+  qint64 m_mtime = 0;
+};
+
+using LinuxDesktopEntries = QHash<QString, LinuxDesktopEntry>;
+
+// Catalog of the desktop entries of the applications menu and of autostart,
+// keyed by absolute path. It is built on a worker thread, persisted between
+// runs so that only the files modified in the meantime are parsed again, and
+// kept up to date with inotify.
+class LinuxDesktopEntryCatalog final : public QObject {
+  Q_OBJECT
+  Q_DISABLE_COPY_MOVE(LinuxDesktopEntryCatalog)
+
+ public:
+  // Must be called from the main thread the first time.
+  static LinuxDesktopEntryCatalog* instance();
+
+  bool isReady() const;
+
+  // Thread safe.
+  LinuxDesktopEntries entries() const;
+
+  // Thread safe. Files that are not in the catalog are parsed on the spot.
+  LinuxDesktopEntry entry(const QString& path) const;
+
+  static bool parse(const QString& path, LinuxDesktopEntry& entry);
+
+ signals:
+  void entriesChanged();
+
+ private:
+  explicit LinuxDesktopEntryCatalog(QObject* parent);
+  ~LinuxDesktopEntryCatalog();
+
+  void setEntries(const LinuxDesktopEntries& entries);
+
+  static QString unescape(const QString& value);
+  static QStringList splitList(const QString& value);
+
+  friend class LinuxDesktopEntryCatalogWorker;
+#ifdef UNIT_TEST
+  friend class TestLinuxDesktopEntryCatalog;
+#endif
+
+ private:
+  mutable QMutex m_mutex;
+  LinuxDesktopEntries m_entries;
+  bool m_ready = false;
+
+  LinuxDesktopEntryCatalogWorker* m_worker = nullptr;
+  QThread m_thread;
+};
+
+#endif  // LINUXDESKTOPENTRYCATALOG_H
@@ -0,0 +1,302 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "linuxdesktopentrycatalogworker.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSocketNotifier>
+#include <QThread>
+
+#include "leakdetector.h"
+#include "logger.h"
+
+// Bump this when the format of the cache changes.
+constexpr quint32 DESKTOP_ENTRY_CACHE_VERSION = 1;
+
+constexpr uint32_t DESKTOP_ENTRY_INOTIFY_MASK =
+    IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+    IN_ONLYDIR;
+
+namespace {
+Logger logger("LinuxDesktopEntryCatalogWorker");
+}
+
+LinuxDesktopEntryCatalogWorker::LinuxDesktopEntryCatalogWorker(
+    LinuxDesktopEntryCatalog* catalog, QThread* thread)
+    : m_catalog(catalog) {
+  MZ_COUNT_CTOR(LinuxDesktopEntryCatalogWorker);
+  moveToThread(thread);
+}
+
+LinuxDesktopEntryCatalogWorker::~LinuxDesktopEntryCatalogWorker() {
+  MZ_COUNT_DTOR(LinuxDesktopEntryCatalogWorker);
+
+  delete m_inotifyNotifier;
+  if (m_inotifyFd >= 0) {
+    close(m_inotifyFd);
+  }
+}
+
+void LinuxDesktopEntryCatalogWorker::initialize(
+    const QStringList& appDirs, const QStringList& autostartDirs,
+    const QString& cacheFile) {
+  m_appDirs = appDirs;
+  m_autostartDirs = autostartDirs;
+  m_cacheFile = cacheFile;
+
+  m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_inotifyFd >= 0) {
+    m_inotifyNotifier =
+        new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+    connect(m_inotifyNotifier, &QSocketNotifier::activated, this,
+            &LinuxDesktopEntryCatalogWorker::readEvents);
+  } else {
+    logger.error() << "Failed to create the inotify instance:"
+                   << strerror(errno);
+  }
+
+  // Only the files modified since the previous run are parsed again.
+  scanAll(load());
+  publish();
+  save();
+}
+
+void LinuxDesktopEntryCatalogWorker::scanAll(
+    const LinuxDesktopEntries& previous) {
+  m_entries.clear();
+
+  for (const QString& dir : m_appDirs) {
+    scanDirectory(dir, false, previous);
+  }
+  for (const QString& dir : m_autostartDirs) {
+    scanDirectory(dir, true, previous);
+  }
+}
+
+void LinuxDesktopEntryCatalogWorker::scanDirectory(
+    const QString& dir, bool autostart, const LinuxDesktopEntries& previous) {
+  if (!QFileInfo(dir).isDir()) {
+    return;
+  }
+
+  logger.debug() << "Fetch desktop entries from" << dir;
+  addWatch(dir, autostart);
+
+  QDirIterator iter(dir, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot,
+                    QDirIterator::Subdirectories);
+  while (iter.hasNext()) {
+    iter.next();
+    QFileInfo info = iter.fileInfo();
+    if (info.isDir()) {
+      addWatch(info.filePath(), autostart);
+    } else if (info.fileName().endsWith(".desktop")) {
+      updateFile(info, autostart, previous);
+    }
+  }
+}
+
+void LinuxDesktopEntryCatalogWorker::updateFile(
+    const QFileInfo& info, bool autostart,
+    const LinuxDesktopEntries& previous) {
+  QString path = info.absoluteFilePath();
+  qint64 mtime = info.lastModified().toMSecsSinceEpoch();
+
+  auto cached = previous.constFind(path);
+  if (cached != previous.cend() && cached->m_mtime == mtime &&
+      cached->m_autostart == autostart) {
+    m_entries.insert(path, cached.value());
+    return;
+  }
+
+  LinuxDesktopEntry entry;
+  if (!LinuxDesktopEntryCatalog::parse(path, entry)) {
+    m_entries.remove(path);
+    return;
+  }
+
+  entry.m_autostart = autostart;
+  entry.m_mtime = mtime;
+  m_entries.insert(path, entry);
+}
+
+void LinuxDesktopEntryCatalogWorker::removeDirectory(const QString& dir) {
+  QString prefix = dir + "/";
+  m_entries.removeIf([&prefix](const LinuxDesktopEntries::iterator& it) {
+    return it.key().startsWith(prefix);
+  });
+
+  // A directory moved away keeps its watches, which would report its files
+  // under their former paths. The watches of a deleted one are already gone.
+  for (auto it = m_watches.begin(); it != m_watches.end();) {
+    if (it->m_path != dir && !it->m_path.startsWith(prefix)) {
+      ++it;
+      continue;
+    }
+
+    inotify_rm_watch(m_inotifyFd, it.key());
+    it = m_watches.erase(it);
+  }
+}
+
+void LinuxDesktopEntryCatalogWorker::addWatch(const QString& dir,
+                                              bool autostart) {
+  if (m_inotifyFd < 0) {
+    return;
+  }
+
+  int wd = inotify_add_watch(m_inotifyFd, qPrintable(dir),
+                             DESKTOP_ENTRY_INOTIFY_MASK);
+  if (wd < 0) {
+    logger.warning() << "Failed to watch" << dir << strerror(errno);
+    return;
+  }
+
+  m_watches.insert(wd, Watch{QDir(dir).absolutePath(), autostart});
+}
+
+void LinuxDesktopEntryCatalogWorker::readEvents() {
+  alignas(struct inotify_event) char buffer[4096];
+  bool changed = false;
+
+  while (true) {
+    ssize_t len = read(m_inotifyFd, buffer, sizeof(buffer));
+    if (len <= 0) {
+      if (len < 0 && errno != EAGAIN && errno != EINTR) {
+        logger.error() << "Failed to read inotify events:" << strerror(errno);
+      }
+      break;
+    }
+
+    for (ssize_t offset = 0; offset < len;) {
+      const struct inotify_event* event =
+          reinterpret_cast<const struct inotify_event*>(buffer + offset);
+      offset += sizeof(struct inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        // Some events were lost: check every file again.
+        logger.warning() << "inotify queue overflow";
+        LinuxDesktopEntries previous = m_entries;
+        scanAll(previous);
+        changed = true;
+        continue;
+      }
+
+      if (event->mask & IN_IGNORED) {
+        m_watches.remove(event->wd);
+        continue;
+      }
+
+      auto watch = m_watches.constFind(event->wd);
+      if (watch == m_watches.cend() || event->len == 0) {
+        continue;
+      }
+
+      QString path = watch->m_path + "/" + QString::fromUtf8(event->name);
+      bool autostart = watch->m_autostart;
+
+      if (event->mask & IN_ISDIR) {
+        if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+          scanDirectory(path, autostart, LinuxDesktopEntries());
+        } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+          removeDirectory(path);
+        }
+        changed = true;
+        continue;
+      }
+
+      if (!path.endsWith(".desktop")) {
+        continue;
+      }
+
+      // Files are parsed once they have been written.
+      if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+        updateFile(QFileInfo(path), autostart, LinuxDesktopEntries());
+        changed = true;
+      } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+        changed |= m_entries.remove(path);
+      }
+    }
+  }
+
+  if (changed) {
+    publish();
+    save();
+  }
+}
+
+void LinuxDesktopEntryCatalogWorker::publish() {
+  LinuxDesktopEntryCatalog* catalog = m_catalog;
+  QMetaObject::invokeMethod(
+      catalog,
+      [catalog, entries = m_entries]() { catalog->setEntries(entries); },
+      Qt::QueuedConnection);
+}
+
+LinuxDesktopEntries LinuxDesktopEntryCatalogWorker::load() const {
+  LinuxDesktopEntries entries;
+
+  QFile file(m_cacheFile);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return entries;
+  }
+
+  QDataStream stream(&file);
+  quint32 version = 0;
+  quint32 count = 0;
+  stream >> version >> count;
+  if (version != DESKTOP_ENTRY_CACHE_VERSION) {
+    return entries;
+  }
+
+  for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+    QString path;
+    LinuxDesktopEntry entry;
+    stream >> path >> entry.m_type >> entry.m_name >> entry.m_icon >>
+        entry.m_onlyShowIn >> entry.m_notShowIn >> entry.m_noDisplay >>
+        entry.m_hidden >> entry.m_autostart >> entry.m_mtime;
+    entries.insert(path, entry);
+  }
+
+  if (stream.status() != QDataStream::Ok) {
+    logger.warning() << "Ignoring an invalid desktop entry cache";
+    return LinuxDesktopEntries();
+  }
+
+  return entries;
+}
+
+void LinuxDesktopEntryCatalogWorker::save() const {
+  if (!QDir().mkpath(QFileInfo(m_cacheFile).absolutePath())) {
+    return;
+  }
+
+  QSaveFile file(m_cacheFile);
+  if (!file.open(QIODevice::WriteOnly)) {
+    logger.warning() << "Unable to open the desktop entry cache";
+    return;
+  }
+
+  QDataStream stream(&file);
+  stream << DESKTOP_ENTRY_CACHE_VERSION << quint32(m_entries.size());
+  for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+    const LinuxDesktopEntry& entry = it.value();
+    stream << it.key() << entry.m_type << entry.m_name << entry.m_icon
+           << entry.m_onlyShowIn << entry.m_notShowIn << entry.m_noDisplay
+           << entry.m_hidden << entry.m_autostart << entry.m_mtime;
+  }
+
+  if (stream.status() != QDataStream::Ok || !file.commit()) {
+    logger.warning() << "Unable to write the desktop entry cache";
+  }
+}
@@ -0,0 +1,65 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef LINUXDESKTOPENTRYCATALOGWORKER_H
+#define LINUXDESKTOPENTRYCATALOGWORKER_H
+
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+
+#include "linuxdesktopentrycatalog.h"
+
+class QFileInfo;
+class QSocketNotifier;
+class QThread;
+
+// Scans and watches the desktop entries for LinuxDesktopEntryCatalog. Lives
+// in the catalog's thread.
+class LinuxDesktopEntryCatalogWorker final : public QObject {
+  Q_OBJECT
+  Q_DISABLE_COPY_MOVE(LinuxDesktopEntryCatalogWorker)
+
+ public:
+  LinuxDesktopEntryCatalogWorker(LinuxDesktopEntryCatalog* catalog,
+                                 QThread* thread);
+  ~LinuxDesktopEntryCatalogWorker();
+
+  void initialize(const QStringList& appDirs, const QStringList& autostartDirs,
+                  const QString& cacheFile);
+
+ private:
+  struct Watch {
+    QString m_path;
+    bool m_autostart;
+  };
+
+  void scanAll(const LinuxDesktopEntries& previous);
+  void scanDirectory(const QString& dir, bool autostart,
+                     const LinuxDesktopEntries& previous);
+  void updateFile(const QFileInfo& info, bool autostart,
+                  const LinuxDesktopEntries& previous);
+  void removeDirectory(const QString& dir);
+  void addWatch(const QString& dir, bool autostart);
+  void readEvents();
+
+  void publish();
+  LinuxDesktopEntries load() const;
+  void save() const;
+
+ private:
+  LinuxDesktopEntryCatalog* m_catalog;
+
+  QStringList m_appDirs;
+  QStringList m_autostartDirs;
+  QString m_cacheFile;
+
+  LinuxDesktopEntries m_entries;
+
+  int m_inotifyFd = -1;
+  QSocketNotifier* m_inotifyNotifier = nullptr;
+  QHash<int, Watch> m_watches;
+};
+
+#endif  // LINUXDESKTOPENTRYCATALOGWORKER_H
@@ -21,8 +21,51 @@
 
 namespace {
 Logger logger("LinuxPingSender");
+
+// Maximum number of datagrams handed to the kernel by a single call to
+// sendmmsg() or recvmmsg().
+constexpr const int PING_BATCH_SIZE = 64;
+
+// Echo replies are tiny, this leaves room for the IP header and options.
+constexpr const int PING_RECV_BUFSIZE = 256;
+
+void fillDestination(const QHostAddress& dest, struct sockaddr_in* addr) {
+  memset(addr, 0, sizeof(*addr));
+  addr->sin_family = AF_INET;
+  addr->sin_addr.s_addr = qToBigEndian<quint32>(dest.toIPv4Address());
+}
+
+void fillEchoRequest(quint16 ident, quint16 sequence, struct icmphdr* packet) {
+  memset(packet, 0, sizeof(*packet));
+  packet->type = ICMP_ECHO;
+  packet->un.echo.id = htons(ident);
+  packet->un.echo.sequence = htons(sequence);
+  packet->checksum = PingSender::inetChecksum(packet, sizeof(*packet));
 }
 
+// Scatter buffers to drain several replies with a single recvmmsg().
+struct PingRecvBatch {
+  unsigned char data[PING_BATCH_SIZE][PING_RECV_BUFSIZE];
+  struct iovec iov[PING_BATCH_SIZE];
+  struct mmsghdr msgs[PING_BATCH_SIZE];
+
+  int recv(int socket) {
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < PING_BATCH_SIZE; i++) {
+      iov[i].iov_base = data[i];
+      iov[i].iov_len = PING_RECV_BUFSIZE;
+      msgs[i].msg_hdr.msg_iov = &iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    return recvmmsg(socket, msgs, PING_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+  }
+
+  bool truncated(int index) const {
+    return (msgs[index].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+  }
+};
+}  // namespace
+
 int LinuxPingSender::createSocket() {
   // Try creating an ICMP socket. This would be the ideal choice, but it can
   // fail depending on the kernel config (see: sys.net.ipv4.ping_group_range)
@@ -110,18 +153,11 @@ LinuxPingSender::~LinuxPingSender() {
 }
 
 void LinuxPingSender::sendPing(const QHostAddress& dest, quint16 sequence) {
-  quint32 ipv4dest = dest.toIPv4Address();
   struct sockaddr_in addr;
-  memset(&addr, 0, sizeof(addr));
-  addr.sin_family = AF_INET;
-  addr.sin_addr.s_addr = qToBigEndian<quint32>(ipv4dest);
+  fillDestination(dest, &addr);
 
   struct icmphdr packet;
-  memset(&packet, 0, sizeof(packet));
-  packet.type = ICMP_ECHO;
-  packet.un.echo.id = htons(m_ident);
-  packet.un.echo.sequence = htons(sequence);
-  packet.checksum = inetChecksum(&packet, sizeof(packet));
+  fillEchoRequest(m_ident, sequence, &packet);
 
   int rc = sendto(m_socket, &packet, sizeof(packet), 0, (struct sockaddr*)&addr,
                   sizeof(addr));
@@ -130,38 +166,91 @@ void LinuxPingSender::sendPing(const QHostAddress& dest, quint16 sequence) {
   }
 }
 
+void LinuxPingSender::sendPings(const QList<PingRequest>& requests) {
+  struct sockaddr_in addrs[PING_BATCH_SIZE];
+  struct icmphdr packets[PING_BATCH_SIZE];
+  struct iovec iov[PING_BATCH_SIZE];
+  struct mmsghdr msgs[PING_BATCH_SIZE];
+
+  qsizetype offset = 0;
+  while (offset < requests.count()) {
+    int count = static_cast<int>(
+        qMin<qsizetype>(requests.count() - offset, PING_BATCH_SIZE));
+
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < count; i++) {
+      const PingRequest& request = requests.at(offset + i);
+      fillDestination(request.destination, &addrs[i]);
+      fillEchoRequest(m_ident, request.sequence, &packets[i]);
+
+      iov[i].iov_base = &packets[i];
+      iov[i].iov_len = sizeof(struct icmphdr);
+      msgs[i].msg_hdr.msg_name = &addrs[i];
+      msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+      msgs[i].msg_hdr.msg_iov = &iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // sendmmsg() returns the number of datagrams sent. A short count means
+    // the datagram at that position failed, so skip over it and carry on.
+    int rc = sendmmsg(m_socket, msgs, count, 0);
+    if (rc < 0) {
+      logger.error() << "failed to send:" << strerror(errno);
+      rc = 0;
+    }
+    offset += rc;
+    if (rc < count) {
+      offset++;
+    }
+  }
+}
+
 void LinuxPingSender::icmpSocketReady() {
-  socklen_t slen = 0;
-  unsigned char data[2048];
-  int rc = recvfrom(m_socket, data, sizeof(data), MSG_DONTWAIT, NULL, &slen);
+  PingRecvBatch batch;
+  int rc = batch.recv(m_socket);
   if (rc <= 0) {
-    logger.error() << "recvfrom failed:" << strerror(errno);
+    logger.error() << "recvmmsg failed:" << strerror(errno);
     return;
   }
 
-  struct icmphdr packet;
-  if (rc >= (int)sizeof(packet)) {
-    memcpy(&packet, data, sizeof(packet));
-    if (packet.type == ICMP_ECHOREPLY) {
-      emit recvPing(htons(packet.un.echo.sequence));
+  for (int i = 0; i < rc; i++) {
+    if (!batch.truncated(i)) {
+      icmpPacketReceived(batch.data[i], batch.msgs[i].msg_len);
     }
   }
 }
 
 void LinuxPingSender::rawSocketReady() {
-  socklen_t slen = 0;
-  unsigned char data[2048];
-  int rc = recvfrom(m_socket, data, sizeof(data), MSG_DONTWAIT, NULL, &slen);
+  PingRecvBatch batch;
+  int rc = batch.recv(m_socket);
   if (rc <= 0) {
-    logger.error() << "recvfrom failed:" << strerror(errno);
+    logger.error() << "recvmmsg failed:" << strerror(errno);
     return;
   }
 
+  for (int i = 0; i < rc; i++) {
+    if (!batch.truncated(i)) {
+      rawPacketReceived(batch.data[i], batch.msgs[i].msg_len);
+    }
+  }
+}
+
+void LinuxPingSender::icmpPacketReceived(const unsigned char* data, int rc) {
+  struct icmphdr packet;
+  if (rc >= (int)sizeof(packet)) {
+    memcpy(&packet, data, sizeof(packet));
+    if (packet.type == ICMP_ECHOREPLY) {
+      emit recvPing(htons(packet.un.echo.sequence));
+    }
+  }
+}
+
+void LinuxPingSender::rawPacketReceived(const unsigned char* data, int rc) {
   // Check the IP header
-  const struct iphdr* ip = (struct iphdr*)data;
+  const struct iphdr* ip = (const struct iphdr*)data;
   int iphdrlen = ip->ihl * 4;
   if (rc < iphdrlen || iphdrlen < (int)sizeof(struct iphdr)) {
-    logger.error() << "malformed IP packet:" << strerror(errno);
+    logger.error() << "malformed IP packet";
     return;
   }
 
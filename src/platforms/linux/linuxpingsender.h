@@ -22,9 +22,12 @@ class LinuxPingSender final : public PingSender {
   bool isValid() override { return (m_socket >= 0); };
 
   void sendPing(const QHostAddress& dest, quint16 sequence) override;
+  void sendPings(const QList<PingRequest>& requests) override;
 
  private:
   int createSocket();
+  void icmpPacketReceived(const unsigned char* data, int length);
+  void rawPacketReceived(const unsigned char* data, int length);
 
  private slots:
   void rawSocketReady();
@@ -0,0 +1,121 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "profiler.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include "leakdetector.h"
+#include "logger.h"
+
+// A forgotten session must not grow without limits.
+constexpr qsizetype PROFILER_MAX_EVENTS = 100000;
+
+namespace {
+Logger logger("Profiler");
+
+Profiler* s_instance = nullptr;
+
+const QElapsedTimer& processTimer() {
+  static QElapsedTimer s_timer = []() {
+    QElapsedTimer timer;
+    timer.start();
+    return timer;
+  }();
+  return s_timer;
+}
+
+// Trace viewers want small integers, not native thread handles.
+int currentThreadId() {
+  static std::atomic<int> s_lastThreadId{0};
+  thread_local int s_threadId = ++s_lastThreadId;
+  return s_threadId;
+}
+}  // namespace
+
+std::atomic<bool> Profiler::s_enabled{false};
+
+// static
+Profiler* Profiler::instance() {
+  if (!s_instance) {
+    s_instance = new Profiler();
+  }
+  return s_instance;
+}
+
+Profiler::Profiler() : QObject(qApp) {
+  MZ_COUNT_CTOR(Profiler);
+  processTimer();
+}
+
+Profiler::~Profiler() {
+  MZ_COUNT_DTOR(Profiler);
+  s_enabled = false;
+  s_instance = nullptr;
+}
+
+// static
+qint64 Profiler::timestamp() { return processTimer().nsecsElapsed() / 1000; }
+
+void Profiler::start() {
+  logger.debug() << "Starting a profiling session";
+
+  QMutexLocker lock(&m_mutex);
+  m_events = QJsonArray();
+  m_truncated = false;
+  m_sessionStart = timestamp();
+  s_enabled = true;
+}
+
+QJsonObject Profiler::stop() {
+  logger.debug() << "Stopping the profiling session";
+
+  QMutexLocker lock(&m_mutex);
+  s_enabled = false;
+
+  QJsonObject trace;
+  trace["traceEvents"] = m_events;
+  trace["displayTimeUnit"] = "ms";
+  trace["truncated"] = m_truncated;
+
+  m_events = QJsonArray();
+  return trace;
+}
+
+void Profiler::addEvent(const char* category, const QString& name,
+                        qint64 start, qint64 duration,
+                        const QJsonObject& args) {
+  if (!isEnabled()) {
+    return;
+  }
+
+  QJsonObject event;
+  {
+    QMutexLocker lock(&m_mutex);
+    if (start < m_sessionStart) {
+      duration -= m_sessionStart - start;
+      start = m_sessionStart;
+    }
+
+    event["name"] = name;
+    event["cat"] = category;
+    event["ph"] = "X";
+    event["ts"] = start;
+    event["dur"] = qMax<qint64>(0, duration);
+    event["pid"] = QCoreApplication::applicationPid();
+    event["tid"] = currentThreadId();
+    if (!args.isEmpty()) {
+      event["args"] = args;
+    }
+
+    if (m_events.size() < PROFILER_MAX_EVENTS) {
+      m_events.append(event);
+    } else {
+      m_truncated = true;
+    }
+  }
+
+  emit eventAdded(event);
+}
@@ -0,0 +1,88 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMutex>
+#include <QObject>
+#include <atomic>
+
+#define MZ_PROFILER_CONCAT_(a, b) a##b
+#define MZ_PROFILER_CONCAT(a, b) MZ_PROFILER_CONCAT_(a, b)
+
+// Records the time spent in the enclosing scope. When no profiling session
+// is running, this costs a single relaxed atomic load.
+#define MZ_PROFILE_SCOPE(_category, _name) \
+  Profiler::Scope MZ_PROFILER_CONCAT(profilerScope, __LINE__)(_category, _name)
+
+/**
+ * @brief Collects timing events in the Chrome trace event format
+ *
+ * A session is started and stopped from the inspector. While it runs, every
+ * event is broadcast through eventAdded() and kept, so that the whole trace
+ * can be returned at the end and loaded in chrome://tracing or Perfetto.
+ */
+class Profiler final : public QObject {
+  Q_OBJECT
+  Q_DISABLE_COPY_MOVE(Profiler)
+
+ public:
+  class Scope final {
+    Q_DISABLE_COPY_MOVE(Scope)
+
+   public:
+    Scope(const char* category, const char* name)
+        : m_category(category),
+          m_name(name),
+          m_start(isEnabled() ? timestamp() : -1) {}
+
+    ~Scope() {
+      if (m_start >= 0) {
+        instance()->addEvent(m_category, QString::fromLatin1(m_name), m_start,
+                             timestamp() - m_start);
+      }
+    }
+
+   private:
+    const char* m_category;
+    const char* m_name;
+    const qint64 m_start;
+  };
+
+  static Profiler* instance();
+
+  static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+  // Microseconds since the process started.
+  static qint64 timestamp();
+
+  void start();
+
+  // Stops the session and returns its trace.
+  QJsonObject stop();
+
+  // Adds a complete ("X") event. Events starting before the session are
+  // clipped to its start.
+  void addEvent(const char* category, const QString& name, qint64 start,
+                qint64 duration, const QJsonObject& args = QJsonObject());
+
+ signals:
+  void eventAdded(const QJsonObject& event);
+
+ private:
+  Profiler();
+  ~Profiler();
+
+  static std::atomic<bool> s_enabled;
+
+  QMutex m_mutex;
+  QJsonArray m_events;
+  qint64 m_sessionStart = 0;
+  bool m_truncated = false;
+};
+
+#endif  // PROFILER_H
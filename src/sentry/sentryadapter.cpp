@@ -140,6 +140,9 @@ sentry_value_t SentryAdapter::onCrash(const sentry_ucontext_t* uctx,
   logger.info() << "Sentry ON CRASH";
 #endif
   captureQMLStacktrace("Client Crashed, Current QML Stack:");
+
+  // Don't lose what the asynchronous log writer has not written yet.
+  LogHandler::flushPendingLogs();
   return event;
 }
 
@@ -5,6 +5,7 @@
 #include "serverlatency.h"
 
 #include <QDateTime>
+#include <algorithm>
 
 #include "controller.h"
 #include "feature/feature.h"
@@ -17,8 +18,16 @@
 #include "pingsenderfactory.h"
 #include "tcppingsender.h"
 
+// Maximum number of pings sent in a single burst, and the number of pings we
+// allow to be outstanding when falling back to TCP handshakes.
+constexpr const int SERVER_LATENCY_BURST_SIZE = 32;
 constexpr const int SERVER_LATENCY_MAX_PARALLEL = 8;
 
+// Outstanding pings are tracked in a ring indexed by sequence number. This
+// must be a power of two so that it evenly divides the 16-bit sequence space.
+constexpr const int SERVER_LATENCY_RING_SIZE = 1024;
+static_assert((SERVER_LATENCY_RING_SIZE & (SERVER_LATENCY_RING_SIZE - 1)) == 0);
+
 constexpr const int SERVER_LATENCY_MAX_RETRIES = 2;
 
 // Minimum number of redundant servers we expect at a location.
@@ -30,6 +39,8 @@ Logger logger("ServerLatency");
 using namespace std::chrono_literals;
 constexpr const std::chrono::milliseconds SERVER_LATENCY_TIMEOUT = 5s;
 constexpr const auto SERVER_LATENCY_INITIAL = 1s;
+// Interval between bursts of pings while there are servers left to probe.
+constexpr const auto SERVER_LATENCY_BURST_INTERVAL = 20ms;
 constexpr const auto SERVER_LATENCY_REFRESH = 30min;
 // Delay the progressChanged() signal to rate-limit how often score changes.
 constexpr const auto SERVER_LATENCY_PROGRESS_DELAY = 500ms;
@@ -87,14 +98,17 @@ void ServerLatency::start() {
   }
 
   m_sequence = 0;
+  m_pingRingTail = 0;
   m_wantRefresh = false;
+  m_pingMaxPending = SERVER_LATENCY_RING_SIZE;
   m_pingSender = PingSenderFactory::create(QHostAddress(), this);
   if (!m_pingSender->isValid()) {
     // Fallback to using TCP handshake times for pings if we can't create an
     // ICMP socket on this platform, this probes at the ports used for Wireguard
-    // over TCP.
+    // over TCP. Each of those pings holds a socket open, so keep them few.
     delete m_pingSender;
     m_pingSender = new TcpPingSender(QHostAddress(), 80, this);
+    m_pingMaxPending = SERVER_LATENCY_MAX_PARALLEL;
   }
 
   connect(m_pingSender, SIGNAL(recvPing(quint16)), this,
@@ -104,33 +118,30 @@ void ServerLatency::start() {
 
   // Generate a list of servers to ping. If possible, sort them by geographic
   // distance to try and get data for the quickest servers first.
-  for (const ServerCountry& country : vpn->serverCountryModel()->countries()) {
+  ServerCountryModel* scm = vpn->serverCountryModel();
+  for (const ServerCountry& country : scm->countries()) {
     for (const QString& cityName : country.cities()) {
-      const ServerCity& city =
-          vpn->serverCountryModel()->findCity(country.code(), cityName);
+      const ServerCity& city = scm->findCity(country.code(), cityName);
       double distance =
           vpn->location()->distance(city.latitude(), city.longitude());
       Q_ASSERT(city.initialized());
 
-      // Search for where in the list to insert this city's servers.
-      auto i = m_pingSendQueue.begin();
-      while (i != m_pingSendQueue.end()) {
-        if (i->distance >= distance) {
-          break;
-        }
-        i++;
-      }
-
-      // Insert the servers into the list.
       for (const QString& pubkey : city.servers()) {
-        ServerPingRecord rec = {
-            pubkey, city.country(), city.name(), 0, 0, distance, 0};
-        i = m_pingSendQueue.insert(i, rec);
+        const Server& server = scm->server(pubkey);
+        m_pingTargets.append({pubkey, city.country(), city.name(),
+                              QHostAddress(server.ipv4AddrIn()), distance});
       }
     }
   }
+  std::stable_sort(m_pingTargets.begin(), m_pingTargets.end(),
+                   [](const ServerPingTarget& a, const ServerPingTarget& b) {
+                     return a.distance < b.distance;
+                   });
 
-  m_pingSendTotal = m_pingSendQueue.count();
+  m_pingTargetNext = 0;
+  m_pingPending = 0;
+  m_pingRing.fill(ServerPingRecord{0, 0, 0, 0, false},
+                  SERVER_LATENCY_RING_SIZE);
 
   m_progressDelayTimer.stop();
   emit progressChanged();
@@ -141,50 +152,64 @@ void ServerLatency::start() {
 
 void ServerLatency::maybeSendPings() {
   quint64 now = QDateTime::currentMSecsSinceEpoch();
-  ServerCountryModel* scm = MozillaVPN::instance()->serverCountryModel();
   if (m_pingSender == nullptr) {
     return;
   }
 
-  // Scan through the reply list, looking for timeouts.
-  while (!m_pingReplyList.isEmpty()) {
-    const ServerPingRecord& record = m_pingReplyList.first();
-    if ((record.timestamp + SERVER_LATENCY_TIMEOUT.count()) > now) {
-      break;
-    }
-    logger.debug() << "Server" << logger.keys(record.publicKey) << "timeout"
-                   << record.retries;
-
-    // Send a retry.
-    if (record.retries < SERVER_LATENCY_MAX_RETRIES) {
-      ServerPingRecord retry = record;
-      retry.retries++;
-      retry.sequence = m_sequence++;
-      retry.timestamp = now;
-      m_pingReplyList.append(retry);
-
-      const Server& server = scm->server(retry.publicKey);
-      m_pingSender->sendPing(QHostAddress(server.ipv4AddrIn()), retry.sequence);
+  // Advance the tail of the ring past answered pings, looking for timeouts.
+  // Sequence numbers are handed out in transmit order, so we can stop at the
+  // first pending ping that is still within its timeout.
+  while (m_pingRingTail != m_sequence) {
+    ServerPingRecord& record =
+        m_pingRing[m_pingRingTail & (SERVER_LATENCY_RING_SIZE - 1)];
+    if (record.pending) {
+      if ((record.timestamp + SERVER_LATENCY_TIMEOUT.count()) > now) {
+        break;
+      }
+      logger.debug() << "Server"
+                     << logger.keys(m_pingTargets.at(record.target).publicKey)
+                     << "timeout" << record.retries;
+
+      // Schedule a retry.
+      // TODO: Mark the server unavailable?
+      if (record.retries < SERVER_LATENCY_MAX_RETRIES) {
+        ServerPingRecord retry = record;
+        retry.retries++;
+        m_pingRetryQueue.append(retry);
+      }
+      record.pending = false;
+      m_pingPending--;
     }
-
-    // TODO: Mark the server unavailable?
-    m_pingReplyList.removeFirst();
+    m_pingRingTail++;
   }
 
-  // Generate new pings until we reach our max number of parallel pings.
-  while (m_pingReplyList.count() < SERVER_LATENCY_MAX_PARALLEL) {
-    if (m_pingSendQueue.isEmpty()) {
+  // Generate the next burst of pings, retries first. Stop early if the ring
+  // is full or if we have reached the limit of outstanding pings.
+  QList<PingSender::PingRequest> burst;
+  while (burst.count() < SERVER_LATENCY_BURST_SIZE &&
+         m_pingPending < m_pingMaxPending &&
+         static_cast<quint16>(m_sequence - m_pingRingTail) <
+             SERVER_LATENCY_RING_SIZE) {
+    ServerPingRecord record;
+    if (!m_pingRetryQueue.isEmpty()) {
+      record = m_pingRetryQueue.takeFirst();
+    } else if (m_pingTargetNext < m_pingTargets.count()) {
+      record.target = m_pingTargetNext++;
+      record.retries = 0;
+    } else {
       break;
     }
 
-    ServerPingRecord record = m_pingSendQueue.takeFirst();
     record.sequence = m_sequence++;
     record.timestamp = now;
-    record.retries = 0;
-    m_pingReplyList.append(record);
+    record.pending = true;
+    m_pingRing[record.sequence & (SERVER_LATENCY_RING_SIZE - 1)] = record;
+    m_pingPending++;
 
-    const Server& server = scm->server(record.publicKey);
-    m_pingSender->sendPing(QHostAddress(server.ipv4AddrIn()), record.sequence);
+    burst.append({m_pingTargets.at(record.target).address, record.sequence});
+  }
+  if (!burst.isEmpty()) {
+    m_pingSender->sendPings(burst);
   }
 
   m_lastUpdateTime = QDateTime::currentDateTime();
@@ -192,13 +217,18 @@ void ServerLatency::maybeSendPings() {
     m_progressDelayTimer.start(SERVER_LATENCY_PROGRESS_DELAY);
   }
 
-  if (m_pingReplyList.isEmpty()) {
-    // If the ping reply list is empty, then we have nothing left to do.
+  if (!m_pingRetryQueue.isEmpty() ||
+      (m_pingTargetNext < m_pingTargets.count())) {
+    // There are still servers left to probe, pace out the next burst.
+    m_pingTimeout.start(SERVER_LATENCY_BURST_INTERVAL);
+  } else if (m_pingPending == 0) {
+    // If there are no pings outstanding, then we have nothing left to do.
     stop();
   } else {
-    // Otherwise, the list should be sorted by transmit time. Schedule a timer
-    // to cleanup anything that experiences a timeout.
-    const ServerPingRecord& record = m_pingReplyList.first();
+    // Otherwise, the tail of the ring holds the oldest outstanding ping.
+    // Schedule a timer to cleanup anything that experiences a timeout.
+    const ServerPingRecord& record =
+        m_pingRing.at(m_pingRingTail & (SERVER_LATENCY_RING_SIZE - 1));
 
     CheckedInt<int> value(SERVER_LATENCY_TIMEOUT.count());
     value -= static_cast<int>(now - record.timestamp);
@@ -209,15 +239,21 @@ void ServerLatency::maybeSendPings() {
 
 void ServerLatency::stop() {
   m_pingTimeout.stop();
-  m_pingSendQueue.clear();
-  m_pingReplyList.clear();
-  m_pingSendTotal = 0;
+  m_pingTargets.clear();
+  m_pingTargetNext = 0;
+  m_pingRetryQueue.clear();
+  m_pingRing.clear();
+  m_pingPending = 0;
 
   if (m_pingSender) {
     m_pingSender->deleteLater();
     m_pingSender = nullptr;
   }
 
+  // Replies only re-score their own city. The average latency has settled
+  // now: the other cities may have moved across it.
+  refreshScores();
+
   emit progressChanged();
   m_progressDelayTimer.stop();
   if (!m_refreshTimer.isActive()) {
@@ -238,6 +274,11 @@ void ServerLatency::clear() {
   m_latency.clear();
   m_sumLatencyMsec = 0;
 
+  ServerCountryModel* scm = MozillaVPN::instance()->serverCountryModel();
+  for (const ServerCity& city : scm->cities()) {
+    city.updateLatency();
+  }
+
   emit progressChanged();
 }
 
@@ -274,29 +315,42 @@ void ServerLatency::applicationStateChanged() {
 
 void ServerLatency::recvPing(quint16 sequence) {
   qint64 now(QDateTime::currentMSecsSinceEpoch());
+  if (m_pingRing.isEmpty()) {
+    return;
+  }
 
-  for (auto i = m_pingReplyList.begin(); i != m_pingReplyList.end(); i++) {
-    const ServerPingRecord& record = *i;
-    if (record.sequence != sequence) {
-      continue;
-    }
+  ServerPingRecord& record =
+      m_pingRing[sequence & (SERVER_LATENCY_RING_SIZE - 1)];
+  if (!record.pending || (record.sequence != sequence)) {
+    return;
+  }
+  record.pending = false;
+  m_pingPending--;
 
-    ServerCountryModel* scm = MozillaVPN::instance()->serverCountryModel();
+  const ServerPingTarget& target = m_pingTargets.at(record.target);
+  ServerCountryModel* scm = MozillaVPN::instance()->serverCountryModel();
 
-    qint64 latency(now - record.timestamp);
-    if (latency <= std::numeric_limits<uint>::max()) {
-      setLatency(record.publicKey, latency);
+  qint64 latency(now - record.timestamp);
+  if (latency <= std::numeric_limits<uint>::max()) {
+    setLatency(target.publicKey, latency);
 
-      const ServerCity& city =
-          scm->findCity(record.countryCode, record.cityName);
-      if (city.initialized()) {
-        emit city.scoreChanged();
-      }
+    // Only the city that owns this server needs to be re-scored.
+    const ServerCity& city = scm->findCity(target.countryCode, target.cityName);
+    if (city.initialized()) {
+      city.updateLatency();
     }
+  }
+
+  m_lastUpdateTime = QDateTime::currentDateTime();
+  if (!m_progressDelayTimer.isActive()) {
+    m_progressDelayTimer.start(SERVER_LATENCY_PROGRESS_DELAY);
+  }
 
-    m_pingReplyList.erase(i);
+  // Bursts are paced by the timer, but wrap up as soon as the last reply
+  // comes in rather than waiting for the next tick.
+  if ((m_pingPending == 0) && m_pingRetryQueue.isEmpty() &&
+      (m_pingTargetNext >= m_pingTargets.count())) {
     maybeSendPings();
-    return;
   }
 }
 
@@ -318,12 +372,13 @@ void ServerLatency::setLatency(const QString& pubkey, qint64 msec) {
 }
 
 double ServerLatency::progress() const {
-  if ((m_pingSender == nullptr) || (m_pingSendTotal == 0)) {
+  if ((m_pingSender == nullptr) || m_pingTargets.isEmpty()) {
     return 1.0;  // Operation is complete.
   }
 
-  double remaining = m_pingReplyList.count() + m_pingSendQueue.count();
-  return 1.0 - (remaining / m_pingSendTotal);
+  double remaining = m_pingPending + m_pingRetryQueue.count() +
+                     (m_pingTargets.count() - m_pingTargetNext);
+  return 1.0 - (remaining / m_pingTargets.count());
 }
 
 void ServerLatency::setCooldown(const QString& publicKey, qint64 timeout) {
@@ -333,13 +388,30 @@ void ServerLatency::setCooldown(const QString& publicKey, qint64 timeout) {
     m_cooldown[publicKey] = QDateTime::currentSecsSinceEpoch() + timeout;
   }
 
-  // Emit signals that the connection score may have changed.
+  // The connection score of the city may change now, and once more when the
+  // cooldown expires.
+  refreshServerCity(publicKey);
+  if (timeout > 0) {
+    qint64 msec = qMin<qint64>(timeout * 1000, std::numeric_limits<int>::max());
+    QTimer::singleShot(msec, this,
+                       [this, publicKey]() { refreshServerCity(publicKey); });
+  }
+}
+
+void ServerLatency::refreshServerCity(const QString& pubkey) {
   ServerCountryModel* scm = MozillaVPN::instance()->serverCountryModel();
-  const Server& server = scm->server(publicKey);
+  const Server& server = scm->server(pubkey);
   const ServerCity& city =
       scm->findCity(server.countryCode(), server.cityName());
   if (city.initialized()) {
-    emit city.scoreChanged();
+    city.refreshScore();
+  }
+}
+
+void ServerLatency::refreshScores() {
+  ServerCountryModel* scm = MozillaVPN::instance()->serverCountryModel();
+  for (const ServerCity& city : scm->cities()) {
+    city.refreshScore();
   }
 }
 
@@ -53,6 +53,9 @@ class ServerLatency final : public QObject {
   }
   void setCooldown(const QString& pubkey, qint64 timeout);
 
+  // Re-scores every city, once the average latency may have moved.
+  void refreshScores();
+
   void initialize();
   void start();
   void stop();
@@ -67,22 +70,34 @@ class ServerLatency final : public QObject {
  private:
   void maybeSendPings();
   void clear();
+  void refreshServerCity(const QString& pubkey);
 
  private:
-  struct ServerPingRecord {
+  // A server that we want to measure during this refresh.
+  struct ServerPingTarget {
     QString publicKey;
     QString countryCode;
     QString cityName;
+    QHostAddress address;
+    double distance;
+  };
+  // An outstanding ping, stored in a ring indexed by its sequence number.
+  struct ServerPingRecord {
     quint64 timestamp;
+    qsizetype target;
     quint16 sequence;
-    double distance;
     int retries;
+    bool pending;
   };
   quint16 m_sequence = 0;
+  quint16 m_pingRingTail = 0;
   PingSender* m_pingSender = nullptr;
-  QList<ServerPingRecord> m_pingSendQueue;
-  QList<ServerPingRecord> m_pingReplyList;
-  qsizetype m_pingSendTotal = 0;
+  QList<ServerPingTarget> m_pingTargets;
+  qsizetype m_pingTargetNext = 0;
+  QList<ServerPingRecord> m_pingRetryQueue;
+  QList<ServerPingRecord> m_pingRing;
+  qsizetype m_pingPending = 0;
+  qsizetype m_pingMaxPending = 0;
 
   QHash<QString, qint64> m_latency;
   QHash<QString, qint64> m_cooldown;
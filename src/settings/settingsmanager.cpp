@@ -6,6 +6,7 @@
 
 #include <QApplication>
 #include <QDir>
+#include <QEvent>
 #include <QFile>
 #include <QRegularExpression>
 #include <QSettings>
@@ -21,6 +22,9 @@ Logger logger("SettingsManager");
 
 SettingsManager* s_instance = nullptr;
 
+// How long changes can wait before being written to disk.
+constexpr int SETTINGS_SYNC_DELAY_MSEC = 1000;
+
 #if defined UNIT_TEST
 constexpr const char* SETTINGS_APP_NAME = "vpn_unit";
 #else
@@ -70,6 +74,15 @@ SettingsManager::SettingsManager(QObject* parent)
   logger.debug() << "Initializing SettingsManager";
 
   LogHandler::instance()->registerLogSerializer(this);
+
+  m_syncTimer.setSingleShot(true);
+  m_syncTimer.setInterval(SETTINGS_SYNC_DELAY_MSEC);
+  connect(&m_syncTimer, &QTimer::timeout, this, [this]() {
+    logger.debug() << "Writing the settings";
+    m_settings.sync();
+  });
+
+  m_settings.installEventFilter(this);
 }
 
 SettingsManager::~SettingsManager() {
@@ -93,6 +106,21 @@ SettingsManager::~SettingsManager() {
 
 QString SettingsManager::settingsFileName() { return m_settings.fileName(); }
 
+bool SettingsManager::eventFilter(QObject* watched, QEvent* event) {
+  // QSettings posts an UpdateRequest after the first change, and writes the
+  // whole file when it gets it. Postpone that write instead. QSettings
+  // doesn't post another one until it is synced, and it syncs on destruction
+  // too.
+  if (watched == &m_settings && event->type() == QEvent::UpdateRequest) {
+    if (!m_syncTimer.isActive()) {
+      m_syncTimer.start();
+    }
+    return true;
+  }
+
+  return QObject::eventFilter(watched, event);
+}
+
 void SettingsManager::registerSetting(Setting* setting) {
   Q_ASSERT(setting);
 
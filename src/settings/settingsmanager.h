@@ -6,6 +6,7 @@
 #define settingsmanager_H
 
 #include <QSettings>
+#include <QTimer>
 
 #include "loghandler.h"
 #include "setting.h"
@@ -149,6 +150,8 @@ class SettingsManager final : public QObject, public LogSerializer {
 
   void registerSetting(Setting* setting);
 
+  bool eventFilter(QObject* watched, QEvent* event) override;
+
   static QString getOrganizationName();
 
  private:
@@ -174,6 +177,10 @@ class SettingsManager final : public QObject, public LogSerializer {
   // APIs to access the QSettings underlying storage.
   SettingsConnector m_settingsConnector;
 
+  // Delays the writes of m_settings, so that bursts of changes are written
+  // once.
+  QTimer m_syncTimer;
+
 #ifdef UNIT_TEST
   friend class TestSettingsManager;
   friend class TestSettings;
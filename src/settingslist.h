@@ -51,6 +51,19 @@ SETTING_STRING(addonCustomServerAddress,        // getter
                false                            // sensitive (do not log)
 )
 
+// The SHA256 of the addon files which have already been verified, with the
+// size, mtime and inode they had. Kept in the settings rather than in the
+// addons folder, so that it can't be forged along with the files.
+SETTING_BYTEARRAY(addonHashCache,        // getter
+                  setAddonHashCache,     // setter
+                  removeAddonHashCache,  // remover
+                  hasAddonHashCache,     // has
+                  "addon/hashCache",     // key
+                  "",                    // default value
+                  true,                  // remove when reset
+                  true  // sensitive (do not log) - noisy and limited value
+)
+
 SETTING_BOOL(addonProdKeyInStaging,        // getter
              setAddonProdKeyInStaging,     // setter
              removeAddonProdKeyInStaging,  // remover
@@ -328,6 +341,17 @@ SETTING_BOOL(localhostRequestsOnly,        // Feature ID
              false                         // sensitive (do not log)
 )
 
+// Log statements below this LogLevel are discarded at runtime.
+SETTING_INT(logLevel,        // getter
+            setLogLevel,     // setter
+            removeLogLevel,  // remover
+            hasLogLevel,     // has
+            "logLevel",      // key
+            0,               // default value (LogLevel::Trace)
+            false,           // remove when reset
+            false            // sensitive (do not log)
+)
+
 SETTING_STRINGLIST(missingApps,        // getter
                    setMissingApps,     // setter
                    removeMissingApps,  // remover
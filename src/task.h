@@ -6,6 +6,7 @@
 #define TASK_H
 
 #include <QObject>
+#include <QString>
 
 class Task : public QObject {
   Q_OBJECT
@@ -24,6 +25,12 @@ class Task : public QObject {
     Reschedulable,
   };
 
+  enum Priority {
+    Low,
+    Normal,
+    High,
+  };
+
   explicit Task(const QString& name) : m_name(name) {}
   virtual ~Task() = default;
 
@@ -36,6 +43,16 @@ class Task : public QObject {
   // executed.
   virtual DeletePolicy deletePolicy() const { return Deletable; }
 
+  // Tasks sharing a conflict group run one at a time, by priority and then in
+  // the order they are scheduled. Tasks of different groups can run in parallel. Most tasks are
+  // in the default, unnamed, group: a task should only get its own group if
+  // it doesn't depend on, and isn't depended upon by, anything outside it.
+  virtual QString conflictGroup() const { return QString(); }
+
+  // The next task to start is the one with the highest priority, also within
+  // a conflict group. High priority tasks never wait for a free slot.
+  virtual Priority priority() const { return Normal; }
+
  signals:
   void completed();
 
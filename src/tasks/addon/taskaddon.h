@@ -22,6 +22,9 @@ class TaskAddon final : public Task {
   // downloaded and when they are ready to be loaded.
   DeletePolicy deletePolicy() const override { return Reschedulable; }
 
+  QString conflictGroup() const override { return "addons"; }
+  Priority priority() const override { return Low; }
+
  private:
   const QString m_addonId;
   const QByteArray m_sha256;
@@ -27,6 +27,7 @@ void TaskAddonIndex::run() {
     logger.debug() << "Download manifest URL:" << manifestUrl;
 
     NetworkRequest* request = new NetworkRequest(this, 200);
+    request->enableResponseCache();
     request->get(manifestUrl);
 
     connect(request, &NetworkRequest::requestFailed, this,
@@ -43,6 +44,16 @@ void TaskAddonIndex::run() {
               m_indexData = data;
               maybeComplete();
             });
+
+    // The cached index matches the one on disk, which AddonIndex detects
+    // before validating it again.
+    connect(request, &NetworkRequest::requestNotModified, this,
+            [this](const QByteArray& cachedData) {
+              logger.debug() << "Addon index not modified";
+
+              m_indexData = cachedData;
+              maybeComplete();
+            });
   }
 
   // Index file signature
@@ -52,6 +63,7 @@ void TaskAddonIndex::run() {
     logger.debug() << "Download manifest signature URL:" << manifestSigUrl;
 
     NetworkRequest* request = new NetworkRequest(this, 200);
+    request->enableResponseCache();
     request->get(manifestSigUrl);
 
     connect(request, &NetworkRequest::requestFailed, this,
@@ -68,6 +80,14 @@ void TaskAddonIndex::run() {
               m_indexSignData = data;
               maybeComplete();
             });
+
+    connect(request, &NetworkRequest::requestNotModified, this,
+            [this](const QByteArray& cachedData) {
+              logger.debug() << "Addon index signature not modified";
+
+              m_indexSignData = cachedData;
+              maybeComplete();
+            });
   }
 }
 
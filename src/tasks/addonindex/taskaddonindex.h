@@ -21,6 +21,10 @@ class TaskAddonIndex final : public Task {
   // If we cancel this task, we have to wait 1 hour before the next fetch.
   DeletePolicy deletePolicy() const override { return Reschedulable; }
 
+  // Add-ons are only touched by the add-on tasks, which are not urgent.
+  QString conflictGroup() const override { return "addons"; }
+  Priority priority() const override { return Low; }
+
  private:
   void maybeComplete();
 
@@ -40,6 +40,9 @@ class TaskControllerAction final : public Task {
 
   virtual DeletePolicy deletePolicy() const override { return NonDeletable; }
 
+  // The user is waiting for this one.
+  Priority priority() const override { return High; }
+
  private:
   void stateChanged();
   void checkStatus();
@@ -7,10 +7,12 @@
 #include "leakdetector.h"
 
 TaskFunction::TaskFunction(std::function<void()>&& callback,
-                           Task::DeletePolicy deletePolicy)
+                           Task::DeletePolicy deletePolicy,
+                           const QString& conflictGroup)
     : Task("TaskFunction"),
       m_callback(std::move(callback)),
-      m_deletePolicy(deletePolicy) {
+      m_deletePolicy(deletePolicy),
+      m_conflictGroup(conflictGroup) {
   MZ_COUNT_CTOR(TaskFunction);
 }
 
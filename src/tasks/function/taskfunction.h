@@ -14,16 +14,19 @@ class TaskFunction final : public Task {
   Q_DISABLE_COPY_MOVE(TaskFunction)
 
  public:
-  TaskFunction(std::function<void()>&& callback, DeletePolicy = Deletable);
+  TaskFunction(std::function<void()>&& callback, DeletePolicy = Deletable,
+               const QString& conflictGroup = QString());
   ~TaskFunction();
 
   void run() override;
 
   DeletePolicy deletePolicy() const override { return m_deletePolicy; }
+  QString conflictGroup() const override { return m_conflictGroup; }
 
  private:
   std::function<void()> m_callback;
   DeletePolicy m_deletePolicy = Deletable;
+  QString m_conflictGroup;
 };
 
 #endif  // TASKFUNCTION_H
@@ -84,3 +84,27 @@ Task::DeletePolicy TaskGroup::deletePolicy() const {
 
   return NonDeletable;
 }
+
+QString TaskGroup::conflictGroup() const {
+  // The group can only leave the default conflict group if all of its tasks
+  // agree on another one.
+  if (m_tasks.isEmpty()) {
+    return QString();
+  }
+
+  QString group = m_tasks.first()->conflictGroup();
+  for (Task* task : m_tasks) {
+    if (task->conflictGroup() != group) {
+      return QString();
+    }
+  }
+  return group;
+}
+
+Task::Priority TaskGroup::priority() const {
+  Priority priority = Low;
+  for (Task* task : m_tasks) {
+    priority = qMax(priority, task->priority());
+  }
+  return priority;
+}
@@ -21,6 +21,8 @@ class TaskGroup final : public Task {
 
   void cancel() override;
   DeletePolicy deletePolicy() const override;
+  QString conflictGroup() const override;
+  Priority priority() const override;
 
  private:
   void maybeComplete();
@@ -8,6 +8,7 @@
 #include "errorhandler.h"
 #include "leakdetector.h"
 #include "logger.h"
+#include "models/servercountrymodel.h"
 #include "mozillavpn.h"
 #include "networkrequest.h"
 
@@ -26,6 +27,7 @@ TaskServers::~TaskServers() { MZ_COUNT_DTOR(TaskServers); }
 void TaskServers::run() {
   NetworkRequest* request = new NetworkRequest(this, 200);
   request->auth();
+  request->enableResponseCache();
   request->get(Constants::apiUrl(Constants::Servers));
 
   connect(request, &NetworkRequest::requestFailed, this,
@@ -41,4 +43,16 @@ void TaskServers::run() {
             MozillaVPN::instance()->serversFetched(data);
             emit completed();
           });
+
+  connect(request, &NetworkRequest::requestNotModified, this,
+          [this](const QByteArray& cachedData) {
+            MozillaVPN* vpn = MozillaVPN::instance();
+            // The list is parsed again only if the model has lost it.
+            if (vpn->serverCountryModel()->initialized()) {
+              logger.debug() << "Servers not modified";
+            } else {
+              vpn->serversFetched(cachedData);
+            }
+            emit completed();
+          });
 }
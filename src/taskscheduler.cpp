@@ -5,10 +5,14 @@
 #include "taskscheduler.h"
 
 #include <QCoreApplication>
+#include <QJsonObject>
+#include <QSet>
 #include <QTimer>
+#include <algorithm>
 
 #include "leakdetector.h"
 #include "logger.h"
+#include "profiler.h"
 #include "task.h"
 
 namespace {
@@ -16,6 +20,12 @@ Logger logger("TaskScheduler");
 TaskScheduler* s_taskScheduler = nullptr;
 }  // namespace
 
+// How many tasks can run at the same time, high priority tasks excluded.
+constexpr qsizetype MAX_RUNNING_TASKS = 4;
+
+// static
+TaskScheduler* TaskScheduler::instance() { return maybeCreate(); }
+
 // static
 void TaskScheduler::scheduleTask(Task* task) {
   Q_ASSERT(task);
@@ -55,7 +65,22 @@ TaskScheduler* TaskScheduler::maybeCreate() {
 void TaskScheduler::stop() { maybeCreate()->m_stopped = true; }
 
 // static
-QList<Task*> TaskScheduler::tasks() { return maybeCreate()->m_tasks; }
+QList<Task*> TaskScheduler::tasks() {
+  QList<Task*> list;
+  for (const Entry& entry : maybeCreate()->m_tasks) {
+    list.append(entry.m_task);
+  }
+  return list;
+}
+
+// static
+QList<Task*> TaskScheduler::runningTasks() {
+  QList<Task*> list;
+  for (const Entry& entry : maybeCreate()->m_runningTasks) {
+    list.append(entry.m_task);
+  }
+  return list;
+}
 
 // static
 void TaskScheduler::reset() { delete s_taskScheduler; }
@@ -67,21 +92,29 @@ TaskScheduler::TaskScheduler(QObject* parent) : QObject(parent) {
 
 TaskScheduler::~TaskScheduler() {
   MZ_COUNT_DTOR(TaskScheduler);
-  qDeleteAll(s_taskScheduler->m_tasks);
+  for (const Entry& entry : m_tasks) {
+    delete entry.m_task;
+  }
+  for (const Entry& entry : m_runningTasks) {
+    delete entry.m_task;
+  }
   s_taskScheduler = nullptr;
 }
 
 void TaskScheduler::scheduleTaskInternal(Task* task) {
-  m_tasks.append(task);
+  Entry entry;
+  entry.m_task = task;
+  entry.m_conflictGroup = task->conflictGroup();
+  entry.m_priority = task->priority();
+  entry.m_timer.start();
+  m_tasks.append(entry);
+
   maybeRunTask();
 }
 
 void TaskScheduler::maybeRunTask() {
-  logger.debug() << "Tasks: " << m_tasks.size();
-
-  if (m_running_task || m_tasks.empty()) {
-    return;
-  }
+  logger.debug() << "Tasks: " << m_tasks.size()
+                 << "running:" << m_runningTasks.size();
 
 #ifdef UNIT_TEST
   if (m_stopped) {
@@ -89,30 +122,90 @@ void TaskScheduler::maybeRunTask() {
   }
 #endif
 
-  m_running_task = m_tasks.takeFirst();
-  Q_ASSERT(m_running_task);
+  // A task can complete, and start the next ones, from its run() method.
+  // So, the next task is looked up again after each run.
+  for (qsizetype index = nextTask(); index >= 0; index = nextTask()) {
+    Entry entry = m_tasks.takeAt(index);
+    entry.m_waitMsec = entry.m_timer.restart();
+    m_runningTasks.append(entry);
+
+    Task* task = entry.m_task;
+    QObject::connect(task, &Task::completed, this,
+                     [this, task]() { completeTask(task); });
+
+    task->run();
+  }
+}
+
+// Returns the index of the next task to run, or -1. A task can run only if
+// no other task of its conflict group is running. Among those, the one with
+// the highest priority wins, and the oldest one on a tie: so, a high priority
+// task overtakes the tasks queued before it in the same group.
+qsizetype TaskScheduler::nextTask() const {
+  QSet<QString> busyGroups;
+  for (const Entry& entry : m_runningTasks) {
+    busyGroups.insert(entry.m_conflictGroup);
+  }
+
+  const bool full = m_runningTasks.size() >= MAX_RUNNING_TASKS;
+
+  qsizetype next = -1;
+  for (qsizetype i = 0; i < m_tasks.size(); ++i) {
+    const Entry& entry = m_tasks.at(i);
+    if (busyGroups.contains(entry.m_conflictGroup)) {
+      continue;
+    }
 
-  QObject::connect(m_running_task, &Task::completed, this,
-                   &TaskScheduler::taskCompleted);
+    if (full && entry.m_priority < Task::High) {
+      continue;
+    }
+
+    if (next < 0 || entry.m_priority > m_tasks.at(next).m_priority) {
+      next = i;
+    }
+  }
 
-  m_running_task->run();
+  return next;
 }
 
-void TaskScheduler::taskCompleted() {
-  Q_ASSERT(m_running_task);
+void TaskScheduler::completeTask(Task* task) {
+  auto it = std::find_if(
+      m_runningTasks.begin(), m_runningTasks.end(),
+      [task](const Entry& entry) { return entry.m_task == task; });
+  if (it == m_runningTasks.end()) {
+    return;
+  }
+
+  const QString name = task->name();
+  const qint64 waitMsec = it->m_waitMsec;
+  const qint64 runMsec = it->m_timer.elapsed();
+
+  if (Profiler::isEnabled()) {
+    const qint64 runUsec = it->m_timer.nsecsElapsed() / 1000;
+
+    QJsonObject args;
+    args["waitMsec"] = waitMsec;
+    Profiler::instance()->addEvent("tasks", name,
+                                   Profiler::timestamp() - runUsec, runUsec,
+                                   args);
+  }
+
+  m_runningTasks.erase(it);
+
+  logger.debug() << "Task completed:" << name << "- waited" << waitMsec
+                 << "ms, ran" << runMsec << "ms";
+  task->deleteLater();
+  task->disconnect();
 
-  logger.debug() << "Task completed:" << m_running_task->name();
-  m_running_task->deleteLater();
-  m_running_task->disconnect();
-  m_running_task = nullptr;
+  emit taskCompleted(name, waitMsec, runMsec);
 
   maybeRunTask();
 }
 
 void TaskScheduler::deleteTasksInternal(bool forced) {
-  QMutableListIterator<Task*> i(m_tasks);
+  QMutableListIterator<Entry> i(m_tasks);
   while (i.hasNext()) {
-    Task* task = i.next();
+    Task* task = i.next().m_task;
 
     if (forced) {
       task->deleteLater();
@@ -138,14 +231,21 @@ void TaskScheduler::deleteTasksInternal(bool forced) {
     }
   }
 
-  if (m_running_task) {
-    if (forced || m_running_task->deletePolicy() == Task::Deletable) {
-      m_running_task->cancel();
-      m_running_task->deleteLater();
-      m_running_task->disconnect();
-      m_running_task = nullptr;
+  QList<Task*> cancelled;
+  QMutableListIterator<Entry> r(m_runningTasks);
+  while (r.hasNext()) {
+    Task* task = r.next().m_task;
+    if (forced || task->deletePolicy() == Task::Deletable) {
+      cancelled.append(task);
+      r.remove();
     }
   }
 
+  for (Task* task : cancelled) {
+    task->cancel();
+    task->deleteLater();
+    task->disconnect();
+  }
+
   maybeRunTask();
 }
@@ -5,7 +5,10 @@
 #ifndef TASKSCHEDULER_H
 #define TASKSCHEDULER_H
 
+#include <QElapsedTimer>
+#include <QList>
 #include <QObject>
+#include <QString>
 
 class Task;
 
@@ -13,6 +16,8 @@ class TaskScheduler final : public QObject {
   Q_OBJECT
 
  public:
+  static TaskScheduler* instance();
+
   static void scheduleTask(Task* task);
   static void deleteTasks();
   static void forceDeleteTasks();
@@ -24,25 +29,41 @@ class TaskScheduler final : public QObject {
 #ifdef UNIT_TEST
   static void stop();
   static QList<Task*> tasks();
+  static QList<Task*> runningTasks();
   static void reset();
 #endif
 
+ signals:
+  // For profiling: how long a task waited in the queue, and how long it ran.
+  void taskCompleted(const QString& name, qint64 waitMsec, qint64 runMsec);
+
  private:
   explicit TaskScheduler(QObject* parent);
   ~TaskScheduler();
 
   static TaskScheduler* maybeCreate();
 
+  struct Entry {
+    Task* m_task;
+    QString m_conflictGroup;
+    int m_priority;
+    // Started when the task is queued, then restarted when it runs.
+    QElapsedTimer m_timer;
+    qint64 m_waitMsec = 0;
+  };
+
   void scheduleTaskInternal(Task* task);
   void deleteTasksInternal(bool forced);
 
   void maybeRunTask();
+  qsizetype nextTask() const;
 
-  void taskCompleted();
+  void completeTask(Task* task);
 
  private:
-  Task* m_running_task = nullptr;
-  QList<Task*> m_tasks;
+  // Queued tasks, in the order they were scheduled.
+  QList<Entry> m_tasks;
+  QList<Entry> m_runningTasks;
 
 #ifdef UNIT_TEST
   bool m_stopped = false;
@@ -49,6 +49,9 @@ constexpr const char* BALROG_MACOS_BUILD_TARGET = "Darwin_x86";
 constexpr const char* BALROG_CERT_SUBJECT_CN =
     "aus.content-signature.mozilla.org";
 
+// How many times an interrupted download is resumed before giving up.
+constexpr int BALROG_MAX_DOWNLOAD_RESUMES = 5;
+
 namespace {
 Logger logger("Balrog");
 
@@ -296,62 +299,27 @@ bool Balrog::processData(Task* task, const QByteArray& data) {
     return false;
   }
 
-  QString hashString = obj.value("hashValue").toString();
-  QByteArray hashValue = QByteArray::fromHex(hashString.toUtf8());
-  if (hashValue.isEmpty()) {
-    logger.error() << "No hashValue item";
+  if (hashFunction != "sha512") {
+    logger.error() << "Invalid hash function";
     return false;
   }
 
-  NetworkRequest* request = new NetworkRequest(task);
-  request->get(url);
-
-  // No timeout for this request.
-  request->disableTimeout();
-
-  connect(
-      request, &NetworkRequest::requestFailed, this,
-      [this, request](QNetworkReply::NetworkError error, const QByteArray&) {
-        logger.error() << "Request failed" << error;
-        propagateError(request, error);
-        deleteLater();
-      });
-
-  connect(request, &NetworkRequest::requestCompleted, this,
-          [this, hashValue, hashFunction, url](const QByteArray& data) {
-            logger.debug() << "Request completed";
-
-            if (!computeHash(url, data, hashValue, hashFunction)) {
-              logger.error() << "Ignore failure.";
-              deleteLater();
-            }
-          });
-
-  return true;
-}
-
-bool Balrog::computeHash(const QString& url, const QByteArray& data,
-                         const QByteArray& expect, const QString& algorithm) {
-  logger.debug() << "Compute the hash";
-
-  if (algorithm != "sha512") {
-    logger.error() << "Invalid hash function";
+  QString hashString = obj.value("hashValue").toString();
+  m_expectedHash = QByteArray::fromHex(hashString.toUtf8());
+  if (m_expectedHash.isEmpty()) {
+    logger.error() << "No hashValue item";
     return false;
   }
 
-  QCryptographicHash hash(QCryptographicHash::Sha512);
-  hash.addData(data);
-  if (hash.result() != expect) {
-    logger.error() << "Hash doesn't match";
+  if (!openDownloadFile(url)) {
     return false;
   }
 
-  return saveFileAndInstall(url, data);
+  download(task);
+  return true;
 }
 
-bool Balrog::saveFileAndInstall(const QString& url, const QByteArray& data) {
-  logger.debug() << "Save the file and install it";
-
+bool Balrog::openDownloadFile(const QString& url) {
   int pos = url.lastIndexOf("/");
   if (pos == -1) {
     logger.error() << "The URL seems to be without /.";
@@ -367,24 +335,152 @@ bool Balrog::saveFileAndInstall(const QString& url, const QByteArray& data) {
     return false;
   }
 
-  QDir dir(m_tmpDir.path());
-  QString tmpFile = dir.filePath(fileName);
-
-  QFile file(tmpFile);
-  if (!file.open(QIODevice::ReadWrite)) {
+  m_downloadFile.setFileName(QDir(m_tmpDir.path()).filePath(fileName));
+  if (!m_downloadFile.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
     logger.error() << "Unable to create a file in the temporary folder";
     return false;
   }
 
-  qint64 written = file.write(data);
-  if (written != data.length()) {
-    logger.error() << "Unable to write the whole configuration file";
+  m_downloadUrl = url;
+  return true;
+}
+
+void Balrog::download(Task* task) {
+  NetworkRequest* request = new NetworkRequest(task);
+  request->enableStreaming();
+
+  // Continue an interrupted download where it stopped, provided that the
+  // package has not changed in the meantime.
+  qint64 offset = m_downloadFile.size();
+  if (offset > 0) {
+    logger.debug() << "Resume the download at" << offset;
+    QNetworkRequest& internal = request->requestInternal();
+    internal.setRawHeader("Range",
+                          "bytes=" + QByteArray::number(offset) + "-");
+    if (!m_downloadETag.isEmpty()) {
+      internal.setRawHeader("If-Range", m_downloadETag);
+    }
+  }
+
+  request->get(m_downloadUrl);
+  m_downloadRequest = request;
+
+  // No timeout for this request.
+  request->disableTimeout();
+
+  connect(request, &NetworkRequest::requestHeaderReceived, this,
+          [this, task](NetworkRequest* request) {
+            int status = request->statusCode();
+            if (status == 206) {
+              // The range must start where the file ends. Anything else
+              // can't be appended: download the whole package again.
+              qint64 start = request->contentRangeStart();
+              if (start != m_downloadFile.size()) {
+                logger.warning() << "Unexpected range:" << start;
+                restartDownload();
+                m_downloadETag.clear();
+                m_downloadRequest = nullptr;
+                request->abort();
+                download(task);
+              }
+              return;
+            }
+
+            if (status != 200) {
+              return;
+            }
+
+            // A full response: the range was ignored, or the package has
+            // changed. Start over.
+            if (m_downloadFile.size() > 0) {
+              restartDownload();
+            }
+            m_downloadETag = request->rawHeader("ETag");
+          });
+
+  connect(request, &NetworkRequest::requestDataReceived, this,
+          [this, request](const QByteArray& data) {
+            int status = request->statusCode();
+            if (request != m_downloadRequest ||
+                (status != 200 && status != 206)) {
+              return;
+            }
+
+            if (m_downloadFile.write(data) != data.length()) {
+              logger.error() << "Unable to write the package";
+              request->abort();
+              return;
+            }
+            m_downloadHash.addData(data);
+          });
+
+  connect(request, &NetworkRequest::requestFailed, this,
+          [this, task, request](QNetworkReply::NetworkError error,
+                                const QByteArray&) {
+            // Replaced by a download from the start.
+            if (request != m_downloadRequest) {
+              return;
+            }
+
+            logger.error() << "Request failed" << error;
+
+            if (canResumeDownload(request, error)) {
+              ++m_downloadResumes;
+              download(task);
+              return;
+            }
+
+            propagateError(request, error);
+            deleteLater();
+          });
+
+  connect(request, &NetworkRequest::requestCompleted, this,
+          [this, request](const QByteArray&) {
+            if (request != m_downloadRequest) {
+              return;
+            }
+
+            logger.debug() << "Request completed";
+
+            if (!verifyAndInstall()) {
+              logger.error() << "Ignore failure.";
+              deleteLater();
+            }
+          });
+}
+
+void Balrog::restartDownload() {
+  logger.debug() << "Restart the download";
+
+  m_downloadFile.resize(0);
+  m_downloadFile.seek(0);
+  m_downloadHash.reset();
+}
+
+bool Balrog::canResumeDownload(NetworkRequest* request,
+                               QNetworkReply::NetworkError error) const {
+  // Only the connection errors are worth a retry. The others are answers of
+  // the server, and our own aborts.
+  if (request->isAborted() ||
+      error >= QNetworkReply::ProxyConnectionRefusedError) {
+    return false;
+  }
+
+  return m_downloadResumes < BALROG_MAX_DOWNLOAD_RESUMES;
+}
+
+bool Balrog::verifyAndInstall() {
+  logger.debug() << "Verify the hash";
+
+  if (m_downloadHash.result() != m_expectedHash) {
+    logger.error() << "Hash doesn't match";
     return false;
   }
 
-  file.close();
+  QString filePath = m_downloadFile.fileName();
+  m_downloadFile.close();
 
-  return install(tmpFile);
+  return install(filePath);
 }
 
 bool Balrog::install(const QString& filePath) {
@@ -6,6 +6,7 @@
 #define BALROG_H
 
 #include <QCryptographicHash>
+#include <QFile>
 #include <QNetworkReply>
 
 #include "errorhandler.h"
@@ -34,9 +35,12 @@ class Balrog final : public Updater {
   bool validateSignature(const QByteArray& x5uData,
                          const QByteArray& updateData,
                          const QByteArray& signatureBlob);
-  bool computeHash(const QString& url, const QByteArray& data,
-                   const QByteArray& expect, const QString& algorithm);
-  bool saveFileAndInstall(const QString& url, const QByteArray& data);
+  bool openDownloadFile(const QString& url);
+  void download(Task* task);
+  void restartDownload();
+  bool canResumeDownload(NetworkRequest* request,
+                         QNetworkReply::NetworkError error) const;
+  bool verifyAndInstall();
   bool install(const QString& filePath);
   void propagateError(NetworkRequest* request,
                       QNetworkReply::NetworkError error);
@@ -47,6 +51,19 @@ class Balrog final : public Updater {
   static QStringList rootCertHashes();
   TemporaryDir m_tmpDir;
   bool m_downloadAndInstall;
+
+  // The package is written to m_downloadFile and hashed as it arrives, so
+  // that it is never held in memory as a whole.
+  QString m_downloadUrl;
+  QFile m_downloadFile;
+  QCryptographicHash m_downloadHash{QCryptographicHash::Sha512};
+  QByteArray m_expectedHash;
+  QByteArray m_downloadETag;
+  int m_downloadResumes = 0;
+
+  // The request currently writing to m_downloadFile. The others are ignored.
+  NetworkRequest* m_downloadRequest = nullptr;
+
   ErrorHandler::ErrorPropagationPolicy m_errorPropagationPolicy =
       ErrorHandler::DoNotPropagateError;
 };
@@ -4,6 +4,7 @@
 
 #include "webextensionadapter.h"
 
+#include <QCryptographicHash>
 #include <QFileInfo>
 #include <QHostAddress>
 #include <QJsonArray>
@@ -67,12 +68,25 @@ WebExtensionAdapter::WebExtensionAdapter(QObject* parent)
 
   MozillaVPN* vpn = MozillaVPN::instance();
 
-  connect(vpn, &MozillaVPN::stateChanged, this,
+  m_writeStateTimer.setSingleShot(true);
+  m_writeStateTimer.setInterval(0);
+  connect(&m_writeStateTimer, &QTimer::timeout, this,
           &WebExtensionAdapter::writeState);
+
+  connect(vpn, &MozillaVPN::stateChanged, this,
+          &WebExtensionAdapter::scheduleWriteState);
   connect(vpn->controller(), &Controller::stateChanged, this,
-          &WebExtensionAdapter::writeState);
+          &WebExtensionAdapter::scheduleWriteState);
   connect(vpn->connectionHealth(), &ConnectionHealth::stabilityChanged, this,
-          &WebExtensionAdapter::writeState);
+          &WebExtensionAdapter::scheduleWriteState);
+
+  // Every change of the server list, including the sorting after a language
+  // change, resets the model.
+  connect(vpn->serverCountryModel(), &ServerCountryModel::modelReset, this,
+          [this]() {
+            m_serverList = QJsonObject();
+            m_serverListVersion.clear();
+          });
 
   m_commands = QList<RequestType>({
       RequestType{"activate",
@@ -94,13 +108,16 @@ WebExtensionAdapter::WebExtensionAdapter(QObject* parent)
                     return QJsonObject();
                   }},
       RequestType{"servers",
-                  [this](const QJsonObject&) {
-                    QJsonObject servers;
-                    serializeServerCountry(
-                        MozillaVPN::instance()->serverCountryModel(), servers);
+                  [this](const QJsonObject& data) {
+                    maybeSerializeServerList();
 
+                    // The list is skipped if the extension already has this
+                    // version.
                     QJsonObject obj;
-                    obj["servers"] = servers;
+                    obj["version"] = m_serverListVersion;
+                    if (data["version"].toString() != m_serverListVersion) {
+                      obj["servers"] = m_serverList;
+                    }
                     return obj;
                   }},
       RequestType{"focus",
@@ -186,6 +203,12 @@ WebExtensionAdapter::~WebExtensionAdapter() {
   MZ_COUNT_DTOR(WebExtensionAdapter);
 }
 
+void WebExtensionAdapter::scheduleWriteState() {
+  if (!m_writeStateTimer.isActive()) {
+    m_writeStateTimer.start();
+  }
+}
+
 void WebExtensionAdapter::writeState() {
   QJsonObject obj;
   obj["status"] = serializeStatus();
@@ -300,6 +323,21 @@ void WebExtensionAdapter::serializeServerCountry(ServerCountryModel* model,
   obj["countries"] = countries;
 }
 
+void WebExtensionAdapter::maybeSerializeServerList() {
+  if (!m_serverListVersion.isEmpty()) {
+    return;
+  }
+
+  serializeServerCountry(MozillaVPN::instance()->serverCountryModel(),
+                         m_serverList);
+
+  QByteArray json = QJsonDocument(m_serverList).toJson(QJsonDocument::Compact);
+  m_serverListVersion = QString::fromLatin1(
+      QCryptographicHash::hash(json, QCryptographicHash::Sha256)
+          .toHex()
+          .left(16));
+}
+
 QJsonObject WebExtensionAdapter::serializeSettings() {
   auto const settings = SettingsHolder::instance();
   return {{"extensionTelemetryEnabled", settings->extensionTelemetryEnabled()}};
@@ -5,8 +5,10 @@
 #ifndef WEBEXTENSIONADAPTER_H
 #define WEBEXTENSIONADAPTER_H
 
+#include <QJsonObject>
 #include <QList>
 #include <QPropertyObserver>
+#include <QTimer>
 
 #include "webextension/baseadapter.h"
 
@@ -26,14 +28,26 @@ class WebExtensionAdapter : public WebExtension::BaseAdapter {
 
  private:
   void writeState();
+  void scheduleWriteState();
   QJsonObject serializeStatus();
   QJsonObject serializeFeaturelist();
   void serializeServerCountry(ServerCountryModel* model, QJsonObject& obj);
+  void maybeSerializeServerList();
 
   QJsonObject serializeSettings();
   void applySettings(const QJsonObject& data);
 
   QPropertyObserver mProxyStateChanged;
+
+  // Several signals can change the status in the same event loop turn. They
+  // are pushed once.
+  QTimer m_writeStateTimer;
+
+  // The server list is serialized again only when the model is reset. The
+  // version is a digest of the content, so that it stays valid across
+  // restarts.
+  QJsonObject m_serverList;
+  QString m_serverListVersion;
 };
 
 #endif  // WEBEXTENSIONADAPTER_H
@@ -16,6 +16,7 @@ const dotenv = require('dotenv');
 dotenv.config();
 
 const fs = require('fs');
+const path = require('path');
 const {execSync, spawn} = require('child_process');
 const vpn = require('./helper.js');
 const vpnWS = require('./helperWS.js');
@@ -129,7 +130,19 @@ exports.mochaHooks = {
       await vpn.quit();
 
       const content = await fs.readFileSync(fileName);
-      this.currentTest.ctx.vpnSettings = {fileName, content};
+
+      // Large values are stored in side files next to the settings file.
+      const sideFiles = {};
+      const dirName = path.dirname(fileName);
+      const prefix = path.basename(fileName) + '.';
+      for (const name of fs.readdirSync(dirName)) {
+        if (name.startsWith(prefix) && name.endsWith('.blob')) {
+          const sideFileName = path.join(dirName, name);
+          sideFiles[sideFileName] = fs.readFileSync(sideFileName);
+        }
+      }
+
+      this.currentTest.ctx.vpnSettings = {fileName, content, sideFiles};
     }
 
     guardian.overrideEndpoints =
@@ -141,6 +154,10 @@ exports.mochaHooks = {
       fs.writeFileSync(
         this.currentTest.ctx.vpnSettings.fileName,
         this.currentTest.ctx.vpnSettings.content);
+      for (const [sideFileName, sideFileContent] of Object.entries(
+               this.currentTest.ctx.vpnSettings.sideFiles)) {
+        fs.writeFileSync(sideFileName, sideFileContent);
+      }
       await startAndConnect();
     } else {
       if (this.currentTest.ctx.vpnSettings) {
@@ -119,6 +119,23 @@ describe('WebExtension API', function() {
     sock.destroy();
   });
 
+  it('A Webextension can skip an unchanged server list', async () => {
+    const sock = await connectExtension();
+    const messagePipe = getMessageStream(sock);
+
+    let serversPromise = readResponseOfType('servers', messagePipe);
+    sentToClient(makeMessage('servers'), sock);
+    let msg = await serversPromise;
+    assert(msg.version, `A version is sent in msg: ${JSON.stringify(msg)}`);
+    assert(msg.servers.countries.length > 0, 'The server list is sent');
+
+    serversPromise = readResponseOfType('servers', messagePipe);
+    sentToClient(makeMessage('servers', {version: msg.version}), sock);
+    const unchanged = await serversPromise;
+    assert(unchanged.version === msg.version, 'The version is stable');
+    assert(!('servers' in unchanged), 'An unchanged list is not sent again');
+    sock.destroy();
+  });
   it('A Webextension can read settings', async () => {
     const sock = await connectExtension();
     const messagePipe = getMessageStream(sock);
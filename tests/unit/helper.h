@@ -26,6 +26,8 @@ class TestHelper : public QObject {
     enum NetworkStatus {
       Success,
       Failure,
+      // The body is handed back as the cached response.
+      NotModified,
     };
     NetworkStatus m_status;
     QByteArray m_body;
@@ -58,6 +60,9 @@ class TestHelper : public QObject {
 
   static Controller::State controllerState;
 
+  // How many times MozillaVPN::serversFetched() was called.
+  static int serversFetchedCount;
+
   struct SystemNotification {
     NotificationHandler::Message type;
     QString title;
@@ -74,6 +79,11 @@ class TestHelper : public QObject {
     TestHelper::lastSystemNotification = notification;
   }
 
+  // A servers.json payload of countries * cities * servers synthetic
+  // servers. Public keys are "PublicKey-<country>-<city>-<server>", country
+  // codes "x<country>" and city names "City <country>-<city>".
+  static QByteArray serverList(int countries, int cities, int servers);
+
   static QVector<QObject*> testList;
 
   static QObject* findTest(const QString& name);
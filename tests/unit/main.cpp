@@ -3,6 +3,10 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
 
 #include "constants.h"
 #include "glean/mzglean.h"
@@ -10,11 +14,13 @@
 #include "i18nstrings.h"
 #include "leakdetector.h"
 #include "loghandler.h"
+#include "models/servercountrymodel.h"
 #include "networkrequest.h"
 #include "settingsholder.h"
 
 QVector<TestHelper::NetworkConfig> TestHelper::networkConfig;
 Controller::State TestHelper::controllerState = Controller::StateInitializing;
+int TestHelper::serversFetchedCount = 0;
 QVector<QObject*> TestHelper::testList;
 TestHelper::SystemNotification TestHelper::lastSystemNotification;
 
@@ -31,6 +37,54 @@ QObject* TestHelper::findTest(const QString& name) {
 
 TestHelper::TestHelper() { testList.append(this); }
 
+// static
+QByteArray TestHelper::serverList(int countryCount, int cityCount,
+                                  int serverCount) {
+  QJsonArray countries;
+  for (int c = 0; c < countryCount; c++) {
+    QJsonArray cities;
+    for (int i = 0; i < cityCount; i++) {
+      QJsonArray servers;
+      for (int s = 0; s < serverCount; s++) {
+        QString name = QString("%1-%2-%3").arg(c).arg(i).arg(s);
+        QJsonObject server;
+        server.insert("hostname", "wireguard-" + name + ".example.com");
+        server.insert("ipv4_addr_in",
+                      QString("10.%1.%2.%3").arg(c).arg(i).arg(s));
+        server.insert("ipv4_gateway", "10.64.0.1");
+        server.insert("ipv6_addr_in", "fc00:bbbb:bbbb:bb01::" + name);
+        server.insert("ipv6_gateway", "fc00:bbbb:bbbb:bb01::1");
+        server.insert("public_key", "PublicKey-" + name);
+        server.insert("weight", 100);
+        server.insert("port_ranges", QJsonArray{QJsonArray{1, 53},
+                                                QJsonArray{4000, 33433},
+                                                QJsonArray{33565, 51820}});
+        server.insert("multihop_port", 3000 + s);
+        server.insert("socks5_name", "socks5-" + name + ".example.com");
+        servers.append(server);
+      }
+
+      QJsonObject city;
+      city.insert("name", QString("City %1-%2").arg(c).arg(i));
+      city.insert("code", QString("c%1").arg(i));
+      city.insert("latitude", c * 1.5);
+      city.insert("longitude", i * 3.5);
+      city.insert("servers", servers);
+      cities.append(city);
+    }
+
+    QJsonObject country;
+    country.insert("name", QString("Country %1").arg(c));
+    country.insert("code", QString("x%1").arg(c));
+    country.insert("cities", cities);
+    countries.append(country);
+  }
+
+  QJsonObject obj;
+  obj.insert("countries", countries);
+  return QJsonDocument(obj).toJson();
+}
+
 // static
 App* App::instance() {
   static App* app = nullptr;
@@ -53,6 +107,8 @@ bool TestHelper::networkRequestGeneric(NetworkRequest* request) {
     if (nc.m_status == TestHelper::NetworkConfig::Failure) {
       emit request->requestFailed(
           QNetworkReply::NetworkError::HostNotFoundError, "");
+    } else if (nc.m_status == TestHelper::NetworkConfig::NotModified) {
+      emit request->requestNotModified(nc.m_body);
     } else {
       Q_ASSERT(nc.m_status == TestHelper::NetworkConfig::Success);
 
@@ -83,6 +139,10 @@ int main(int argc, char* argv[]) {
 
   QCoreApplication app(argc, argv);
 
+  // Keep the server list snapshots out of the user's data directory.
+  QTemporaryDir snapshotDir;
+  ServerCountryModel::setSnapshotDirectory(snapshotDir.path());
+
   int failures = 0;
 
   NetworkRequest::setRequestHandler(
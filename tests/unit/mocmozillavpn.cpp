@@ -84,7 +84,9 @@ void MozillaVPN::removeDevice(const QString&, const QString&) {}
 
 void MozillaVPN::deviceRemovalCompleted(const QString&) {}
 
-void MozillaVPN::serversFetched(const QByteArray&) {}
+void MozillaVPN::serversFetched(const QByteArray&) {
+  ++TestHelper::serversFetchedCount;
+}
 
 void MozillaVPN::removeDeviceFromPublicKey(const QString&) {}
 
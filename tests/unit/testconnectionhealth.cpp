@@ -4,6 +4,8 @@
 
 #include "testconnectionhealth.h"
 
+#include <cmath>
+
 #include "connectionhealth.h"
 #include "glean/generated/metrics.h"
 #include "glean/mzglean.h"
@@ -57,8 +59,8 @@ void TestConnectionHealth::healthCheckup() {
   connectionHealth.startIdle();
   connectionHealth.m_noSignalTimer.start();
   for (int i = 0; i < connectionHealth.m_pingHelper.m_pingData.size(); i++) {
-    connectionHealth.m_pingHelper.m_pingData[i].timestamp =
-        QDateTime::currentMSecsSinceEpoch() - (60 * 1000);
+    connectionHealth.m_pingHelper.storePing(
+        i, QDateTime::currentMSecsSinceEpoch() - (60 * 1000));
   }
   connectionHealth.healthCheckup();
   QCOMPARE(connectionHealth.m_stability,
@@ -66,8 +68,8 @@ void TestConnectionHealth::healthCheckup() {
 
   // Signal timer is active, recent pings not lost -> Stable
   for (int i = 0; i < connectionHealth.m_pingHelper.m_pingData.size(); i++) {
-    connectionHealth.m_pingHelper.m_pingData[i].timestamp =
-        QDateTime::currentMSecsSinceEpoch();
+    connectionHealth.m_pingHelper.storePing(
+        i, QDateTime::currentMSecsSinceEpoch());
   }
   connectionHealth.healthCheckup();
   QCOMPARE(connectionHealth.m_stability,
@@ -75,19 +77,68 @@ void TestConnectionHealth::healthCheckup() {
 
   // Signal timer is active, recent ping(s) took too long -> Unstable
   connectionHealth.dnsPingReceived(connectionHealth.m_dnsPingSequence);
-  connectionHealth.m_pingHelper.m_pingData[0].latency = INT_MAX;
+  connectionHealth.m_pingHelper.storeLatency(0, INT_MAX);
   connectionHealth.healthCheckup();
   QCOMPARE(connectionHealth.m_stability,
            ConnectionHealth::ConnectionStability::Unstable);
 
   // Signal timer is active, recent ping(s) arrived on time -> Back to Stable
   connectionHealth.dnsPingReceived(connectionHealth.m_dnsPingSequence);
-  connectionHealth.m_pingHelper.m_pingData[0].latency = 0;
+  connectionHealth.m_pingHelper.storeLatency(0, 0);
   connectionHealth.healthCheckup();
   QCOMPARE(connectionHealth.m_stability,
            ConnectionHealth::ConnectionStability::Stable);
 }
 
+void TestConnectionHealth::pingStatistics() {
+  PingHelper pingHelper;
+  const int window = pingHelper.m_pingData.size();
+  const qint64 sent = QDateTime::currentMSecsSinceEpoch() - (60 * 1000);
+
+  QCOMPARE(pingHelper.latency(), 0u);
+  QCOMPARE(pingHelper.stddev(), 0u);
+  QCOMPARE(pingHelper.maximum(), 0u);
+  QCOMPARE(pingHelper.percentile(95), 0u);
+  QCOMPARE(pingHelper.loss(), 0.0);
+
+  // Fill the window: the odd pings are lost.
+  for (int i = 0; i < window; i++) {
+    pingHelper.storePing(i, sent);
+    if (i % 2 == 0) {
+      pingHelper.storeLatency(i, 10 * (i + 1));
+    }
+  }
+
+  // Latencies are 10, 30, ..., 10 * (window - 1).
+  QCOMPARE(pingHelper.latency(), uint(5 * window));
+  QCOMPARE(pingHelper.maximum(), uint(10 * (window - 1)));
+  QCOMPARE(pingHelper.percentile(0), 10u);
+  QCOMPARE(pingHelper.percentile(50), uint(5 * window - 10));
+  QCOMPARE(pingHelper.percentile(100), uint(10 * (window - 1)));
+  QCOMPARE(pingHelper.loss(), 0.5);
+
+  double variance = 0;
+  for (int i = 0; i < window; i += 2) {
+    variance += std::pow(10 * (i + 1) - 5 * window, 2);
+  }
+  QCOMPARE(pingHelper.stddev(), uint(std::sqrt(variance / (window / 2))));
+
+  // Wrap around: the oldest samples leave the statistics.
+  for (int i = window; i < 2 * window; i++) {
+    pingHelper.storePing(i, sent);
+    pingHelper.storeLatency(i, 100);
+  }
+  QCOMPARE(pingHelper.latency(), 100u);
+  QCOMPARE(pingHelper.stddev(), 0u);
+  QCOMPARE(pingHelper.maximum(), 100u);
+  QCOMPARE(pingHelper.percentile(95), 100u);
+  QCOMPARE(pingHelper.loss(), 0.0);
+
+  // Pings still in flight are not lost.
+  pingHelper.storePing(2 * window, QDateTime::currentMSecsSinceEpoch());
+  QCOMPARE(pingHelper.loss(), 0.0);
+}
+
 void TestConnectionHealth::testTelemetry() {
   ConnectionHealth connectionHealth;
 
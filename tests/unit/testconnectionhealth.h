@@ -17,6 +17,7 @@ class TestConnectionHealth final : public TestHelper {
   void dnsPingReceived();
   void healthCheckup();
   void updateDnsPingLatency();
+  void pingStatistics();
   void testTelemetry();
 
   /**
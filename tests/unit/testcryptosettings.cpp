@@ -4,6 +4,9 @@
 
 #include "testcryptosettings.h"
 
+#include <QDir>
+#include <QFileInfo>
+
 #include "platforms/dummy/dummycryptosettings.h"
 
 void TestCryptoSettings::init() {
@@ -228,4 +231,103 @@ void TestCryptoSettings::readFailsWithMetaDataError() {
   QCOMPARE(CryptoSettings::readFile(file, map), false);
 }
 
+void TestCryptoSettings::sideFiles() {
+  DummyCryptoSettings crypto;
+  QString large(100000, 'x');
+
+  QSettings wSettings(m_tempdir->filePath("write.moz"), crypto.format());
+  wSettings.setValue("someString", "Lorem Ipsum");
+  wSettings.setValue("largeString", large);
+  wSettings.sync();
+
+  // The large value lives in its own file.
+  QDir dir(m_tempdir->path());
+  QCOMPARE(dir.entryList({"write.moz.*.blob"}, QDir::Files).length(), 1);
+  QVERIFY(QFileInfo(m_tempdir->filePath("write.moz")).size() < 1000);
+
+  // Side files are found next to the settings file.
+  QFile::copy(m_tempdir->filePath("write.moz"), testFileName());
+  QSettings rSettings(testFileName(), crypto.format());
+  QCOMPARE(rSettings.value("someString"), "Lorem Ipsum");
+  QCOMPARE(rSettings.value("largeString"), large);
+
+  // Side files which are not referenced anymore are removed.
+  wSettings.remove("largeString");
+  wSettings.sync();
+  wSettings.setValue("someString", "Dolor");
+  wSettings.sync();
+  QVERIFY(dir.entryList({"write.moz.*.blob"}, QDir::Files).isEmpty());
+}
+
+void TestCryptoSettings::sideFileUnchanged() {
+  DummyCryptoSettings crypto;
+
+  QSettings wSettings(m_tempdir->filePath("write.moz"), crypto.format());
+  wSettings.setValue("largeString", QString(100000, 'x'));
+  wSettings.sync();
+
+  QDir dir(m_tempdir->path());
+  QStringList blobs = dir.entryList({"write.moz.*.blob"}, QDir::Files);
+  QCOMPARE(blobs.length(), 1);
+  QFile blob(dir.filePath(blobs.first()));
+  QVERIFY(blob.open(QIODevice::ReadOnly));
+  QByteArray content = blob.readAll();
+  blob.close();
+
+  // Side files use random nonces, so a rewrite would change the content.
+  wSettings.setValue("someString", "Lorem Ipsum");
+  wSettings.sync();
+  QCOMPARE(dir.entryList({"write.moz.*.blob"}, QDir::Files), blobs);
+  QVERIFY(blob.open(QIODevice::ReadOnly));
+  QCOMPARE(blob.readAll(), content);
+}
+
+void TestCryptoSettings::sideFileSameValue() {
+  DummyCryptoSettings crypto;
+  QString large(100000, 'x');
+
+  QSettings wSettings(m_tempdir->filePath("write.moz"), crypto.format());
+  wSettings.setValue("firstString", large);
+  wSettings.setValue("secondString", large);
+  wSettings.sync();
+
+  // Each side file is bound to its key, even if the values are the same.
+  QDir dir(m_tempdir->path());
+  QCOMPARE(dir.entryList({"write.moz.*.blob"}, QDir::Files).length(), 2);
+
+  QFile::copy(m_tempdir->filePath("write.moz"), testFileName());
+  QSettings rSettings(testFileName(), crypto.format());
+  QCOMPARE(rSettings.value("firstString"), large);
+  QCOMPARE(rSettings.value("secondString"), large);
+}
+
+void TestCryptoSettings::sideFileTampered() {
+  DummyCryptoSettings crypto;
+
+  QSettings wSettings(m_tempdir->filePath("write.moz"), crypto.format());
+  wSettings.setValue("someString", "Lorem Ipsum");
+  wSettings.setValue("largeString", QString(100000, 'x'));
+  wSettings.sync();
+
+  QDir dir(m_tempdir->path());
+  QStringList blobs = dir.entryList({"write.moz.*.blob"}, QDir::Files);
+  QCOMPARE(blobs.length(), 1);
+
+  // Flip a bit in the ciphertext.
+  QFile blob(dir.filePath(blobs.first()));
+  QVERIFY(blob.open(QIODevice::ReadWrite));
+  QVERIFY(blob.seek(100));
+  char c;
+  QVERIFY(blob.getChar(&c));
+  QVERIFY(blob.seek(100));
+  QVERIFY(blob.putChar(c ^ 0x01));
+  blob.close();
+
+  // Only the large value is lost.
+  QFile::copy(m_tempdir->filePath("write.moz"), testFileName());
+  QSettings rSettings(testFileName(), crypto.format());
+  QCOMPARE(rSettings.value("someString"), "Lorem Ipsum");
+  QVERIFY(!rSettings.contains("largeString"));
+}
+
 static TestCryptoSettings s_testCryptoSettings;
@@ -41,4 +41,10 @@ class TestCryptoSettings final : public TestHelper {
   void writeV1readV2upgrade();
   void writeV2WithMetaData();
   void readFailsWithMetaDataError();
+
+  // Tests for large values stored in side files.
+  void sideFiles();
+  void sideFileUnchanged();
+  void sideFileSameValue();
+  void sideFileTampered();
 };
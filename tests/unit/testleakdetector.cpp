@@ -0,0 +1,106 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "testleakdetector.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "inspector/inspectorhandler.h"
+#include "leakdetector.h"
+#include "settingsholder.h"
+#include "simplenetworkmanager.h"
+
+namespace {
+
+class LeakDetectorCounted final {
+ public:
+  LeakDetectorCounted() { MZ_COUNT_CTOR(LeakDetectorCounted); }
+  ~LeakDetectorCounted() { MZ_COUNT_DTOR(LeakDetectorCounted); }
+
+ private:
+  char m_payload[24] = {};
+};
+
+class TestInspectorHandler final : public InspectorHandler {
+ public:
+  TestInspectorHandler() : InspectorHandler(nullptr) {}
+
+  // Log entries are forwarded too: keep the command replies only.
+  void send(const QByteArray& buffer) override {
+    QJsonObject obj = QJsonDocument::fromJson(buffer).object();
+    if (obj["type"].toString() != "log") {
+      m_replies.append(obj);
+    }
+  }
+
+  QList<QJsonObject> m_replies;
+};
+
+QJsonObject countedEntry(const QJsonObject& counters) {
+  return counters["LeakDetectorCounted"].toObject();
+}
+
+}  // namespace
+
+void TestLeakDetector::counters() {
+  QJsonObject entry = countedEntry(LeakDetector::countersToJson());
+  qint64 alive = entry["alive"].toInteger();
+  qint64 created = entry["created"].toInteger();
+  qint64 aliveBytes = entry["aliveBytes"].toInteger();
+
+  {
+    LeakDetectorCounted first;
+    auto* second = new LeakDetectorCounted();
+
+    entry = countedEntry(LeakDetector::countersToJson());
+    QCOMPARE(entry["alive"].toInteger(), alive + 2);
+    QCOMPARE(entry["created"].toInteger(), created + 2);
+    QCOMPARE(entry["aliveBytes"].toInteger(),
+             aliveBytes + 2 * qint64(sizeof(LeakDetectorCounted)));
+
+    delete second;
+
+    entry = countedEntry(LeakDetector::countersToJson());
+    QCOMPARE(entry["alive"].toInteger(), alive + 1);
+    QCOMPARE(entry["created"].toInteger(), created + 2);
+    QCOMPARE(entry["aliveBytes"].toInteger(),
+             aliveBytes + qint64(sizeof(LeakDetectorCounted)));
+  }
+
+  entry = countedEntry(LeakDetector::countersToJson());
+  QCOMPARE(entry["alive"].toInteger(), alive);
+  QCOMPARE(entry["created"].toInteger(), created + 2);
+  QCOMPARE(entry["aliveBytes"].toInteger(), aliveBytes);
+}
+
+void TestLeakDetector::inspectorCommand() {
+  SettingsHolder settingsHolder;
+  SimpleNetworkManager snm;
+  TestInspectorHandler handler;
+
+  LeakDetectorCounted counted;
+  handler.recv("leak_counters");
+  QCOMPARE(handler.m_replies.length(), 1);
+
+  QJsonObject obj = handler.m_replies.first();
+  QCOMPARE(obj["type"].toString(), "leak_counters");
+  QVERIFY(!obj.contains("error"));
+
+  QJsonObject counters = obj["value"].toObject();
+  QCOMPARE(counters.keys(), LeakDetector::countersToJson().keys());
+
+  QJsonObject entry = countedEntry(counters);
+  QVERIFY(entry["alive"].toInteger() >= 1);
+  QVERIFY(entry["created"].toInteger() >= entry["alive"].toInteger());
+
+  // The handler counts itself too.
+  QVERIFY(counters["InspectorHandler"].toObject()["alive"].toInteger() >= 1);
+
+  handler.recv("leak_counters 42");
+  QCOMPARE(handler.m_replies.length(), 2);
+  QVERIFY(handler.m_replies.last().contains("error"));
+}
+
+static TestLeakDetector s_testLeakDetector;
@@ -4,6 +4,8 @@
 
 #include "testmodels.h"
 
+#include <QDateTime>
+#include <QFile>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -24,6 +26,8 @@
 #include "models/servercountrymodel.h"
 #include "models/serverdata.h"
 #include "models/user.h"
+#include "mozillavpn.h"
+#include "serverlatency.h"
 #include "settingsholder.h"
 
 // ApiError
@@ -1767,6 +1771,158 @@ void TestModels::serverCountryModelPick() {
   }
 }
 
+void TestModels::serverCountryModelBenchmark_data() {
+  QTest::addColumn<QString>("source");
+
+  // The cost of building the DOM alone, as the previous loader did before
+  // walking it.
+  QTest::addRow("QJsonDocument") << "dom";
+  QTest::addRow("ServerCountryModel") << "json";
+  QTest::addRow("ServerCountryModel snapshot write") << "json+write";
+  QTest::addRow("ServerCountryModel snapshot") << "snapshot";
+}
+
+void TestModels::serverCountryModelBenchmark() {
+  QFETCH(QString, source);
+
+  SettingsHolder settingsHolder;
+  Localizer l;
+
+  // About ten times the size of the production server list.
+  const QByteArray json = TestHelper::serverList(50, 10, 10);
+  SettingsHolder::instance()->setServers(json);
+
+  if (source == "dom") {
+    QBENCHMARK { QVERIFY(QJsonDocument::fromJson(json).isObject()); }
+    return;
+  }
+
+  ServerCountryModel m;
+  if (source == "json") {
+    // The parsing alone, without the snapshot that fromJson() schedules.
+    QBENCHMARK { QVERIFY(m.fromJsonInternal(json)); }
+  } else if (source == "json+write") {
+    // A list fetched from the network is parsed, then written as a snapshot
+    // when the model goes away.
+    QBENCHMARK {
+      ServerCountryModel fresh;
+      QVERIFY(fresh.fromJson(json));
+    }
+    QVERIFY(m.fromJson(json));
+  } else {
+    // At startup, the list comes from the snapshot written when the model
+    // that parsed it goes away.
+    {
+      ServerCountryModel writer;
+      QVERIFY(writer.fromJson(json));
+    }
+    QBENCHMARK { QVERIFY(m.fromSettings()); }
+  }
+  QFile::remove(ServerCountryModel::snapshotFileName());
+
+  QCOMPARE(m.countries().length(), 50);
+  QCOMPARE(m.cities().count(), 500);
+
+  const Server& server = m.server("PublicKey-49-9-9");
+  QCOMPARE(server.hostname(), "wireguard-49-9-9.example.com");
+  QCOMPARE(server.countryCode(), "x49");
+  QCOMPARE(server.cityName(), "City 49-9");
+  QCOMPARE(server.multihopPort(), 3009u);
+
+  const ServerCity& city = m.findCity("x49", "City 49-9");
+  QVERIFY(city.initialized());
+  QCOMPARE(city.servers().length(), 10);
+}
+
+void TestModels::serverCountryModelSnapshot() {
+  SettingsHolder settingsHolder;
+  Localizer l;
+
+  const QString fileName = ServerCountryModel::snapshotFileName();
+  QFile::remove(fileName);
+
+  const QByteArray json = TestHelper::serverList(50, 10, 10);
+  SettingsHolder::instance()->setServers(json);
+
+  // The snapshot is written shortly after each successful fromJson(), with
+  // the cooldowns of the servers. Pending writes are flushed when the model
+  // goes away.
+  ServerLatency* serverLatency = MozillaVPN::instance()->serverLatency();
+  serverLatency->setCooldown("PublicKey-1-2-3", 60);
+  QList<QList<QString>> cityOrder;
+  {
+    ServerCountryModel m;
+    QVERIFY(m.fromJson(json));
+    for (const ServerCountry& country : m.countries()) {
+      cityOrder.append(country.cities());
+    }
+  }
+  QVERIFY(QFile::exists(fileName));
+
+  // The snapshot is the only place the cooldown can come back from.
+  serverLatency->setCooldown("PublicKey-1-2-3", 0);
+  {
+    ServerCountryModel m;
+    QVERIFY(m.fromSettings());
+    QVERIFY(m.initialized());
+    QCOMPARE(m.countries().length(), 50);
+    QCOMPARE(m.cities().count(), 500);
+
+    // Sorted as the JSON is.
+    QList<QList<QString>> snapshotCityOrder;
+    for (const ServerCountry& country : m.countries()) {
+      snapshotCityOrder.append(country.cities());
+    }
+    QCOMPARE(snapshotCityOrder, cityOrder);
+
+    const Server& server = m.server("PublicKey-1-2-3");
+    QCOMPARE(server.hostname(), "wireguard-1-2-3.example.com");
+    QCOMPARE(server.countryCode(), "x1");
+    QCOMPARE(server.cityName(), "City 1-2");
+    QCOMPARE(server.multihopPort(), 3003u);
+
+    const ServerCity& city = m.findCity("x1", "City 1-2");
+    QVERIFY(city.initialized());
+    QCOMPARE(city.country(), "x1");
+    QCOMPARE(city.servers().length(), 10);
+
+    QVERIFY(serverLatency->getCooldown("PublicKey-1-2-3") >
+            QDateTime::currentSecsSinceEpoch());
+  }
+
+  // A corrupted snapshot falls back to the JSON, and is replaced.
+  serverLatency->setCooldown("PublicKey-1-2-3", 0);
+  QFile file(fileName);
+  QVERIFY(file.open(QIODevice::ReadWrite));
+  QByteArray corrupted = file.readAll();
+  corrupted[corrupted.length() - 1] = ~corrupted.at(corrupted.length() - 1);
+  QVERIFY(file.seek(0));
+  QCOMPARE(file.write(corrupted), corrupted.length());
+  file.close();
+  {
+    ServerCountryModel m;
+    QVERIFY(m.fromSettings());
+    QCOMPARE(m.cities().count(), 500);
+    QCOMPARE(serverLatency->getCooldown("PublicKey-1-2-3"), 0);
+  }
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  QVERIFY(file.readAll() != corrupted);
+  file.close();
+
+  // A snapshot of another list is ignored.
+  QJsonObject obj;
+  obj.insert("countries", QJsonArray());
+  SettingsHolder::instance()->setServers(QJsonDocument(obj).toJson());
+  {
+    ServerCountryModel m;
+    QVERIFY(m.fromSettings());
+    QCOMPARE(m.rowCount(QModelIndex()), 0);
+    QCOMPARE(m.cities().count(), 0);
+  }
+
+  QFile::remove(fileName);
+}
+
 // ServerData
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
@@ -48,6 +48,9 @@ class TestModels final : public TestHelper {
   void serverCountryModelFromJson_data();
   void serverCountryModelFromJson();
   void serverCountryModelPick();
+  void serverCountryModelBenchmark_data();
+  void serverCountryModelBenchmark();
+  void serverCountryModelSnapshot();
 
   void serverDataBasic();
   void serverDataMigrate();
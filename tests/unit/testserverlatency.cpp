@@ -5,12 +5,15 @@
 #include "testserverlatency.h"
 
 #include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
 #include <QJsonObject>
 
 #include "constants.h"
 #include "feature/feature.h"
 #include "models/location.h"
 #include "models/servercity.h"
+#include "models/servercountrymodel.h"
 #include "serverlatency.h"
 #include "settingsholder.h"
 
@@ -146,4 +149,92 @@ void TestServerLatency::baseCityScore() {
   QCOMPARE(serverLatency.baseCityScore(&city, userCountry), score);
 }
 
+void TestServerLatency::incrementalScore() {
+  SettingsHolder settingsHolder;
+  // A synthetic fleet of 600 servers, spread over 20 countries.
+  ServerCountryModel* scm = MozillaVPN::instance()->serverCountryModel();
+  QVERIFY(scm->fromJson(TestHelper::serverList(20, 5, 6)));
+
+  ServerLatency* serverLatency = MozillaVPN::instance()->serverLatency();
+  const ServerCity& fast = scm->findCity("x0", "City 0-0");
+  const ServerCity& slow = scm->findCity("x0", "City 0-1");
+  QVERIFY(fast.initialized());
+  QVERIFY(slow.initialized());
+
+  QSignalSpy fastSpy(&fast, &ServerCity::scoreChanged);
+  QSignalSpy slowSpy(&slow, &ServerCity::scoreChanged);
+
+  // A new measurement only re-scores the city that owns the server.
+  serverLatency->setLatency("PublicKey-0-0-0", 10);
+  fast.updateLatency();
+  QCOMPARE(fast.latency(), 10);
+  QCOMPARE(fastSpy.count(), 1);
+  QCOMPARE(slowSpy.count(), 0);
+
+  serverLatency->setLatency("PublicKey-0-1-0", 200);
+  slow.updateLatency();
+  QCOMPARE(slow.latency(), 200);
+  QCOMPARE(fastSpy.count(), 1);
+  QCOMPARE(slowSpy.count(), 1);
+
+  // Progress updates don't re-score anything.
+  emit serverLatency->progressChanged();
+  QCOMPARE(fastSpy.count(), 1);
+  QCOMPARE(slowSpy.count(), 1);
+
+  // The average latency has moved above the fast city, so only it changes.
+  serverLatency->refreshScores();
+  QCOMPARE(fastSpy.count(), 2);
+  QCOMPARE(slowSpy.count(), 1);
+
+  // Nothing has changed relative to the average.
+  serverLatency->refreshScores();
+  QCOMPARE(fastSpy.count(), 2);
+  QCOMPARE(slowSpy.count(), 1);
+
+  // Moving to the country of both cities raises the score of the slow one.
+  // The fast one is already excellent.
+  QJsonObject json;
+  json.insert("city", "Somewhere");
+  json.insert("country", "x0");
+  json.insert("subdivision", "");
+  json.insert("ip", "169.254.0.1");
+  QVERIFY(MozillaVPN::instance()->location()->fromJson(
+      QJsonDocument(json).toJson()));
+  QCOMPARE(fastSpy.count(), 2);
+  QCOMPARE(slowSpy.count(), 2);
+
+  // Putting a server on cooldown re-scores its city straight away, and once
+  // more when the cooldown expires.
+  serverLatency->setCooldown("PublicKey-0-1-1", 1);
+  QCOMPARE(slowSpy.count(), 3);
+  serverLatency->refreshScores();
+  QCOMPARE(slowSpy.count(), 3);
+  QTRY_COMPARE_WITH_TIMEOUT(slowSpy.count(), 4, 3000);
+  QVERIFY(serverLatency->getCooldown("PublicKey-0-1-1") <=
+          QDateTime::currentSecsSinceEpoch());
+  QCOMPARE(fastSpy.count(), 2);
+}
+
+void TestServerLatency::refreshBenchmark() {
+  SettingsHolder settingsHolder;
+  settingsHolder.setFeaturesFlippedOn(QStringList{"serverConnectionScore"});
+  TestHelper::controllerState = Controller::StateOff;
+
+  // In unit tests the pings are answered by the dummy ping sender, which
+  // echoes every request right back.
+  ServerCountryModel* scm = MozillaVPN::instance()->serverCountryModel();
+  QVERIFY(scm->fromJson(TestHelper::serverList(20, 5, 6)));
+
+  // A full-fleet refresh should complete within a few seconds.
+  ServerLatency serverLatency;
+  QBENCHMARK {
+    serverLatency.refresh();
+    QVERIFY(serverLatency.isActive());
+    QTRY_VERIFY_WITH_TIMEOUT(!serverLatency.isActive(), 5000);
+  }
+  QCOMPARE(serverLatency.progress(), 1.0);
+  QVERIFY(serverLatency.lastUpdateTime().isValid());
+}
+
 static TestServerLatency s_testServerLatency;
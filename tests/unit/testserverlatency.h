@@ -15,4 +15,7 @@ class TestServerLatency : public TestHelper {
 
   void baseCityScore_data();
   void baseCityScore();
+
+  void incrementalScore();
+  void refreshBenchmark();
 };
@@ -0,0 +1,53 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "testtaskservers.h"
+
+#include "helper.h"
+#include "models/servercountrymodel.h"
+#include "settingsholder.h"
+#include "simplenetworkmanager.h"
+#include "tasks/servers/taskservers.h"
+
+void TestTaskServers::modified() {
+  SettingsHolder settingsHolder;
+  SimpleNetworkManager snm;
+  settingsHolder.setToken("TOKEN!");
+
+  TestHelper::networkConfig.append(TestHelper::NetworkConfig(
+      TestHelper::NetworkConfig::Success, TestHelper::serverList(1, 1, 1)));
+
+  int count = TestHelper::serversFetchedCount;
+  TaskServers* task = new TaskServers(ErrorHandler::DoNotPropagateError);
+  QSignalSpy spy(task, &Task::completed);
+  task->run();
+  QTRY_COMPARE(spy.count(), 1);
+  QCOMPARE(TestHelper::serversFetchedCount, count + 1);
+  delete task;
+}
+
+void TestTaskServers::notModified() {
+  SettingsHolder settingsHolder;
+  SimpleNetworkManager snm;
+  settingsHolder.setToken("TOKEN!");
+
+  ServerCountryModel* scm = MozillaVPN::instance()->serverCountryModel();
+  QVERIFY(scm->fromJson(TestHelper::serverList(1, 1, 1)));
+  QVERIFY(scm->initialized());
+
+  // The server list is still there: the cached copy is not parsed again.
+  TestHelper::networkConfig.append(TestHelper::NetworkConfig(
+      TestHelper::NetworkConfig::NotModified,
+      TestHelper::serverList(1, 1, 1)));
+
+  int count = TestHelper::serversFetchedCount;
+  TaskServers* task = new TaskServers(ErrorHandler::DoNotPropagateError);
+  QSignalSpy spy(task, &Task::completed);
+  task->run();
+  QTRY_COMPARE(spy.count(), 1);
+  QCOMPARE(TestHelper::serversFetchedCount, count);
+  delete task;
+}
+
+static TestTaskServers s_testTaskServers;
@@ -0,0 +1,125 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "testaddondirectory.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "addons/manager/addondirectory.h"
+#include "settingsholder.h"
+
+namespace {
+QByteArray sha256(const QByteArray& data) {
+  return QCryptographicHash::hash(data, QCryptographicHash::Sha256);
+}
+}  // namespace
+
+void TestAddonDirectory::init() {
+  m_settingsHolder = new SettingsHolder();
+
+  AddonDirectory ad;
+  AddonDirectory::reset();
+}
+
+void TestAddonDirectory::cleanup() { delete m_settingsHolder; }
+
+void TestAddonDirectory::verifyFiles() {
+  QVERIFY(AddonDirectory::writeToFile("a.rcc", "hello"));
+  QVERIFY(AddonDirectory::writeToFile("b.rcc", "world"));
+
+  QHash<QString, QByteArray> hashes;
+  hashes.insert("a.rcc", sha256("hello"));
+  hashes.insert("b.rcc", sha256("hello"));
+  hashes.insert("c.rcc", sha256("missing"));
+
+  QCOMPARE(AddonDirectory::verifyFiles(hashes), QSet<QString>{"a.rcc"});
+
+  // Same result when the hashes come from the cache.
+  QCOMPARE(AddonDirectory::verifyFiles(hashes), QSet<QString>{"a.rcc"});
+
+  QJsonObject obj =
+      QJsonDocument::fromJson(m_settingsHolder->addonHashCache()).object();
+  QVERIFY(obj.contains("a.rcc"));
+  QVERIFY(!obj.contains("b.rcc"));
+  QVERIFY(!obj.contains("c.rcc"));
+
+  // A file changed on disk is hashed again.
+  QDir dir;
+  QVERIFY(AddonDirectory::getDirectory(&dir));
+  QVERIFY(AddonDirectory::writeToFile("a.rcc", "HELLO"));
+  QFile file(dir.filePath("a.rcc"));
+  QVERIFY(file.open(QIODevice::ReadWrite));
+  QVERIFY(file.setFileTime(QDateTime::currentDateTime().addSecs(-3600),
+                           QFileDevice::FileModificationTime));
+  file.close();
+
+  QVERIFY(AddonDirectory::verifyFiles(hashes).isEmpty());
+
+  hashes.insert("a.rcc", sha256("HELLO"));
+  QCOMPARE(AddonDirectory::verifyFiles(hashes), QSet<QString>{"a.rcc"});
+}
+
+void TestAddonDirectory::verifyFilesCache() {
+  QVERIFY(AddonDirectory::writeToFile("a.rcc", "hello"));
+
+  // Files stored with a known hash are trusted as long as they don't change,
+  // without being read again. The hashes are kept in the settings, which are
+  // encrypted where the platform allows it.
+  AddonDirectory::storeVerifiedHash("a.rcc", sha256("stored"));
+
+  QHash<QString, QByteArray> hashes;
+  hashes.insert("a.rcc", sha256("stored"));
+  QCOMPARE(AddonDirectory::verifyFiles(hashes), QSet<QString>{"a.rcc"});
+
+  // A different expected hash forces the file to be hashed.
+  hashes.insert("a.rcc", sha256("other"));
+  QVERIFY(AddonDirectory::verifyFiles(hashes).isEmpty());
+
+  hashes.insert("a.rcc", sha256("hello"));
+  QCOMPARE(AddonDirectory::verifyFiles(hashes), QSet<QString>{"a.rcc"});
+
+  // Removed addons are forgotten.
+  AddonDirectory::removeVerifiedHash("a.rcc");
+  QJsonObject obj =
+      QJsonDocument::fromJson(m_settingsHolder->addonHashCache()).object();
+  QVERIFY(!obj.contains("a.rcc"));
+}
+
+void TestAddonDirectory::verifyFilesForged() {
+  QVERIFY(AddonDirectory::writeToFile("a.rcc", "tampered"));
+
+  // A cache dropped in the addons folder, claiming that the file was
+  // verified against the signed hash, is not trusted.
+  QDir dir;
+  QVERIFY(AddonDirectory::getDirectory(&dir));
+  QFileInfo info(dir.filePath("a.rcc"));
+  QJsonObject entry;
+  entry["size"] = info.size();
+  entry["mtime"] = info.lastModified().toMSecsSinceEpoch();
+  entry["sha256"] = QString::fromLatin1(sha256("signed").toHex());
+  QJsonObject forged;
+  forged["a.rcc"] = entry;
+  QVERIFY(AddonDirectory::writeToFile(
+      "hashes.json", QJsonDocument(forged).toJson(QJsonDocument::Compact)));
+
+  QHash<QString, QByteArray> hashes;
+  hashes.insert("a.rcc", sha256("signed"));
+  QVERIFY(AddonDirectory::verifyFiles(hashes).isEmpty());
+
+  // Without the settings, there is no cache at all: every file is hashed.
+  delete m_settingsHolder;
+  m_settingsHolder = nullptr;
+  QVERIFY(AddonDirectory::verifyFiles(hashes).isEmpty());
+  hashes.insert("a.rcc", sha256("tampered"));
+  QCOMPARE(AddonDirectory::verifyFiles(hashes), QSet<QString>{"a.rcc"});
+  m_settingsHolder = new SettingsHolder();
+}
+
+static TestAddonDirectory s_testAddonDirectory;
@@ -0,0 +1,123 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "testapptracker.h"
+
+#include "platforms/linux/daemon/apptracker.h"
+
+void TestAppTracker::isScope_data() {
+  QTest::addColumn<QString>("name");
+  QTest::addColumn<bool>("result");
+
+  QTest::addRow("gnome") << "app-gnome-firefox-1234.scope" << true;
+  QTest::addRow("session") << "session-2.scope" << true;
+  QTest::addRow("autostart")
+      << "app-gnome-nextcloud@autostart.service" << true;
+  QTest::addRow("service") << "dbus.service" << false;
+  QTest::addRow("slice") << "app.slice" << false;
+  QTest::addRow("suffix only") << "firefox.scope.bak" << false;
+  QTest::addRow("empty") << "" << false;
+}
+
+void TestAppTracker::isScope() {
+  QFETCH(QString, name);
+  QFETCH(bool, result);
+  QCOMPARE(AppTracker::isScope(name), result);
+}
+
+void TestAppTracker::unitPath_data() {
+  QTest::addColumn<QString>("unitName");
+  QTest::addColumn<QString>("path");
+
+  QTest::addRow("empty") << "" << "/org/freedesktop/systemd1/unit/_";
+  QTest::addRow("letters") << "foo" << "/org/freedesktop/systemd1/unit/foo";
+  QTest::addRow("dashes and dots")
+      << "app-gnome-firefox-1234.scope"
+      << "/org/freedesktop/systemd1/unit/"
+         "app_2dgnome_2dfirefox_2d1234_2escope";
+  QTest::addRow("leading digit")
+      << "1foo2.scope" << "/org/freedesktop/systemd1/unit/_31foo2_2escope";
+  QTest::addRow("escaped dash")
+      << "app-gnome-gnome\\x2dterminal-42.scope"
+      << "/org/freedesktop/systemd1/unit/"
+         "app_2dgnome_2dgnome_5cx2dterminal_2d42_2escope";
+  QTest::addRow("autostart")
+      << "app-gnome-foo@autostart.service"
+      << "/org/freedesktop/systemd1/unit/"
+         "app_2dgnome_2dfoo_40autostart_2eservice";
+  QTest::addRow("underscore")
+      << "snap.foo_bar.scope"
+      << "/org/freedesktop/systemd1/unit/snap_2efoo_5fbar_2escope";
+  QTest::addRow("utf-8") << QString::fromUtf8("caf\xc3\xa9")
+                         << "/org/freedesktop/systemd1/unit/caf_c3_a9";
+}
+
+void TestAppTracker::unitPath() {
+  QFETCH(QString, unitName);
+  QFETCH(QString, path);
+  QCOMPARE(AppTracker::unitPath(unitName), path);
+}
+
+void TestAppTracker::scopeDesktopFileId_data() {
+  QTest::addColumn<QString>("scopeName");
+  QTest::addColumn<bool>("resolved");
+  QTest::addColumn<QString>("desktopFileId");
+
+  QTest::addRow("gnome") << "app-gnome-firefox-1234.scope" << true
+                         << "firefox.desktop";
+  QTest::addRow("gnome reverse DNS")
+      << "app-gnome-org.gnome.Nautilus-1234.scope" << true
+      << "org.gnome.Nautilus.desktop";
+  QTest::addRow("gnome escaped dash")
+      << "app-gnome-gnome\\x2dsystem\\x2dmonitor-1234.scope" << true
+      << "gnome-system-monitor.desktop";
+  QTest::addRow("gnome escaped uppercase")
+      << "app-gnome-foo\\x2Dbar-1234.scope" << true << "foo-bar.desktop";
+  QTest::addRow("gnome escaped nul")
+      << "app-gnome-foo\\x00bar-1234.scope" << true
+      << "foo\\x00bar.desktop";
+  QTest::addRow("gnome autostart")
+      << "app-gnome-nextcloud-1234@autostart.service" << true
+      << "nextcloud.desktop";
+  QTest::addRow("flatpak")
+      << "app-flatpak-org.mozilla.firefox-1234.scope" << true
+      << "org.mozilla.firefox.desktop";
+  QTest::addRow("flatpak escaped dash")
+      << "app-flatpak-com.example.foo\\x2dbar-1234.scope" << true
+      << "com.example.foo-bar.desktop";
+  QTest::addRow("gnome launched")
+      << "gnome-launched-gnome-system-monitor.desktop-1234.scope" << true
+      << "gnome-system-monitor.desktop";
+  QTest::addRow("gnome launched without pid")
+      << "gnome-launched-.scope" << false << "";
+  QTest::addRow("snap app")
+      << "snap.firefox.firefox-2b6c3c2e-0a43-4c0a-9c2d-4d3a1c3e9f10.scope"
+      << true << "firefox_firefox.desktop";
+  QTest::addRow("snap hook")
+      << "snap.foo.hook.configure-2b6c3c2e-0a43-4c0a-9c2d-4d3a1c3e9f10.scope"
+      << true << "foo_configure.desktop";
+  QTest::addRow("snap service") << "snap.foo.bar.service" << true
+                                << "foo_bar.desktop";
+  QTest::addRow("snap invalid") << "snap.foo.scope" << true << "";
+
+  // Only systemd can tell for the other launchers.
+  QTest::addRow("kde") << "app-org.kde.konsole-1234.scope" << false << "";
+  QTest::addRow("plain app") << "app-firefox-1234.scope" << false << "";
+  QTest::addRow("session") << "session-2.scope" << false << "";
+  QTest::addRow("gnome without id") << "app-gnome-" << false << "";
+}
+
+void TestAppTracker::scopeDesktopFileId() {
+  QFETCH(QString, scopeName);
+  QFETCH(bool, resolved);
+  QFETCH(QString, desktopFileId);
+
+  std::optional<QString> result = AppTracker::scopeDesktopFileId(scopeName);
+  QCOMPARE(result.has_value(), resolved);
+  if (resolved) {
+    QCOMPARE(result.value(), desktopFileId);
+  }
+}
+
+static TestAppTracker s_testAppTracker;
@@ -0,0 +1,19 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "helper.h"
+
+class TestAppTracker final : public TestHelper {
+  Q_OBJECT
+
+ private slots:
+  void isScope_data();
+  void isScope();
+
+  void unitPath_data();
+  void unitPath();
+
+  void scopeDesktopFileId_data();
+  void scopeDesktopFileId();
+};
@@ -0,0 +1,149 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "testdaemonframing.h"
+
+#include <QJsonObject>
+
+#include "daemon/daemonframing.h"
+#include "helper.h"
+
+void TestDaemonFraming::roundTrip_data() {
+  QTest::addColumn<bool>("binary");
+
+  QTest::addRow("json") << false;
+  QTest::addRow("binary") << true;
+}
+
+void TestDaemonFraming::roundTrip() {
+  QFETCH(bool, binary);
+
+  QJsonObject message;
+  message.insert("type", "logs");
+  message.insert("logs", "first line\nsecond line|with a pipe");
+  message.insert("errorCode", 3);
+  message.insert("connected", true);
+
+  QByteArray data = DaemonFraming::encode(message, binary);
+  QCOMPARE(data.startsWith(char(DaemonFraming::VERSION)), binary);
+
+  DaemonFraming framing;
+  framing.append(data);
+
+  QJsonObject result;
+  bool resultBinary = !binary;
+  QVERIFY(framing.next(result, resultBinary));
+  QCOMPARE(resultBinary, binary);
+  QCOMPARE(result, message);
+
+  QVERIFY(!framing.next(result, resultBinary));
+}
+
+void TestDaemonFraming::mixed() {
+  QJsonObject a;
+  a.insert("type", "status");
+  QJsonObject b;
+  b.insert("type", "connected");
+  b.insert("pubkey", "abc");
+
+  DaemonFraming framing;
+  framing.append(DaemonFraming::encode(a, false));
+  framing.append(DaemonFraming::encode(b, true));
+  framing.append("\n  \n");
+  framing.append(DaemonFraming::encode(a, true));
+  framing.append(DaemonFraming::encode(b, false));
+
+  QList<QPair<QJsonObject, bool>> expected = {
+      {a, false}, {b, true}, {a, true}, {b, false}};
+  for (const auto& pair : expected) {
+    QJsonObject result;
+    bool binary;
+    QVERIFY(framing.next(result, binary));
+    QCOMPARE(result, pair.first);
+    QCOMPARE(binary, pair.second);
+  }
+
+  QJsonObject result;
+  bool binary;
+  QVERIFY(!framing.next(result, binary));
+}
+
+void TestDaemonFraming::partial() {
+  QJsonObject message;
+  message.insert("type", "logs");
+  message.insert("logs", QString(100000, 'x'));
+
+  for (bool binary : {false, true}) {
+    QByteArray data = DaemonFraming::encode(message, binary);
+
+    // Feed the message one chunk at a time, as a socket would.
+    DaemonFraming framing;
+    QJsonObject result;
+    bool resultBinary;
+    for (qsizetype pos = 0; pos < data.size(); pos += 1000) {
+      QVERIFY(!framing.next(result, resultBinary));
+      framing.append(data.mid(pos, 1000));
+    }
+
+    QVERIFY(framing.next(result, resultBinary));
+    QCOMPARE(resultBinary, binary);
+    QCOMPARE(result, message);
+  }
+}
+
+void TestDaemonFraming::invalid() {
+  QJsonObject message;
+  message.insert("type", "status");
+
+  DaemonFraming framing;
+  framing.append("not json\n");
+  framing.append("[1, 2]\n");
+
+  // A frame with a payload which isn't a CBOR map.
+  QByteArray frame(1, char(DaemonFraming::VERSION));
+  frame.append(QByteArray("\x00\x00\x00\x01", 4));
+  frame.append(char(0x01));
+  framing.append(frame);
+
+  framing.append(DaemonFraming::encode(message, true));
+
+  // Invalid messages are skipped.
+  QJsonObject result;
+  bool binary;
+  QVERIFY(framing.next(result, binary));
+  QCOMPARE(result, message);
+  QVERIFY(!framing.next(result, binary));
+
+  QVERIFY(!framing.corrupted());
+}
+
+void TestDaemonFraming::oversized() {
+  QJsonObject message;
+  message.insert("type", "status");
+
+  DaemonFraming framing;
+  framing.append(DaemonFraming::encode(message, true));
+
+  // An oversized frame can't be skipped: the stream is corrupted, and
+  // nothing else is read from it, not even what was already buffered.
+  QByteArray huge(1, char(DaemonFraming::VERSION));
+  huge.append(QByteArray("\xff\xff\xff\xff", 4));
+  framing.append(huge);
+  framing.append(DaemonFraming::encode(message, false));
+
+  QJsonObject result;
+  bool binary;
+  QVERIFY(framing.next(result, binary));
+  QCOMPARE(result, message);
+  QVERIFY(!framing.corrupted());
+
+  QVERIFY(!framing.next(result, binary));
+  QVERIFY(framing.corrupted());
+
+  framing.append(DaemonFraming::encode(message, false));
+  QVERIFY(!framing.next(result, binary));
+  QVERIFY(framing.corrupted());
+}
+
+static TestDaemonFraming s_testDaemonFraming;
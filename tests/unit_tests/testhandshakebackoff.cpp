@@ -0,0 +1,44 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "testhandshakebackoff.h"
+
+#include "daemon/handshakebackoff.h"
+#include "helper.h"
+
+void TestHandshakeBackoff::schedule() {
+  HandshakeBackoff backoff;
+  QCOMPARE(backoff.reset(), HandshakeBackoff::MIN_MSEC);
+
+  // Each missed check waits half as long again, up to the maximum.
+  QList<int> intervals;
+  for (int i = 0; i < 6; ++i) {
+    intervals.append(backoff.next());
+  }
+  QCOMPARE(intervals, QList<int>({75, 112, 168, 250, 250, 250}));
+  QCOMPARE(backoff.interval(), HandshakeBackoff::MAX_MSEC);
+
+  // The checks done before the interval is capped all fit in one second.
+  int elapsed = HandshakeBackoff::MIN_MSEC;
+  backoff.reset();
+  while (backoff.interval() < HandshakeBackoff::MAX_MSEC) {
+    elapsed += backoff.next();
+  }
+  QVERIFY(elapsed < 1000);
+}
+
+void TestHandshakeBackoff::reset() {
+  HandshakeBackoff backoff;
+  backoff.reset();
+  backoff.next();
+  backoff.next();
+  QVERIFY(backoff.interval() > HandshakeBackoff::MIN_MSEC);
+
+  // A new activation or server switch starts the schedule over.
+  QCOMPARE(backoff.reset(), HandshakeBackoff::MIN_MSEC);
+  QCOMPARE(backoff.interval(), HandshakeBackoff::MIN_MSEC);
+  QCOMPARE(backoff.next(), 75);
+}
+
+static TestHandshakeBackoff s_testHandshakeBackoff;
@@ -6,6 +6,7 @@
 
 #include "helper.h"
 #include "ipaddress.h"
+#include "iprangeset.h"
 
 void TestIpAddress::ctor() {
   IPAddress ip;
@@ -289,4 +290,106 @@ void TestIpAddress::excludeAddresses() {
   QVERIFY(list.join(",") == result);
 }
 
+void TestIpAddress::rangeSet_data() {
+  QTest::addColumn<QString>("add");
+  QTest::addColumn<QString>("remove");
+  QTest::addColumn<QString>("result");
+
+  QTest::addRow("empty") << ""
+                         << ""
+                         << "";
+  QTest::addRow("adjacent") << "10.0.0.0/25,10.0.0.128/25"
+                            << ""
+                            << "10.0.0.0/24";
+  QTest::addRow("overlapping") << "10.1.0.0/16,10.0.0.0/8,10.1.2.3"
+                               << ""
+                               << "10.0.0.0/8";
+  QTest::addRow("unaligned") << "10.0.0.1,10.0.0.2,10.0.0.3,10.0.0.4"
+                             << ""
+                             << "10.0.0.1/32,10.0.0.2/31,10.0.0.4/32";
+  QTest::addRow("host bits") << "10.1.2.3/8"
+                             << ""
+                             << "10.0.0.0/8";
+  QTest::addRow("remove all") << "10.0.0.0/24"
+                              << "10.0.0.0/8"
+                              << "";
+  QTest::addRow("remove nothing") << "10.0.0.0/24"
+                                  << "11.0.0.0/8,::/0"
+                                  << "10.0.0.0/24";
+  QTest::addRow("both families") << "0.0.0.0/0,::/0"
+                                 << "0.0.0.0/1,::/1"
+                                 << "128.0.0.0/1,8000::/1";
+  QTest::addRow("ipv6 holes") << "::/0"
+                              << "::/1,8000::/2,c000::/3"
+                              << "e000::/3";
+  QTest::addRow("remove across ranges")
+      << "10.0.0.0/24,10.0.2.0/24"
+      << "10.0.0.128/25,10.0.1.0/24,10.0.2.0/25"
+      << "10.0.0.0/25,10.0.2.128/25";
+}
+
+void TestIpAddress::rangeSet() {
+  QFETCH(QString, add);
+  QList<IPAddress> a;
+  for (const QString& addrString : add.split(",", Qt::SkipEmptyParts)) {
+    a.append(IPAddress(addrString));
+  }
+
+  QFETCH(QString, remove);
+  QList<IPAddress> b;
+  for (const QString& addrString : remove.split(",", Qt::SkipEmptyParts)) {
+    b.append(IPAddress(addrString));
+  }
+
+  IPRangeSet set;
+  for (const IPAddress& ip : a) {
+    set.add(ip);
+  }
+  set.remove(b);
+
+  QStringList list;
+  for (const IPAddress& r : set.toList()) {
+    list.append(r.toString());
+  }
+
+  std::sort(list.begin(), list.end());
+
+  QFETCH(QString, result);
+  QCOMPARE(list.join(","), result);
+  QCOMPARE(set.isEmpty(), result.isEmpty());
+
+  // Adding and removing one by one, or all at once, gives the same set.
+  IPRangeSet bulk(a);
+  bulk.remove(b);
+  QCOMPARE(bulk.toList(), set.toList());
+}
+
+void TestIpAddress::rangeSetLarge() {
+  // Every other /24 of 10.0.0.0/10, as a large custom exclusion list.
+  QList<IPAddress> excludeList;
+  for (int i = 0; i < 64; ++i) {
+    for (int j = 0; j < 256; j += 2) {
+      excludeList.append(IPAddress(QString("10.%1.%2.0/24").arg(i).arg(j)));
+    }
+  }
+
+  QList<IPAddress> result =
+      IPAddress::excludeAddresses({IPAddress("10.0.0.0/8")}, excludeList);
+  QCOMPARE(result.length(), excludeList.length() + 2);
+  QVERIFY(result.contains(IPAddress("10.0.1.0/24")));
+  QVERIFY(result.contains(IPAddress("10.64.0.0/10")));
+  QVERIFY(result.contains(IPAddress("10.128.0.0/9")));
+  QVERIFY(!result.contains(IPAddress("10.0.0.0/24")));
+
+  IPRangeSet set(result);
+  QVERIFY(set.contains(QHostAddress("10.63.255.1")));
+  QVERIFY(set.contains(QHostAddress("10.200.0.1")));
+  QVERIFY(!set.contains(QHostAddress("10.63.254.1")));
+  QVERIFY(!set.contains(QHostAddress("11.0.0.1")));
+  QVERIFY(!set.contains(QHostAddress("::1")));
+
+  set.add(excludeList);
+  QCOMPARE(set.toList(), QList<IPAddress>{IPAddress("10.0.0.0/8")});
+}
+
 static TestIpAddress s_testIpAddress;
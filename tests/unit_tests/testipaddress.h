@@ -24,4 +24,9 @@ class TestIpAddress final : public TestHelper {
 
   void excludeAddresses_data();
   void excludeAddresses();
+
+  void rangeSet_data();
+  void rangeSet();
+
+  void rangeSetLarge();
 };
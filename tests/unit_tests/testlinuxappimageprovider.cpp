@@ -0,0 +1,190 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "testlinuxappimageprovider.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QIcon>
+#include <QImage>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include "platforms/linux/linuxappimageprovider.h"
+
+namespace {
+bool writeFile(const QString& path, const QByteArray& content,
+               const QDateTime& mtime = QDateTime::currentDateTime()) {
+  if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+    return false;
+  }
+
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+      file.write(content) != content.length()) {
+    return false;
+  }
+  return file.setFileTime(mtime, QFileDevice::FileModificationTime);
+}
+
+bool writeIcon(const QString& path, const QColor& color,
+               const QDateTime& mtime) {
+  QImage image(16, 16, QImage::Format_ARGB32);
+  image.fill(color);
+  if (!image.save(path, "PNG")) {
+    return false;
+  }
+
+  QFile file(path);
+  return file.open(QIODevice::ReadWrite) &&
+         file.setFileTime(mtime, QFileDevice::FileModificationTime);
+}
+
+QString writeEntry(const QTemporaryDir& dir, const QString& icon) {
+  QString path = dir.filePath("test.desktop");
+  QByteArray content = "[Desktop Entry]\nType=Application\nName=Test\nIcon=" +
+                       icon.toUtf8() + "\n";
+  return writeFile(path, content) ? path : QString();
+}
+
+qsizetype cachedIcons(const QString& path) {
+  return QDir(path).entryList({"*.png"}, QDir::Files).length();
+}
+}  // namespace
+
+void TestLinuxAppImageProvider::initTestCase() {
+  QStandardPaths::setTestModeEnabled(true);
+
+  m_themeName = QIcon::themeName();
+  m_themeSearchPaths = QIcon::themeSearchPaths();
+}
+
+void TestLinuxAppImageProvider::cleanup() {
+  QIcon::setThemeSearchPaths(m_themeSearchPaths);
+  QIcon::setThemeName(m_themeName);
+}
+
+void TestLinuxAppImageProvider::evictDiskCache() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  QDateTime now = QDateTime::currentDateTime();
+  for (int i = 0; i < 8; ++i) {
+    QVERIFY(writeFile(dir.filePath(QString("%1.png").arg(i)), "icon",
+                      now.addSecs(-3600 * i)));
+  }
+  QVERIFY(writeFile(dir.filePath("size"), "size", now.addDays(-1)));
+
+  // Under the limit, nothing goes.
+  LinuxAppImageProvider::evictDiskCache(dir.path(), 8);
+  QCOMPARE(cachedIcons(dir.path()), 8);
+
+  // Past it, the least recently used icons go, down to 3/4 of the limit.
+  LinuxAppImageProvider::evictDiskCache(dir.path(), 4);
+  QCOMPARE(QDir(dir.path()).entryList({"*.png"}, QDir::Files, QDir::Name),
+           QStringList({"0.png", "1.png", "2.png"}));
+  QVERIFY(QFileInfo::exists(dir.filePath("size")));
+}
+
+void TestLinuxAppImageProvider::iconFileKey() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  QDateTime now = QDateTime::currentDateTime().addSecs(-60);
+  QDateTime older = now.addDays(-1);
+
+  QString themeFoo = dir.filePath("mzvpntheme/16x16/apps/mzvpn-foo.png");
+  QString themeFooSvg = dir.filePath("mzvpntheme/scalable/apps/mzvpn-foo.svg");
+  QString baseFoo = dir.filePath("mzvpnbase/16x16/apps/mzvpn-foo.png");
+  QString baseBar = dir.filePath("mzvpnbase/16x16/apps/mzvpn-bar.png");
+  QVERIFY(writeFile(dir.filePath("mzvpntheme/index.theme"),
+                    "[Icon Theme]\nName=Test\nInherits=mzvpnbase\n"));
+  QVERIFY(writeFile(themeFoo, "", older));
+  QVERIFY(writeFile(themeFooSvg, "", now));
+  QVERIFY(writeFile(baseFoo, "", now.addSecs(30)));
+  QVERIFY(writeFile(baseBar, "", older));
+
+  QIcon::setThemeSearchPaths({dir.path()});
+  QIcon::setThemeName("mzvpntheme");
+
+  LinuxAppImageProvider provider(nullptr);
+  QMutexLocker lock(&provider.m_renderMutex);
+
+  auto key = [](const QString& path, const QDateTime& mtime) {
+    return QString("%1|%2").arg(path).arg(mtime.toMSecsSinceEpoch());
+  };
+
+  // The theme wins over the one it inherits from. Any of its files for the
+  // name invalidates the key.
+  QCOMPARE(provider.iconFileKey("mzvpn-foo", QSize(16, 16)),
+           key(themeFoo, now));
+  QCOMPARE(provider.iconFileKey("mzvpn-foo", QSize(32, 32)),
+           key(themeFooSvg, now));
+  QCOMPARE(provider.iconFileKey("mzvpn-bar", QSize(16, 16)),
+           key(baseBar, older));
+  QCOMPARE(provider.iconFileKey("mzvpn-missing", QSize(16, 16)),
+           QString("|0"));
+  QCOMPARE(provider.iconFileKey(baseBar, QSize(16, 16)), key(baseBar, older));
+
+  // A new icon is found once the index is dropped.
+  QString themeBar = dir.filePath("mzvpntheme/16x16/apps/mzvpn-bar.png");
+  QVERIFY(writeFile(themeBar, "", now));
+  QCOMPARE(provider.iconFileKey("mzvpn-bar", QSize(16, 16)),
+           key(baseBar, older));
+  provider.m_iconFilesIndexed = false;
+  QCOMPARE(provider.iconFileKey("mzvpn-bar", QSize(16, 16)),
+           key(themeBar, now));
+}
+
+void TestLinuxAppImageProvider::missingIconNotCached() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  QString id = writeEntry(dir, "mzvpn-missing-icon");
+  QVERIFY(!id.isEmpty());
+
+  LinuxAppImageProvider provider(nullptr);
+  provider.m_diskCachePath = dir.filePath("cache");
+
+  QSize size;
+  QVERIFY(provider.requestImage(id, &size, QSize(16, 16)).isNull());
+  QVERIFY(provider.m_memoryCache.isEmpty());
+  QCOMPARE(cachedIcons(provider.m_diskCachePath), 0);
+}
+
+void TestLinuxAppImageProvider::diskKeyFollowsIconFile() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  QString iconPath = dir.filePath("icon.png");
+  QDateTime mtime = QDateTime::currentDateTime().addDays(-1);
+  QVERIFY(writeIcon(iconPath, Qt::red, mtime));
+
+  QString id = writeEntry(dir, iconPath);
+  QVERIFY(!id.isEmpty());
+
+  LinuxAppImageProvider provider(nullptr);
+  provider.m_diskCachePath = dir.filePath("cache");
+
+  QImage image = provider.iconImage(id, QSize(16, 16));
+  QVERIFY(!image.isNull());
+  QCOMPARE(image.pixelColor(8, 8), QColor(Qt::red));
+  QCOMPARE(provider.m_memoryCache.size(), 1);
+  QCOMPARE(cachedIcons(provider.m_diskCachePath), 1);
+
+  // Read back from the disk.
+  provider.m_memoryCache.clear();
+  image = provider.iconImage(id, QSize(16, 16));
+  QCOMPARE(image.pixelColor(8, 8), QColor(Qt::red));
+  QCOMPARE(cachedIcons(provider.m_diskCachePath), 1);
+
+  // The desktop file is the same, but the icon file changed.
+  QVERIFY(writeIcon(iconPath, Qt::blue, mtime.addSecs(60)));
+  image = provider.iconImage(id, QSize(16, 16));
+  QCOMPARE(image.pixelColor(8, 8), QColor(Qt::blue));
+  QCOMPARE(cachedIcons(provider.m_diskCachePath), 2);
+}
+
+static TestLinuxAppImageProvider s_testLinuxAppImageProvider;
@@ -0,0 +1,128 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "testlinuxdesktopentrycatalog.h"
+
+#include <QTemporaryDir>
+
+#include "platforms/linux/linuxdesktopentrycatalog.h"
+
+namespace {
+QString writeEntry(const QTemporaryDir& dir, const QByteArray& content) {
+  QString path = dir.filePath("test.desktop");
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    return QString();
+  }
+  file.write(content);
+  return path;
+}
+}  // namespace
+
+void TestLinuxDesktopEntryCatalog::unescape_data() {
+  QTest::addColumn<QString>("value");
+  QTest::addColumn<QString>("result");
+
+  QTest::addRow("plain") << "Firefox" << "Firefox";
+  QTest::addRow("empty") << "" << "";
+  QTest::addRow("space") << "Web\\sBrowser" << "Web Browser";
+  QTest::addRow("newline") << "a\\nb" << "a\nb";
+  QTest::addRow("tab") << "a\\tb" << "a\tb";
+  QTest::addRow("carriage return") << "a\\rb" << "a\rb";
+  QTest::addRow("backslash") << "C:\\\\Games" << "C:\\Games";
+  QTest::addRow("semicolon") << "a\\;b" << "a;b";
+  QTest::addRow("unknown") << "a\\qb" << "aqb";
+  QTest::addRow("trailing backslash") << "abc\\" << "abc\\";
+  QTest::addRow("consecutive") << "\\s\\s" << "  ";
+}
+
+void TestLinuxDesktopEntryCatalog::unescape() {
+  QFETCH(QString, value);
+  QFETCH(QString, result);
+  QCOMPARE(LinuxDesktopEntryCatalog::unescape(value), result);
+}
+
+void TestLinuxDesktopEntryCatalog::splitList_data() {
+  QTest::addColumn<QString>("value");
+  QTest::addColumn<QStringList>("result");
+
+  QTest::addRow("empty") << "" << QStringList();
+  QTest::addRow("one") << "GNOME" << QStringList{"GNOME"};
+  QTest::addRow("trailing separator") << "GNOME;KDE;"
+                                      << QStringList{"GNOME", "KDE"};
+  QTest::addRow("empty items") << ";GNOME;;KDE" << QStringList{"GNOME", "KDE"};
+  QTest::addRow("spaces") << " GNOME ; KDE "
+                          << QStringList{"GNOME", "KDE"};
+  QTest::addRow("separators only") << ";;" << QStringList();
+}
+
+void TestLinuxDesktopEntryCatalog::splitList() {
+  QFETCH(QString, value);
+  QFETCH(QStringList, result);
+  QCOMPARE(LinuxDesktopEntryCatalog::splitList(value), result);
+}
+
+void TestLinuxDesktopEntryCatalog::parse() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  QString path = writeEntry(dir,
+                            "# A comment\n"
+                            "\n"
+                            "[Desktop Entry]\n"
+                            "Type=Application\n"
+                            "Name=Web\\sBrowser\n"
+                            "Name[de]=Webbrowser\n"
+                            "  Icon = firefox  \n"
+                            "OnlyShowIn=GNOME;Unity;\n"
+                            "NotShowIn=KDE;\n"
+                            "NoDisplay=true\n"
+                            "Hidden=false\n"
+                            "=ignored\n"
+                            "Exec\n");
+  QVERIFY(!path.isEmpty());
+
+  LinuxDesktopEntry entry;
+  QVERIFY(LinuxDesktopEntryCatalog::parse(path, entry));
+  QCOMPARE(entry.m_type, "Application");
+  QCOMPARE(entry.m_name, "Web Browser");
+  QCOMPARE(entry.m_icon, "firefox");
+  QCOMPARE(entry.m_onlyShowIn, QStringList({"GNOME", "Unity"}));
+  QCOMPARE(entry.m_notShowIn, QStringList({"KDE"}));
+  QVERIFY(entry.m_noDisplay);
+  QVERIFY(!entry.m_hidden);
+}
+
+void TestLinuxDesktopEntryCatalog::parseMainGroupOnly() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  QString path = writeEntry(dir,
+                            "Name=Before any group\n"
+                            "[Other Group]\n"
+                            "Name=Other\n"
+                            "[Desktop Entry]\n"
+                            "Name=Main\n"
+                            "[Desktop Action new-window]\n"
+                            "Name=Action\n"
+                            "Hidden=true\n");
+  QVERIFY(!path.isEmpty());
+
+  LinuxDesktopEntry entry;
+  QVERIFY(LinuxDesktopEntryCatalog::parse(path, entry));
+  QCOMPARE(entry.m_name, "Main");
+  QVERIFY(!entry.m_hidden);
+  QVERIFY(entry.m_type.isEmpty());
+}
+
+void TestLinuxDesktopEntryCatalog::parseMissingFile() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  LinuxDesktopEntry entry;
+  QVERIFY(!LinuxDesktopEntryCatalog::parse(dir.filePath("missing.desktop"),
+                                           entry));
+}
+
+static TestLinuxDesktopEntryCatalog s_testLinuxDesktopEntryCatalog;
@@ -4,8 +4,13 @@
 
 #include "testlogger.h"
 
+#include <QDir>
+#include <QFile>
 #include <QScopeGuard>
+#include <QStandardPaths>
+#include <QThread>
 
+#include "constants.h"
 #include "helper.h"
 #include "logger.h"
 #include "loghandler.h"
@@ -77,4 +82,247 @@ void TestLogger::logTruncation() {
   QVERIFY(truncatedBuffer.size() < 128 * 1024);
 }
 
+void TestLogger::asyncLogHandler() {
+  LogHandler* lh = LogHandler::instance();
+
+  LogHandler::setStderr(false);
+  auto guard = qScopeGuard([&] {
+    LogHandler::setAsynchronous(false);
+    LogHandler::setStderr(true);
+  });
+
+  lh->cleanupLogs();
+  LogHandler::setAsynchronous(true);
+
+  // Log from several threads at once, enough to wrap the ring a few times.
+  constexpr int threadCount = 4;
+  constexpr int messageCount = 5000;
+  QList<QThread*> threads;
+  for (int t = 0; t < threadCount; ++t) {
+    threads.append(QThread::create([t]() {
+      Logger l("async");
+      for (int i = 0; i < messageCount; ++i) {
+        l.debug() << "Thread" << QString::number(t) << "message"
+                  << QString::number(i);
+      }
+    }));
+    threads.last()->start();
+  }
+  for (QThread* thread : threads) {
+    QVERIFY(thread->wait());
+    delete thread;
+  }
+
+  // Writing the logs must flush whatever is still queued, and nothing may be
+  // lost or reordered within a thread.
+  QString buffer;
+  {
+    QTextStream out(&buffer);
+    lh->writeLogs(out);
+  }
+  for (int t = 0; t < threadCount; ++t) {
+    const QString first = QString("Thread %1 message 0\n").arg(t);
+    const QString last =
+        QString("Thread %1 message %2\n").arg(t).arg(messageCount - 1);
+    QVERIFY(buffer.indexOf(first) >= 0);
+    QVERIFY(buffer.indexOf(first) < buffer.indexOf(last));
+    QCOMPARE(buffer.count(QString("Thread %1 message ").arg(t)), messageCount);
+  }
+}
+
+void TestLogger::asyncLogRecords() {
+  LogHandler* lh = LogHandler::instance();
+  Logger l("records");
+
+  LogHandler::setStderr(false);
+  auto guard = qScopeGuard([&] {
+    LogHandler::setAsynchronous(false);
+    LogHandler::setStderr(true);
+  });
+
+  lh->cleanupLogs();
+  LogHandler::setAsynchronous(true);
+
+  // A record too long for a slot of the ring is written synchronously, after
+  // the ones queued before it.
+  const QString longMessage(2000, 'x');
+  l.debug() << "Before";
+  l.debug() << longMessage;
+  l.debug() << "After";
+
+  // Logging from a slot of logEntryAdded() must not deadlock.
+  Logger nested("nested");
+  QMetaObject::Connection connection = connect(
+      lh, &LogHandler::logEntryAdded, lh,
+      [&nested](const QByteArray& log) {
+        if (log.contains("Trigger")) {
+          nested.debug() << "Nested";
+        }
+      },
+      Qt::DirectConnection);
+  auto disconnectGuard =
+      qScopeGuard([&connection] { QObject::disconnect(connection); });
+  l.debug() << "Trigger";
+
+  QString buffer;
+  {
+    QTextStream out(&buffer);
+    lh->writeLogs(out);
+  }
+  qsizetype before = buffer.indexOf("(records) Debug: Before\n");
+  qsizetype middle = buffer.indexOf(longMessage);
+  qsizetype after = buffer.indexOf("(records) Debug: After\n");
+  QVERIFY(before >= 0);
+  QVERIFY(before < middle);
+  QVERIFY(middle < after);
+  QVERIFY(buffer.indexOf("(records) Debug: Trigger\n") <
+          buffer.indexOf("(nested) Debug: Nested\n"));
+}
+
+void TestLogger::nestedLogRecords() {
+  LogHandler* lh = LogHandler::instance();
+  Logger l("records");
+
+  LogHandler::setStderr(false);
+  auto guard = qScopeGuard([&] { LogHandler::setStderr(true); });
+
+  lh->cleanupLogs();
+
+  // A record logged while another one is written out is written right after
+  // it, not dropped.
+  Logger nested("nested");
+  QMetaObject::Connection connection = connect(
+      lh, &LogHandler::logEntryAdded, lh,
+      [&nested](const QByteArray& log) {
+        if (log.contains("Trigger")) {
+          nested.debug() << "Nested";
+        }
+      },
+      Qt::DirectConnection);
+  auto disconnectGuard =
+      qScopeGuard([&connection] { QObject::disconnect(connection); });
+  l.debug() << "Trigger";
+  l.debug() << "After";
+
+  QString buffer;
+  {
+    QTextStream out(&buffer);
+    lh->writeLogs(out);
+  }
+  qsizetype trigger = buffer.indexOf("(records) Debug: Trigger\n");
+  qsizetype nestedPos = buffer.indexOf("(nested) Debug: Nested\n");
+  qsizetype after = buffer.indexOf("(records) Debug: After\n");
+  QVERIFY(trigger >= 0);
+  QVERIFY(trigger < nestedPos);
+  QVERIFY(nestedPos < after);
+}
+
+void TestLogger::binaryLogHandler() {
+  LogHandler* lh = LogHandler::instance();
+  Logger l("binary");
+
+  LogHandler::setStderr(false);
+  auto guard = qScopeGuard([&] {
+    LogHandler::setBinaryFormat(false);
+    LogHandler::setStderr(true);
+  });
+
+  l.info() << "Text";
+
+  // The text log written before is left alone.
+  LogHandler::setBinaryFormat(true);
+  QString location =
+      QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+  QVERIFY(QFile::exists(QDir(location).filePath(Constants::LOG_FILE_NAME)));
+
+  lh->cleanupLogs();
+
+  // Write a megabyte of log data, this rotates the segments many times.
+  const QString example = "All work and no play makes Jack a dull boy";
+  qsizetype count = (1024 * 1024) / example.size();
+  while (count-- > 0) {
+    l.info() << example;
+  }
+  l.warning() << "Last" << "entry";
+
+  // Only the last two segments are retained, decoded back to text.
+  QString buffer;
+  {
+    QTextStream out(&buffer);
+    lh->writeLogs(out);
+  }
+  QVERIFY(buffer.size() > 64 * 1024);
+  QVERIFY(buffer.size() < 256 * 1024);
+  QVERIFY(buffer.startsWith('['));
+  QVERIFY(buffer.contains("(binary) Info: " + example + "\n"));
+  QVERIFY(buffer.endsWith("(binary) Warning: Last entry\n"));
+
+  // Cleaning up the logs drops every segment.
+  lh->cleanupLogs();
+  buffer.clear();
+  {
+    QTextStream out(&buffer);
+    lh->writeLogs(out);
+  }
+  QVERIFY(!buffer.contains(example));
+}
+
+void TestLogger::levelFiltering() {
+  Logger l("filter");
+  auto guard = qScopeGuard([] { Logger::setMinLevel(Trace); });
+
+  int evaluated = 0;
+  auto argument = [&evaluated]() {
+    ++evaluated;
+    return QString("argument");
+  };
+
+  Logger::setMinLevel(Info);
+  QVERIFY(!Logger::isEnabled(Debug));
+  QVERIFY(Logger::isEnabled(Warning));
+  MZ_LOG(l, Debug) << "Skipped" << argument();
+  QCOMPARE(evaluated, 0);
+  MZ_LOG(l, Info) << "Logged" << argument();
+  QCOMPARE(evaluated, 1);
+
+  Logger::setMinLevel(Trace);
+  MZ_LOG(l, Debug) << "Logged" << argument();
+  QCOMPARE(evaluated, 2);
+}
+
+void TestLogger::debugLogBenchmark_data() {
+  QTest::addColumn<int>("minLevel");
+
+  QTest::newRow("debug enabled") << static_cast<int>(Trace);
+  QTest::newRow("debug disabled") << static_cast<int>(Info);
+}
+
+// Debug statements going through MZ_LOG, like the ones logged on every state
+// change of a connection, with debug logging enabled and disabled.
+void TestLogger::debugLogBenchmark() {
+  QFETCH(int, minLevel);
+
+  Logger l("benchmark");
+  LogHandler::setStderr(false);
+  Logger::setMinLevel(static_cast<LogLevel>(minLevel));
+  auto guard = qScopeGuard([&] {
+    Logger::setMinLevel(Trace);
+    LogHandler::setStderr(true);
+  });
+
+  const QString publicKey = "Rzh64qPcg8W8klJq0H4EZdVCH7iaPuQ9ObgbzaabCRI=";
+  const QList<State> cycle = {StateConnecting, StateConfirming, StateOn,
+                              StateDisconnecting, StateOff};
+
+  QBENCHMARK {
+    for (State state : cycle) {
+      MZ_LOG(l, Debug) << "Setting state:" << state;
+    }
+    MZ_LOG(l, Debug) << "Activating peer" << l.keys(publicKey);
+    MZ_LOG(l, Debug) << "handshake completed with:" << l.keys(publicKey);
+    MZ_LOG(l, Debug) << "Connected from state:" << StateConfirming;
+    MZ_LOG(l, Debug) << "Disconnected from state:" << StateDisconnecting;
+  }
+}
+
 static TestLogger s_testLogger;
@@ -7,10 +7,34 @@
 class TestLogger final : public TestHelper {
   Q_OBJECT
 
+ public:
+  // Logged by name in the benchmark, as the state machines of the app do.
+  enum State {
+    StateOff,
+    StateConnecting,
+    StateConfirming,
+    StateOn,
+    StateDisconnecting,
+  };
+  Q_ENUM(State)
+
  private slots:
   void logger();
 
   void logHandler();
 
   void logTruncation();
+
+  void asyncLogHandler();
+
+  void asyncLogRecords();
+
+  void nestedLogRecords();
+
+  void binaryLogHandler();
+
+  void levelFiltering();
+
+  void debugLogBenchmark_data();
+  void debugLogBenchmark();
 };
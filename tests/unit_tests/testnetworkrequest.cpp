@@ -4,11 +4,92 @@
 
 #include "testnetworkrequest.h"
 
+#include <QDir>
+#include <QFile>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <functional>
+#include <memory>
+
+#include "constants.h"
+#include "feature/feature.h"
+#include "networkmanager.h"
 #include "networkrequest.h"
+#include "networkresponsecache.h"
 #include "settingsholder.h"
 #include "simplenetworkmanager.h"
 #include "tasks/function/taskfunction.h"
 
+namespace {
+// A tiny HTTP server. Each request is answered with the response built by
+// the handler, after an optional delay, then the connection is closed.
+class TestHttpServer final : public QTcpServer {
+ public:
+  using Handler = std::function<QByteArray(const QByteArray& request)>;
+
+  explicit TestHttpServer(Handler&& handler, int delayMsec = 0)
+      : m_handler(std::move(handler)), m_delayMsec(delayMsec) {
+    connect(this, &QTcpServer::newConnection, this, &TestHttpServer::accept);
+  }
+
+  // The number of requests answered so far.
+  int requests() const { return m_requests; }
+
+ private:
+  void accept() {
+    while (QTcpSocket* socket = nextPendingConnection()) {
+      auto buffer = std::make_shared<QByteArray>();
+      connect(socket, &QTcpSocket::readyRead, socket, [this, socket, buffer]() {
+        buffer->append(socket->readAll());
+        if (!buffer->contains("\r\n\r\n")) {
+          return;
+        }
+
+        ++m_requests;
+        QByteArray response = m_handler(*buffer);
+        buffer->clear();
+        QTimer::singleShot(m_delayMsec, socket, [socket, response]() {
+          socket->write(response);
+          socket->disconnectFromHost();
+        });
+      });
+    }
+  }
+
+  Handler m_handler;
+  int m_delayMsec;
+  int m_requests = 0;
+};
+
+QByteArray helloResponse(const QByteArray&) {
+  return "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n"
+         "Connection: close\r\n\r\nhello";
+}
+
+// Points the API base URL at the server, and flips the shared connections
+// feature on if requested. It is off by default.
+void setupApiServer(SettingsHolder& settingsHolder, const QTcpServer& server,
+                    bool shared) {
+  settingsHolder.setStagingServerAddress(
+      QString("http://127.0.0.1:%1").arg(server.serverPort()));
+  Constants::setStaging();
+  if (shared) {
+    settingsHolder.setFeaturesFlippedOn(
+        {Feature::Feature_sharedApiConnections});
+  }
+  Feature::testReset();
+}
+
+void resetApiServer(SettingsHolder& settingsHolder) {
+  settingsHolder.removeStagingServerAddress();
+  Constants::setStaging();
+  settingsHolder.setFeaturesFlippedOn({});
+  Feature::testReset();
+}
+}  // namespace
+
 void TestNetworkRequest::testSetAuthHeader() {
   SettingsHolder settingsHolder;
   SimpleNetworkManager snm;
@@ -28,4 +109,312 @@ void TestNetworkRequest::testSetAuthHeader() {
   QCOMPARE(request.m_request.rawHeader("Authorization"), "ANOTHER TOKEN");
 }
 
+void TestNetworkRequest::testResponseCache() {
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+
+  NetworkResponseCache cache;
+  cache.setPath(dir.path());
+
+  QUrl url("https://example.com/api/v1/servers");
+  QCOMPARE(cache.lookup(url, "Bearer A").isValid(), false);
+
+  NetworkResponseCache::Entry entry;
+  entry.m_etag = "\"abc\"";
+  entry.m_lastModified = "Wed, 21 Oct 2015 07:28:00 GMT";
+  entry.m_data = "account-specific server list";
+  cache.store(url, "Bearer A", entry);
+
+  // Nothing is stored in the clear.
+  const QStringList files = QDir(dir.path()).entryList(QDir::Files);
+  QCOMPARE(files.length(), 1);
+  QFile file(dir.filePath(files.first()));
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  const QByteArray contents = file.readAll();
+  QVERIFY(!contents.contains(entry.m_data));
+  QVERIFY(!contents.contains(entry.m_etag));
+  file.close();
+
+  NetworkResponseCache::Entry cached = cache.lookup(url, "Bearer A");
+  QVERIFY(cached.isValid());
+  QCOMPARE(cached.m_etag, entry.m_etag);
+  QCOMPARE(cached.m_lastModified, entry.m_lastModified);
+  QCOMPARE(cached.m_data, entry.m_data);
+
+  // Entries are bound to the authorization header and the URL.
+  QCOMPARE(cache.lookup(url, "Bearer B").isValid(), false);
+  QCOMPARE(cache.lookup(QUrl("https://example.com/api/v1/account"), "Bearer A")
+               .isValid(),
+           false);
+
+  // A response without validators drops the previous entry.
+  cache.store(url, "Bearer A", NetworkResponseCache::Entry());
+  QCOMPARE(cache.lookup(url, "Bearer A").isValid(), false);
+
+  cache.store(url, "Bearer A", entry);
+  cache.clear();
+  QCOMPARE(cache.lookup(url, "Bearer A").isValid(), false);
+}
+
+void TestNetworkRequest::testNotModified() {
+  SettingsHolder settingsHolder;
+  SimpleNetworkManager snm;
+
+  QTemporaryDir dir;
+  QVERIFY(dir.isValid());
+  NetworkManager::instance()->responseCache()->setPath(dir.path());
+
+  // Answers 304 to the requests carrying the current ETag.
+  QList<QByteArray> requests;
+  TestHttpServer server([&](const QByteArray& request) -> QByteArray {
+    requests.append(request);
+    if (request.contains("\r\nIf-None-Match: \"v1\"\r\n")) {
+      return "HTTP/1.1 304 Not Modified\r\nETag: \"v1\"\r\n"
+             "Connection: close\r\n\r\n";
+    }
+    return "HTTP/1.1 200 OK\r\nETag: \"v1\"\r\nContent-Length: 7\r\n"
+           "Connection: close\r\n\r\nservers";
+  });
+  QVERIFY(server.listen(QHostAddress::LocalHost));
+  QUrl url(QString("http://127.0.0.1:%1/servers").arg(server.serverPort()));
+
+  TaskFunction task([&]() {});
+  auto fetch = [&](QByteArray& completed, QByteArray& notModified) {
+    NetworkRequest* request = new NetworkRequest(&task, 200);
+    request->enableResponseCache();
+    connect(request, &NetworkRequest::requestCompleted, &task,
+            [&](const QByteArray& data) { completed = data; });
+    connect(request, &NetworkRequest::requestNotModified, &task,
+            [&](const QByteArray& data) { notModified = data; });
+    request->get(url);
+  };
+
+  // The first response is cached, with its ETag.
+  {
+    QByteArray completed;
+    QByteArray notModified;
+    fetch(completed, notModified);
+    QTRY_COMPARE(completed, "servers");
+    QVERIFY(notModified.isEmpty());
+    QVERIFY(!requests.last().contains("If-None-Match"));
+  }
+
+  // The next request is conditional, and gets the cached body back.
+  {
+    QByteArray completed;
+    QByteArray notModified;
+    fetch(completed, notModified);
+    QTRY_COMPARE(notModified, "servers");
+    QVERIFY(completed.isEmpty());
+    QVERIFY(requests.last().contains("\r\nIf-None-Match: \"v1\"\r\n"));
+  }
+
+  QCOMPARE(server.requests(), 2);
+}
+
+void TestNetworkRequest::testSharedGet() {
+  SettingsHolder settingsHolder;
+  SimpleNetworkManager snm;
+
+  TestHttpServer server(helloResponse);
+  QVERIFY(server.listen(QHostAddress::LocalHost));
+  setupApiServer(settingsHolder, server, true);
+
+  TaskFunction task([&]() {});
+  QUrl url(Constants::apiBaseUrl() + "/api/v1/vpn/servers");
+
+  QList<QByteArray> results;
+  for (int i = 0; i < 3; ++i) {
+    NetworkRequest* request = new NetworkRequest(&task, 200);
+    connect(request, &NetworkRequest::requestCompleted, &task,
+            [&](const QByteArray& data) { results.append(data); });
+    request->get(url);
+  }
+
+  // Identical GETs in flight share one reply.
+  QTRY_COMPARE(results.count(), 3);
+  QCOMPARE(results, QList<QByteArray>({"hello", "hello", "hello"}));
+  QCOMPARE(server.requests(), 1);
+
+  resetApiServer(settingsHolder);
+}
+
+void TestNetworkRequest::benchmarkGetDedup_data() {
+  QTest::addColumn<bool>("shared");
+
+  QTest::addRow("independent") << false;
+  QTest::addRow("deduplicated") << true;
+}
+
+// Measures how identical GETs in flight share one reply. The test server only
+// speaks plain HTTP/1.1: the HTTP/2 connection reuse of the API requests is
+// not part of it.
+void TestNetworkRequest::benchmarkGetDedup() {
+  QFETCH(bool, shared);
+
+  SettingsHolder settingsHolder;
+  SimpleNetworkManager snm;
+
+  // Each answer takes a simulated round trip to the API.
+  TestHttpServer server(helloResponse, 20);
+  QVERIFY(server.listen(QHostAddress::LocalHost));
+  setupApiServer(settingsHolder, server, shared);
+
+  TaskFunction task([&]() {});
+  QUrl url(Constants::apiBaseUrl() + "/api/v1/vpn/servers");
+
+  // More requests than the 6 HTTP/1.1 connections allowed per host, so
+  // independent requests queue behind each other.
+  constexpr int REQUESTS = 12;
+
+  QBENCHMARK {
+    int completed = 0;
+    for (int i = 0; i < REQUESTS; ++i) {
+      NetworkRequest* request = new NetworkRequest(&task, 200);
+      connect(request, &NetworkRequest::requestCompleted, &task,
+              [&](const QByteArray&) { ++completed; });
+      request->get(url);
+    }
+    QTRY_COMPARE(completed, REQUESTS);
+  }
+
+  resetApiServer(settingsHolder);
+}
+
+void TestNetworkRequest::testStreaming() {
+  SettingsHolder settingsHolder;
+  SimpleNetworkManager snm;
+
+  TestHttpServer server([](const QByteArray& request) -> QByteArray {
+    if (request.startsWith("GET /missing ")) {
+      return "HTTP/1.1 404 Not Found\r\nContent-Length: 7\r\n"
+             "Connection: close\r\n\r\nmissing";
+    }
+    return "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n"
+           "Connection: close\r\n\r\n0123456789";
+  });
+  QVERIFY(server.listen(QHostAddress::LocalHost));
+  QString base = QString("http://127.0.0.1:%1").arg(server.serverPort());
+
+  TaskFunction task([&]() {});
+
+  // A successful body is only delivered in chunks.
+  {
+    NetworkRequest* request = new NetworkRequest(&task, 200);
+    request->enableStreaming();
+
+    QByteArray streamed;
+    bool completed = false;
+    connect(request, &NetworkRequest::requestDataReceived, &task,
+            [&](const QByteArray& data) { streamed.append(data); });
+    connect(request, &NetworkRequest::requestCompleted, &task,
+            [&](const QByteArray& data) {
+              QVERIFY(data.isEmpty());
+              completed = true;
+            });
+    request->get(QUrl(base + "/package"));
+
+    QTRY_VERIFY(completed);
+    QCOMPARE(streamed, "0123456789");
+  }
+
+  // An error body is not streamed, and reaches requestFailed.
+  {
+    NetworkRequest* request = new NetworkRequest(&task, 200);
+    request->enableStreaming();
+
+    QByteArray streamed;
+    QByteArray errorBody;
+    bool failed = false;
+    connect(request, &NetworkRequest::requestDataReceived, &task,
+            [&](const QByteArray& data) { streamed.append(data); });
+    connect(request, &NetworkRequest::requestFailed, &task,
+            [&](QNetworkReply::NetworkError, const QByteArray& data) {
+              errorBody = data;
+              failed = true;
+            });
+    request->get(QUrl(base + "/missing"));
+
+    QTRY_VERIFY(failed);
+    QVERIFY(streamed.isEmpty());
+    QCOMPARE(errorBody, "missing");
+  }
+}
+
+void TestNetworkRequest::testRangeResume_data() {
+  QTest::addColumn<QByteArray>("ifRange");
+  QTest::addColumn<int>("status");
+  QTest::addColumn<qint64>("rangeStart");
+  QTest::addColumn<QByteArray>("body");
+
+  QTest::addRow("same ETag") << QByteArray("\"v1\"") << 206 << qint64(4)
+                             << QByteArray("456789");
+  QTest::addRow("changed ETag") << QByteArray("\"v0\"") << 200 << qint64(-1)
+                                << QByteArray("0123456789");
+}
+
+void TestNetworkRequest::testRangeResume() {
+  QFETCH(QByteArray, ifRange);
+  QFETCH(int, status);
+  QFETCH(qint64, rangeStart);
+  QFETCH(QByteArray, body);
+
+  SettingsHolder settingsHolder;
+  SimpleNetworkManager snm;
+
+  // Serves a package, honoring "Range: bytes=<n>-" as long as If-Range
+  // matches its ETag.
+  TestHttpServer server([](const QByteArray& request) -> QByteArray {
+    const QByteArray package = "0123456789";
+    const QByteArray rangeHeader = "\r\nRange: bytes=";
+    qsizetype range = request.indexOf(rangeHeader);
+    if (range >= 0 && request.contains("\r\nIf-Range: \"v1\"\r\n")) {
+      qsizetype start = range + rangeHeader.length();
+      qint64 offset =
+          request.mid(start, request.indexOf('-', start) - start).toLongLong();
+      QByteArray part = package.mid(offset);
+      return "HTTP/1.1 206 Partial Content\r\nETag: \"v1\"\r\n"
+             "Content-Range: bytes " +
+             QByteArray::number(offset) + "-9/10\r\nContent-Length: " +
+             QByteArray::number(part.length()) +
+             "\r\nConnection: close\r\n\r\n" + part;
+    }
+    return "HTTP/1.1 200 OK\r\nETag: \"v1\"\r\nContent-Length: 10\r\n"
+           "Connection: close\r\n\r\n" +
+           package;
+  });
+  QVERIFY(server.listen(QHostAddress::LocalHost));
+
+  TaskFunction task([&]() {});
+  NetworkRequest* request = new NetworkRequest(&task, 200);
+  request->addExpectedStatus(206);
+  request->enableStreaming();
+
+  // Resume after the first 4 bytes, as Balrog does.
+  QNetworkRequest& internal = request->requestInternal();
+  internal.setRawHeader("Range", "bytes=4-");
+  internal.setRawHeader("If-Range", ifRange);
+
+  int headerStatus = 0;
+  qint64 headerRangeStart = 0;
+  QByteArray streamed;
+  bool completed = false;
+  connect(request, &NetworkRequest::requestHeaderReceived, &task,
+          [&](NetworkRequest* request) {
+            headerStatus = request->statusCode();
+            headerRangeStart = request->contentRangeStart();
+          });
+  connect(request, &NetworkRequest::requestDataReceived, &task,
+          [&](const QByteArray& data) { streamed.append(data); });
+  connect(request, &NetworkRequest::requestCompleted, &task,
+          [&](const QByteArray&) { completed = true; });
+  request->get(
+      QUrl(QString("http://127.0.0.1:%1/package").arg(server.serverPort())));
+
+  QTRY_VERIFY(completed);
+  QCOMPARE(headerStatus, status);
+  QCOMPARE(headerRangeStart, rangeStart);
+  QCOMPARE(streamed, body);
+}
+
 static TestNetworkRequest s_testNetworkRequest;
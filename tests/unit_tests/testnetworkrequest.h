@@ -9,4 +9,13 @@ class TestNetworkRequest final : public TestHelper {
 
  private slots:
   void testSetAuthHeader();
+  void testResponseCache();
+  void testNotModified();
+  void testSharedGet();
+  void testStreaming();
+  void testRangeResume_data();
+  void testRangeResume();
+
+  void benchmarkGetDedup_data();
+  void benchmarkGetDedup();
 };
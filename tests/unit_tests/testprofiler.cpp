@@ -0,0 +1,63 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "testprofiler.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QSignalSpy>
+
+#include "helper.h"
+#include "profiler.h"
+
+void TestProfiler::disabled() {
+  Profiler* profiler = Profiler::instance();
+  QVERIFY(!Profiler::isEnabled());
+
+  QSignalSpy spy(profiler, &Profiler::eventAdded);
+  { MZ_PROFILE_SCOPE("test", "disabled"); }
+  profiler->addEvent("test", "disabled", Profiler::timestamp(), 1);
+  QCOMPARE(spy.count(), 0);
+}
+
+void TestProfiler::session() {
+  Profiler* profiler = Profiler::instance();
+  QSignalSpy spy(profiler, &Profiler::eventAdded);
+
+  const qint64 before = Profiler::timestamp();
+  profiler->start();
+  QVERIFY(Profiler::isEnabled());
+
+  { MZ_PROFILE_SCOPE("test", "scope"); }
+
+  // Events starting before the session are clipped to its start.
+  profiler->addEvent("test", "clipped", before - 1000000,
+                     Profiler::timestamp() - before + 1000000);
+
+  QJsonObject trace = profiler->stop();
+  QVERIFY(!Profiler::isEnabled());
+  QCOMPARE(spy.count(), 2);
+
+  QJsonArray events = trace["traceEvents"].toArray();
+  QCOMPARE(events.size(), 2);
+
+  QJsonObject scope = events[0].toObject();
+  QCOMPARE(scope["name"].toString(), "scope");
+  QCOMPARE(scope["cat"].toString(), "test");
+  QCOMPARE(scope["ph"].toString(), "X");
+  QVERIFY(scope["ts"].toInteger() >= before);
+  QVERIFY(scope["dur"].toInteger() >= 0);
+  QCOMPARE(spy.at(0).at(0).toJsonObject(), scope);
+
+  QJsonObject clipped = events[1].toObject();
+  QCOMPARE(clipped["name"].toString(), "clipped");
+  QVERIFY(clipped["ts"].toInteger() >= before);
+  QVERIFY(clipped["dur"].toInteger() < 1000000);
+
+  // The next session starts empty.
+  profiler->start();
+  QCOMPARE(profiler->stop()["traceEvents"].toArray().size(), 0);
+}
+
+static TestProfiler s_testProfiler;
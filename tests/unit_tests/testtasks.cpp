@@ -4,6 +4,8 @@
 
 #include "testtasks.h"
 
+#include <QSignalSpy>
+
 #include "settingsholder.h"
 #include "simplenetworkmanager.h"
 #include "tasks/function/taskfunction.h"
@@ -232,4 +234,105 @@ void TestTasks::forceDeleteTasks() {
   QCOMPARE(sequence.at(0), "t3");
 }
 
+namespace {
+class TaskGrouped final : public Task {
+ public:
+  TaskGrouped(const QString& name, const QString& group,
+              Priority priority = Normal)
+      : Task(name), m_group(group), m_priority(priority) {}
+
+  void run() override { QTimer::singleShot(200, this, &Task::completed); }
+
+  QString conflictGroup() const override { return m_group; }
+  Priority priority() const override { return m_priority; }
+
+ private:
+  QString m_group;
+  Priority m_priority;
+};
+}  // namespace
+
+void TestTasks::conflictGroups() {
+  QSignalSpy spy(TaskScheduler::instance(), &TaskScheduler::taskCompleted);
+
+  Task* a1 = new TaskGrouped("a1", "a");
+  Task* a2 = new TaskGrouped("a2", "a");
+  Task* b1 = new TaskGrouped("b1", "b");
+  Task* d1 = new TaskGrouped("d1", QString());
+
+  TaskScheduler::scheduleTask(a1);
+  TaskScheduler::scheduleTask(a2);
+  TaskScheduler::scheduleTask(b1);
+  TaskScheduler::scheduleTask(d1);
+
+  // Different groups run in parallel, the same group in order.
+  QCOMPARE(TaskScheduler::runningTasks(), (QList<Task*>{a1, b1, d1}));
+  QCOMPARE(TaskScheduler::tasks(), QList<Task*>{a2});
+
+  QTRY_COMPARE(spy.count(), 4);
+  QCOMPARE(spy.at(3).at(0).toString(), "a2");
+
+  // a2 has waited for a1.
+  QVERIFY(spy.at(3).at(1).toLongLong() >= 150);
+  for (const QList<QVariant>& args : spy) {
+    QVERIFY(args.at(2).toLongLong() >= 150);
+  }
+}
+
+void TestTasks::priority() {
+  QStringList sequence;
+  QMetaObject::Connection connection =
+      connect(TaskScheduler::instance(), &TaskScheduler::taskCompleted,
+              [&](const QString& name) { sequence.append(name); });
+
+  // Fill all the slots.
+  QList<Task*> busy;
+  for (int i = 0; i < 4; ++i) {
+    busy.append(new TaskGrouped("busy", QString("busy%1").arg(i)));
+    TaskScheduler::scheduleTask(busy.last());
+  }
+  QCOMPARE(TaskScheduler::runningTasks(), busy);
+
+  Task* low = new TaskGrouped("low", "low", Task::Low);
+  Task* normal = new TaskGrouped("normal", "normal");
+  Task* high = new TaskGrouped("high", "high", Task::High);
+  TaskScheduler::scheduleTask(low);
+  TaskScheduler::scheduleTask(normal);
+  TaskScheduler::scheduleTask(high);
+
+  // High priority tasks don't wait for a free slot.
+  QVERIFY(TaskScheduler::runningTasks().contains(high));
+  QCOMPARE(TaskScheduler::tasks(), (QList<Task*>{low, normal}));
+
+  // Then the normal task gets a slot before the low one.
+  QTRY_COMPARE(sequence.length(), 7);
+  QVERIFY(sequence.indexOf("normal") < sequence.indexOf("low"));
+
+  disconnect(connection);
+}
+
+void TestTasks::priorityWithinGroup() {
+  QStringList sequence;
+  QMetaObject::Connection connection =
+      connect(TaskScheduler::instance(), &TaskScheduler::taskCompleted,
+              [&](const QString& name) { sequence.append(name); });
+
+  Task* first = new TaskGrouped("first", "group");
+  Task* normal = new TaskGrouped("normal", "group");
+  Task* high = new TaskGrouped("high", "group", Task::High);
+  TaskScheduler::scheduleTask(first);
+  TaskScheduler::scheduleTask(normal);
+  TaskScheduler::scheduleTask(high);
+
+  // The group is busy: both wait, in the order they were scheduled.
+  QCOMPARE(TaskScheduler::runningTasks(), QList<Task*>{first});
+  QCOMPARE(TaskScheduler::tasks(), (QList<Task*>{normal, high}));
+
+  // Then the high priority task overtakes the normal one.
+  QTRY_COMPARE(sequence.length(), 3);
+  QCOMPARE(sequence, (QStringList{"first", "high", "normal"}));
+
+  disconnect(connection);
+}
+
 static TestTasks s_testTasks;
@@ -16,4 +16,8 @@ class TestTasks final : public TestHelper {
 
   void deleteTasks();
   void forceDeleteTasks();
+
+  void conflictGroups();
+  void priority();
+  void priorityWithinGroup();
 };
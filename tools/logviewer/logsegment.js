@@ -0,0 +1,128 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+// Decoder for the binary log segments written by LogHandler when its binary
+// format is enabled (see src/loghandler.cpp for the layout). Segments are
+// rendered to the same text format as the regular log file.
+//
+// The log viewer uses it when a segment file is opened. It can also be run
+// with node to print segments as text, oldest first:
+//   node logsegment.js mozillavpn.log.1.seg mozillavpn.log.seg
+
+const LogSegment = {
+  MAGIC: 'MZLOGSEG',
+  VERSION: 1,
+  HEADER_SIZE: 12,
+  RECORD_FIXED_SIZE: 14,
+  LEVELS: ['Trace', 'Debug', 'Info', 'Warning', 'Error'],
+
+  isSegment(buffer) {
+    if (buffer.byteLength < this.MAGIC.length) return false;
+    const bytes = new Uint8Array(buffer, 0, this.MAGIC.length);
+    return String.fromCharCode(...bytes) === this.MAGIC;
+  },
+
+  decode(buffer) {
+    if (!this.isSegment(buffer)) {
+      throw new Error('Not a log segment');
+    }
+
+    const view = new DataView(buffer);
+    if (view.byteLength < this.HEADER_SIZE ||
+        view.getUint32(this.MAGIC.length, true) !== this.VERSION) {
+      throw new Error('Unsupported log segment version');
+    }
+
+    const decoder = new TextDecoder('utf-8');
+    let output = '';
+    let pos = this.HEADER_SIZE;
+    while (pos + 4 <= view.byteLength) {
+      const length = view.getUint32(pos, true);
+      pos += 4;
+
+      // A truncated record is what a crash in the middle of a write leaves.
+      if (pos + length > view.byteLength) break;
+
+      const record = this.decodeRecord(view, decoder, pos, pos + length);
+      if (record === null) break;
+
+      output += this.format(record);
+      pos += length;
+    }
+    return output;
+  },
+
+  decodeRecord(view, decoder, pos, end) {
+    if (pos + this.RECORD_FIXED_SIZE > end) return null;
+
+    const record = {
+      timestamp: Number(view.getBigInt64(pos, true)),
+      level: view.getUint8(pos + 8),
+      fromQT: view.getUint8(pos + 9) !== 0,
+      line: view.getInt32(pos + 10, true),
+    };
+    pos += this.RECORD_FIXED_SIZE;
+
+    for (let field of ['className', 'file', 'function', 'message']) {
+      if (pos + 4 > end) return null;
+      const length = view.getUint32(pos, true);
+      pos += 4;
+
+      if (pos + length > end) return null;
+      record[field] = decoder.decode(
+          new Uint8Array(view.buffer, view.byteOffset + pos, length));
+      pos += length;
+    }
+
+    return record;
+  },
+
+  // Mirrors LogHandler::prettyOutput().
+  format(record) {
+    const date = new Date(record.timestamp);
+    const pad = (value, width = 2) => String(value).padStart(width, '0');
+
+    let out = `[${pad(date.getDate())}.${pad(date.getMonth() + 1)}.${
+        date.getFullYear()} ${pad(date.getHours())}:${
+        pad(date.getMinutes())}:${pad(date.getSeconds())}.${
+        pad(date.getMilliseconds(), 3)}] `;
+
+    if (record.className.length > 0) {
+      out += `(${record.className}) `;
+    }
+
+    const level = this.LEVELS[record.level];
+    out += level === undefined ? '?!?: ' : `${level}: `;
+    out += record.message;
+
+    if (record.fromQT &&
+        (record.file.length > 0 || record.function.length > 0)) {
+      out += ' (';
+
+      if (record.file.length > 0) {
+        out += record.file.slice(record.file.lastIndexOf('/') + 1);
+        if (record.line >= 0) out += `:${record.line}`;
+        if (record.function.length > 0) out += ', ';
+      }
+
+      out += record.function;
+      out += ')';
+    }
+
+    return out + '\n';
+  },
+};
+
+if (typeof module !== 'undefined' && module.exports) {
+  module.exports = LogSegment;
+
+  if (require.main === module) {
+    const fs = require('fs');
+    for (let filename of process.argv.slice(2)) {
+      const data = fs.readFileSync(filename);
+      process.stdout.write(LogSegment.decode(data.buffer.slice(
+          data.byteOffset, data.byteOffset + data.byteLength)));
+    }
+  }
+}
@@ -19,8 +19,16 @@ const Logger = {
   async initialize(e) {
     if (e.target.files.length === 0) return;
 
-    const file = e.target.files[0];
-    const content = await file.text();
+    // Binary log segments are decoded to text first. When several files are
+    // selected, the rotated segment sorts before the active one.
+    const files = Array.from(e.target.files)
+                      .sort((a, b) => a.name.localeCompare(b.name));
+    let content = '';
+    for (let file of files) {
+      const buffer = await file.arrayBuffer();
+      content += LogSegment.isSegment(buffer) ? LogSegment.decode(buffer) :
+                                                await file.text();
+    }
 
     let nextLine = LOG;
     for (let line of content.split('\n').map(line => line.trim())) {